@@ -3,7 +3,8 @@
 ResonantGraphSynthEditor::ResonantGraphSynthEditor(ResonantGraphSynthProcessor& p)
     : AudioProcessorEditor(&p),
       processor(p),
-      graphView(p.getGraph()),
+      graphView(p.getGraph(), p.getTelemetry()),
+      profileOverlay(p.getProfiler()),
       keyboard(keyboardState, juce::MidiKeyboardComponent::horizontalKeyboard)
 {
     setSize(800, 700);
@@ -11,9 +12,24 @@ ResonantGraphSynthEditor::ResonantGraphSynthEditor(ResonantGraphSynthProcessor&
     // Graph view
     addAndMakeVisible(graphView);
 
+    // Profiling overlay, over the graph view's corner
+    addChildComponent(profileOverlay);
+    profileButton.setClickingTogglesState(true);
+    profileButton.onClick = [this] {
+        profileOverlay.setVisible(profileButton.getToggleState());
+        profileOverlay.refresh();
+    };
+    addAndMakeVisible(profileButton);
+
+    traceButton.setClickingTogglesState(true);
+    traceButton.setToggleState(p.isTracing(), juce::dontSendNotification);
+    traceButton.onClick = [this] { toggleTrace(); };
+    addAndMakeVisible(traceButton);
+
     // On-screen keyboard
     keyboard.setAvailableRange(48, 84);  // C3 to C6
     addAndMakeVisible(keyboard);
+    keyboardState.addListener(this);
 
     // Damping slider
     dampingSlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
@@ -57,11 +73,33 @@ ResonantGraphSynthEditor::ResonantGraphSynthEditor(ResonantGraphSynthProcessor&
     topologyAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
         processor.parameters, "topology", topologySelector);
 
-    // Start timer for visualization updates
-    startTimerHz(30);
+    // Voices slider
+    voicesSlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
+    voicesSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 60, 20);
+    addAndMakeVisible(voicesSlider);
+    voicesLabel.setText("Voices", juce::dontSendNotification);
+    voicesLabel.setJustificationType(juce::Justification::centred);
+    addAndMakeVisible(voicesLabel);
+    voicesAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        processor.parameters, "voices", voicesSlider);
+
+    // Layout selector
+    layoutSelector.addItem("Octave (12)", 1);
+    layoutSelector.addItem("Piano (88)", 2);
+    layoutSelector.addItem("Full MIDI (128)", 3);
+    addAndMakeVisible(layoutSelector);
+    layoutLabel.setText("Layout", juce::dontSendNotification);
+    layoutLabel.setJustificationType(juce::Justification::centred);
+    addAndMakeVisible(layoutLabel);
+    layoutAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        processor.parameters, "layout", layoutSelector);
+
+    // The graph view paces its own repaints; this refreshes the overlay
+    startTimerHz(10);
 }
 
 ResonantGraphSynthEditor::~ResonantGraphSynthEditor() {
+    keyboardState.removeListener(this);
     stopTimer();
 }
 
@@ -78,14 +116,16 @@ void ResonantGraphSynthEditor::resized() {
     auto bounds = getLocalBounds();
 
     // Top area for title
-    bounds.removeFromTop(50);
+    auto titleArea = bounds.removeFromTop(50);
+    profileButton.setBounds(titleArea.removeFromRight(70).reduced(10, 12));
+    traceButton.setBounds(titleArea.removeFromRight(70).reduced(10, 12));
 
     // Bottom: keyboard
     keyboard.setBounds(bounds.removeFromBottom(80));
 
     // Above keyboard: controls
     auto controlArea = bounds.removeFromBottom(120);
-    int controlWidth = controlArea.getWidth() / 4;
+    int controlWidth = controlArea.getWidth() / 6;
 
     // Control 1: Damping
     auto dampingArea = controlArea.removeFromLeft(controlWidth);
@@ -103,29 +143,53 @@ void ResonantGraphSynthEditor::resized() {
     couplingSlider.setBounds(couplingArea.reduced(10));
 
     // Control 4: Topology
-    auto topologyArea = controlArea;
+    auto topologyArea = controlArea.removeFromLeft(controlWidth);
     topologyLabel.setBounds(topologyArea.removeFromTop(20));
     topologySelector.setBounds(topologyArea.reduced(20, 30));
 
+    // Control 5: Voices
+    auto voicesArea = controlArea.removeFromLeft(controlWidth);
+    voicesLabel.setBounds(voicesArea.removeFromTop(20));
+    voicesSlider.setBounds(voicesArea.reduced(10));
+
+    // Control 6: Layout
+    auto layoutArea = controlArea;
+    layoutLabel.setBounds(layoutArea.removeFromTop(20));
+    layoutSelector.setBounds(layoutArea.reduced(20, 30));
+
     // Graph view takes remaining space
     graphView.setBounds(bounds.reduced(20));
+    profileOverlay.setBounds(graphView.getBounds().removeFromTop(175).removeFromRight(300).reduced(8));
 }
 
-void ResonantGraphSynthEditor::timerCallback() {
-    // Process keyboard events
-    juce::MidiBuffer midiBuffer;
-    keyboardState.processNextMidiBuffer(midiBuffer, 0, 512, true);
-
-    for (const auto metadata : midiBuffer) {
-        auto message = metadata.getMessage();
-        if (message.isNoteOn()) {
-            processor.getGraph().noteOn(message.getNoteNumber(),
-                                        message.getVelocity() / 127.0f);
-        }
-        else if (message.isNoteOff()) {
-            processor.getGraph().noteOff(message.getNoteNumber());
-        }
+void ResonantGraphSynthEditor::handleNoteOn(juce::MidiKeyboardState*, int, int midiNoteNumber, float velocity) {
+    processor.getVoices().post(rgs::GraphCommand::noteOn(midiNoteNumber, velocity));
+}
+
+void ResonantGraphSynthEditor::handleNoteOff(juce::MidiKeyboardState*, int, int midiNoteNumber, float) {
+    processor.getVoices().post(rgs::GraphCommand::noteOff(midiNoteNumber));
+}
+
+void ResonantGraphSynthEditor::toggleTrace() {
+    if (!traceButton.getToggleState()) {
+        processor.stopTrace();
+        return;
     }
 
-    graphView.repaint();
+    auto file = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+                    .getChildFile("ResonantGraphSynth-" + juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S")
+                                  + ".json");
+    juce::String error;
+    if (processor.startTrace(file, error)) {
+        traceButton.setTooltip("Tracing to " + file.getFullPathName());
+    } else {
+        traceButton.setToggleState(false, juce::dontSendNotification);
+        traceButton.setTooltip(error);
+    }
+}
+
+void ResonantGraphSynthEditor::timerCallback() {
+    if (profileOverlay.isVisible()) {
+        profileOverlay.refresh();
+    }
 }
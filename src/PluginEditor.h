@@ -5,9 +5,11 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include "PluginProcessor.h"
 #include "gui/GraphView.h"
+#include "gui/ProfileOverlay.h"
 
 class ResonantGraphSynthEditor : public juce::AudioProcessorEditor,
-                                  private juce::Timer {
+                                  private juce::Timer,
+                                  private juce::MidiKeyboardState::Listener {
 public:
     explicit ResonantGraphSynthEditor(ResonantGraphSynthProcessor&);
     ~ResonantGraphSynthEditor() override;
@@ -18,27 +20,45 @@ public:
 private:
     void timerCallback() override;
 
+    // On-screen keyboard notes go straight to the audio thread's queue
+    void handleNoteOn(juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity) override;
+    void handleNoteOff(juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity) override;
+
     ResonantGraphSynthProcessor& processor;
 
     // Graph visualization
     rgs::GraphView graphView;
 
+    // DSP load overlay, toggled by profileButton
+    rgs::ProfileOverlay profileOverlay;
+    juce::TextButton profileButton { "CPU" };
+
+    // Records a Chrome trace to the documents folder while down
+    juce::TextButton traceButton { "Trace" };
+    void toggleTrace();
+
     // Controls
     juce::Slider dampingSlider;
     juce::Slider brightnessSlider;
     juce::Slider couplingSlider;
+    juce::Slider voicesSlider;
     juce::ComboBox topologySelector;
+    juce::ComboBox layoutSelector;
 
     juce::Label dampingLabel;
     juce::Label brightnessLabel;
     juce::Label couplingLabel;
     juce::Label topologyLabel;
+    juce::Label voicesLabel;
+    juce::Label layoutLabel;
 
     // Parameter attachments
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> dampingAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> brightnessAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> couplingAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> topologyAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> voicesAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> layoutAttachment;
 
     // On-screen keyboard
     juce::MidiKeyboardState keyboardState;
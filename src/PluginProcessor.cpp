@@ -1,14 +1,34 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "core/Presets.h"
 
 ResonantGraphSynthProcessor::ResonantGraphSynthProcessor()
     : AudioProcessor(BusesProperties()
                      .withOutput("Output", juce::AudioChannelSet::stereo(), true)),
       parameters(*this, nullptr, "Parameters", createParameterLayout())
 {
+    noteEvents.reserve(MAX_EVENTS_PER_BLOCK);
+    voices.setTracer(&tracer, 0);
+
+    dampingParam = parameters.getRawParameterValue("damping");
+    brightnessParam = parameters.getRawParameterValue("brightness");
+    couplingParam = parameters.getRawParameterValue("coupling");
+    topologyParam = parameters.getRawParameterValue("topology");
+    voicesParam = parameters.getRawParameterValue("voices");
+    qualityParam = parameters.getRawParameterValue("quality");
+
+    for (auto* id : { "damping", "brightness", "coupling", "topology", "voices", "quality",
+                      "exciter", "hardness", "position", "layout" }) {
+        parameters.addParameterListener(id, this);
+    }
 }
 
 ResonantGraphSynthProcessor::~ResonantGraphSynthProcessor() {
+    for (auto* id : { "damping", "brightness", "coupling", "topology", "voices", "quality",
+                      "exciter", "hardness", "position", "layout" }) {
+        parameters.removeParameterListener(id, this);
+    }
+    cancelPendingUpdate();
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout
@@ -39,9 +59,121 @@ ResonantGraphSynthProcessor::createParameterLayout() {
         1  // Default: Fifths
     ));
 
+    // Strike shape. Changing these rebuilds the excitation tables on the
+    // message thread; notes pick them up a block later.
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        "exciter", "Exciter",
+        juce::StringArray{"Pluck", "Strike"},
+        0  // Default: Pluck
+    ));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        "hardness", "Hardness",
+        juce::NormalisableRange<float>(0.0f, 1.0f),
+        0.5f
+    ));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        "position", "Position",
+        juce::NormalisableRange<float>(0.1f, 0.9f),
+        0.5f
+    ));
+
+    // Polyphony cap; every voice is allocated up front, this only limits
+    // how many are processed at once
+    params.push_back(std::make_unique<juce::AudioParameterInt>(
+        "voices", "Voices", 1, rgs::VoiceManager::MAX_VOICES, 8
+    ));
+
+    // Accuracy of the tanh in the loops and the output stage. Eco is
+    // cheaper and differs by around 1e-4; Reference is for comparisons.
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        "quality", "Quality",
+        juce::StringArray{"Eco", "Normal", "Reference"},
+        1,  // Default: Normal
+        juce::AudioParameterChoiceAttributes().withAutomatable(false)
+    ));
+
+    // Node count changes need a re-prepare, so this is not automatable
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        "layout", "Layout",
+        juce::StringArray{"Octave (12)", "Piano (88)", "Full MIDI (128)"},
+        0,  // Default: one folded octave
+        juce::AudioParameterChoiceAttributes().withAutomatable(false)
+    ));
+
     return {params.begin(), params.end()};
 }
 
+rgs::GraphLayout ResonantGraphSynthProcessor::getLayoutParameter() const {
+    switch (static_cast<int>(*parameters.getRawParameterValue("layout"))) {
+        case 1:  return rgs::GraphLayout::piano();
+        case 2:  return rgs::GraphLayout::fullMidi();
+        default: return rgs::GraphLayout::octave();
+    }
+}
+
+int ResonantGraphSynthProcessor::getLayoutIndex(const rgs::GraphLayout& layout) const {
+    if (layout == rgs::GraphLayout::piano()) {
+        return 1;
+    }
+    return layout == rgs::GraphLayout::fullMidi() ? 2 : 0;
+}
+
+rgs::Topology ResonantGraphSynthProcessor::getTopologyParameter() const {
+    return static_cast<rgs::Topology>(static_cast<int>(topologyParam->load()));
+}
+
+rgs::ExciterSettings ResonantGraphSynthProcessor::getExciterParameters() const {
+    rgs::ExciterSettings settings;
+    settings.type = static_cast<int>(*parameters.getRawParameterValue("exciter")) == 1
+        ? rgs::Exciter::Type::Strike : rgs::Exciter::Type::Pluck;
+    settings.hardness = *parameters.getRawParameterValue("hardness");
+    settings.position = *parameters.getRawParameterValue("position");
+    return settings;
+}
+
+void ResonantGraphSynthProcessor::parameterChanged(const juce::String& parameterID, float) {
+    if (parameterID == "layout" || parameterID == "topology" || parameterID == "exciter"
+        || parameterID == "hardness" || parameterID == "position") {
+        triggerAsyncUpdate();
+    } else {
+        parametersChanged.store(true, std::memory_order_release);
+    }
+}
+
+void ResonantGraphSynthProcessor::applyParameters() {
+    // The graphs ramp damping, brightness and coupling to these targets
+    voices.setDamping(dampingParam->load());
+    voices.setBrightness(brightnessParam->load());
+    voices.setGlobalCoupling(couplingParam->load());
+    voices.setMaxActiveVoices(static_cast<int>(voicesParam->load()));
+    voices.setQuality(static_cast<rgs::fastmath::Quality>(static_cast<int>(qualityParam->load())));
+}
+
+void ResonantGraphSynthProcessor::handleAsyncUpdate() {
+    // Builds the tables and the topology here; the audio thread only
+    // swaps pointers. Both are no-ops when nothing changed.
+    voices.setExciter(getExciterParameters());
+    if (patchChanged.exchange(false)) {
+        const juce::ScopedLock lock(stateLock);
+        voices.setPatch(getTopologyParameter(), patch);
+    } else {
+        voices.setTopology(getTopologyParameter());
+    }
+
+    auto layout = getLayoutParameter();
+    if (layout == getGraph().getLayout()) {
+        return;
+    }
+
+    // Takes the callback lock, so no processBlock runs while we reallocate
+    suspendProcessing(true);
+    double sampleRate = getSampleRate() > 0.0 ? getSampleRate() : 44100.0;
+    voices.prepare(sampleRate, layout, getBlockSize() > 0 ? getBlockSize() : 512);
+    suspendProcessing(false);
+}
+
 const juce::String ResonantGraphSynthProcessor::getName() const {
     return "Resonant Graph Synth";
 }
@@ -49,20 +181,61 @@ const juce::String ResonantGraphSynthProcessor::getName() const {
 bool ResonantGraphSynthProcessor::acceptsMidi() const { return true; }
 bool ResonantGraphSynthProcessor::producesMidi() const { return false; }
 bool ResonantGraphSynthProcessor::isMidiEffect() const { return false; }
-double ResonantGraphSynthProcessor::getTailLengthSeconds() const { return 2.0; }
+double ResonantGraphSynthProcessor::getTailLengthSeconds() const { return voices.getTailSeconds(); }
+
+int ResonantGraphSynthProcessor::getNumPrograms() { return rgs::presets::getNumPresets(); }
+int ResonantGraphSynthProcessor::getCurrentProgram() { return currentProgram; }
+
+void ResonantGraphSynthProcessor::setCurrentProgram(int index) {
+    // On the current layout, so sounding notes carry over instead of the
+    // voices being re-prepared
+    rgs::SynthState state;
+    if (rgs::presets::makePreset(index, getLayoutParameter(), state)) {
+        currentProgram = index;
+        applyState(state);
+    }
+}
+
+const juce::String ResonantGraphSynthProcessor::getProgramName(int index) {
+    return rgs::presets::getPresetName(index);
+}
 
-int ResonantGraphSynthProcessor::getNumPrograms() { return 1; }
-int ResonantGraphSynthProcessor::getCurrentProgram() { return 0; }
-void ResonantGraphSynthProcessor::setCurrentProgram(int) {}
-const juce::String ResonantGraphSynthProcessor::getProgramName(int) { return {}; }
 void ResonantGraphSynthProcessor::changeProgramName(int, const juce::String&) {}
 
 void ResonantGraphSynthProcessor::prepareToPlay(double sampleRate, int samplesPerBlock) {
-    graph.prepare(sampleRate);
+    // Start from the current parameter values instead of gliding to them
+    parametersChanged.store(false);
+    applyParameters();
+    voices.setExciter(getExciterParameters());
+    {
+        const juce::ScopedLock lock(stateLock);
+        patchChanged.store(false);
+        voices.setPatch(getTopologyParameter(), patch);
+    }
+    voices.prepare(sampleRate, getLayoutParameter(), samplesPerBlock);
+    telemetry.prepare(sampleRate);
+    profiler.prepare(sampleRate);
+    tracer.setTrack(0, getName().toStdString(), sampleRate);
+
+    // Standalone, the synth has the cores to itself; inside a host the
+    // workers would compete with the host's own threads
+    if (wrapperType == wrapperType_Standalone && workers == nullptr) {
+        workers = std::make_unique<rgs::WorkerPool>(juce::SystemStats::getNumCpus());
+        voices.setWorkerPool(workers.get());
+    }
+}
+
+bool ResonantGraphSynthProcessor::startTrace(const juce::File& file, juce::String& error) {
+    std::string reason;
+    if (!tracer.start(file.getFullPathName().toStdString(), reason)) {
+        error = reason;
+        return false;
+    }
+    return true;
 }
 
 void ResonantGraphSynthProcessor::releaseResources() {
-    graph.reset();
+    voices.reset();
 }
 
 bool ResonantGraphSynthProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const {
@@ -75,38 +248,75 @@ void ResonantGraphSynthProcessor::processBlock(juce::AudioBuffer<float>& buffer,
                                                 juce::MidiBuffer& midiMessages) {
     juce::ScopedNoDenormals noDenormals;
 
-    // Update parameters
-    float damping = *parameters.getRawParameterValue("damping");
-    float brightness = *parameters.getRawParameterValue("brightness");
-    float coupling = *parameters.getRawParameterValue("coupling");
-    int topology = static_cast<int>(*parameters.getRawParameterValue("topology"));
+    rgs::profiling::PhaseTimes phases;
+    rgs::profiling::PhaseTimer timer(phases);
+    timer.start();
 
-    graph.setDamping(damping);
-    graph.setBrightness(brightness);
-    graph.setGlobalCoupling(coupling);
-    graph.setTopology(static_cast<rgs::Topology>(topology));
+    const bool tracing = tracer.isRecording();
+    const uint64_t blockStart = tracing ? rgs::profiling::now() : 0;
 
-    // Handle MIDI
+    // Update parameters, only when a listener saw them move
+    if (parametersChanged.exchange(false, std::memory_order_acquire)) {
+        applyParameters();
+    }
+
+    // Collect MIDI as timestamped events; the voices apply each one on
+    // its own sample instead of at the start of the block
+    noteEvents.clear();
     for (const auto metadata : midiMessages) {
+        if (noteEvents.size() == noteEvents.capacity()) {
+            break;
+        }
+
         auto message = metadata.getMessage();
 
         if (message.isNoteOn()) {
-            graph.noteOn(message.getNoteNumber(),
-                        message.getVelocity() / 127.0f);
+            noteEvents.push_back(rgs::NoteEvent::noteOn(metadata.samplePosition,
+                                                        message.getNoteNumber(),
+                                                        message.getVelocity() / 127.0f));
         }
         else if (message.isNoteOff()) {
-            graph.noteOff(message.getNoteNumber());
+            noteEvents.push_back(rgs::NoteEvent::noteOff(metadata.samplePosition,
+                                                         message.getNoteNumber()));
         }
     }
 
+    timer.lap(rgs::profiling::Phase::Midi);
+
     // Clear buffer
     buffer.clear();
 
     // Process audio
     auto* leftChannel = buffer.getWritePointer(0);
     auto* rightChannel = buffer.getWritePointer(1);
+    timer.lap(rgs::profiling::Phase::Output);
 
-    graph.processBlock(leftChannel, rightChannel, buffer.getNumSamples());
+    voices.processBlock(leftChannel, rightChannel, buffer.getNumSamples(),
+                        noteEvents.data(), static_cast<int>(noteEvents.size()));
+    timer.skip();
+
+    telemetry.publish(getGraph(), voices.getEnergies(), leftChannel, rightChannel,
+                      buffer.getNumSamples());
+    timer.lap(rgs::profiling::Phase::Telemetry);
+    timer.total(rgs::profiling::Phase::Block);
+
+    phases.add(voices.getPhaseTimes());
+    profiler.record(phases, buffer.getNumSamples());
+
+    if (tracing) {
+        rgs::profiling::TraceRecord record;
+        record.type = rgs::profiling::TraceRecord::Type::Callback;
+        record.a = buffer.getNumSamples();
+        record.b = static_cast<int>(noteEvents.size());
+        record.c = voices.getNumActiveVoices();
+        for (int v = 0; v < voices.getNumVoices(); v++) {
+            record.d += voices.getVoice(v).getNumAwakeNodes();
+        }
+        record.start = blockStart;
+        record.end = rgs::profiling::now();
+        record.setPhases(phases);
+        tracer.record(record);
+    }
 }
 
 bool ResonantGraphSynthProcessor::hasEditor() const { return true; }
@@ -116,12 +326,34 @@ juce::AudioProcessorEditor* ResonantGraphSynthProcessor::createEditor() {
 }
 
 void ResonantGraphSynthProcessor::getStateInformation(juce::MemoryBlock& destData) {
-    auto state = parameters.copyState();
-    std::unique_ptr<juce::XmlElement> xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
+    const juce::ScopedLock lock(stateLock);
+
+    rgs::SynthState state;
+    state.damping = dampingParam->load();
+    state.brightness = brightnessParam->load();
+    state.coupling = couplingParam->load();
+    state.topology = getTopologyParameter();
+    state.exciter = getExciterParameters();
+    state.voices = static_cast<int>(voicesParam->load());
+    state.quality = static_cast<rgs::fastmath::Quality>(static_cast<int>(qualityParam->load()));
+    state.layout = getLayoutParameter();
+    state.patch = patch;
+
+    state.write(blob);
+    destData.replaceAll(blob.data(), blob.size());
 }
 
 void ResonantGraphSynthProcessor::setStateInformation(const void* data, int sizeInBytes) {
+    const auto size = static_cast<size_t>(std::max(sizeInBytes, 0));
+    if (rgs::SynthState::isState(data, size)) {
+        const juce::ScopedLock lock(stateLock);
+        if (incoming.read(data, size)) {
+            applyState(incoming);
+        }
+        return;
+    }
+
+    // Sessions saved before the binary state: the parameters as XML
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
     if (xmlState != nullptr) {
         if (xmlState->hasTagName(parameters.state.getType())) {
@@ -130,6 +362,30 @@ void ResonantGraphSynthProcessor::setStateInformation(const void* data, int size
     }
 }
 
+void ResonantGraphSynthProcessor::applyState(const rgs::SynthState& state) {
+    auto set = [this](const char* id, float value) {
+        auto* parameter = parameters.getParameter(id);
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    };
+    set("damping", state.damping);
+    set("brightness", state.brightness);
+    set("coupling", state.coupling);
+    set("topology", static_cast<float>(static_cast<int>(state.topology)));
+    set("exciter", state.exciter.type == rgs::Exciter::Type::Strike ? 1.0f : 0.0f);
+    set("hardness", state.exciter.hardness);
+    set("position", state.exciter.position);
+    set("voices", static_cast<float>(state.voices));
+    set("quality", static_cast<float>(static_cast<int>(state.quality)));
+    set("layout", static_cast<float>(getLayoutIndex(state.layout)));
+
+    {
+        const juce::ScopedLock lock(stateLock);
+        patch = state.patch;
+    }
+    patchChanged.store(true);
+    triggerAsyncUpdate();
+}
+
 // Plugin instantiation
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter() {
     return new ResonantGraphSynthProcessor();
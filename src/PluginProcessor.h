@@ -1,9 +1,17 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
+#include "core/Profiler.h"
 #include "core/ResonatorGraph.h"
+#include "core/SynthState.h"
+#include "core/Telemetry.h"
+#include "core/Trace.h"
+#include "core/VoiceManager.h"
+#include "core/WorkerPool.h"
 
-class ResonantGraphSynthProcessor : public juce::AudioProcessor {
+class ResonantGraphSynthProcessor : public juce::AudioProcessor,
+                                    private juce::AudioProcessorValueTreeState::Listener,
+                                    private juce::AsyncUpdater {
 public:
     ResonantGraphSynthProcessor();
     ~ResonantGraphSynthProcessor() override;
@@ -34,16 +42,79 @@ public:
     void getStateInformation(juce::MemoryBlock& destData) override;
     void setStateInformation(const void* data, int sizeInBytes) override;
 
-    // Access to graph for editor
-    rgs::ResonatorGraph& getGraph() { return graph; }
+    // Voice pool; notes and edits from the editor go through its post()
+    rgs::VoiceManager& getVoices() { return voices; }
+
+    // Layout and topology shared by every voice, for display
+    const rgs::ResonatorGraph& getGraph() const { return voices.getVoice(0); }
+
+    // Per-block engine snapshots for the editor and other observers
+    const rgs::TelemetryChannel& getTelemetry() const { return telemetry; }
+
+    // Per-phase processBlock timings (RGS_PROFILING builds), for the
+    // editor's overlay
+    rgs::profiling::Profiler& getProfiler() { return profiler; }
+
+    // Timeline trace of blocks, notes and voices to a Chrome trace JSON
+    // file (see Trace.h). Message thread.
+    bool startTrace(const juce::File& file, juce::String& error);
+    void stopTrace() { tracer.stop(); }
+    bool isTracing() const { return tracer.isRecording(); }
 
     // Parameters
     juce::AudioProcessorValueTreeState parameters;
 
 private:
-    rgs::ResonatorGraph graph;
+    // Note events per block beyond this are dropped rather than allocating
+    static constexpr int MAX_EVENTS_PER_BLOCK = 2048;
+
+    // Standalone only: renders voices in parallel
+    std::unique_ptr<rgs::WorkerPool> workers;
+
+    // Outlives the voices, which record into it
+    rgs::profiling::Tracer tracer;
+
+    rgs::VoiceManager voices;
+    rgs::TelemetryChannel telemetry;
+    rgs::profiling::Profiler profiler;
+    std::vector<rgs::NoteEvent> noteEvents;
 
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+    rgs::GraphLayout getLayoutParameter() const;
+    int getLayoutIndex(const rgs::GraphLayout& layout) const;
+    rgs::Topology getTopologyParameter() const;
+    rgs::ExciterSettings getExciterParameters() const;
+
+    // Sound parameters, pushed to the graph only after they change
+    std::atomic<float>* dampingParam = nullptr;
+    std::atomic<float>* brightnessParam = nullptr;
+    std::atomic<float>* couplingParam = nullptr;
+    std::atomic<float>* topologyParam = nullptr;
+    std::atomic<float>* voicesParam = nullptr;
+    std::atomic<float>* qualityParam = nullptr;
+    std::atomic<bool> parametersChanged { true };
+    void applyParameters();
+
+    // Sound parameter changes set parametersChanged. Layout changes
+    // reallocate the graph, so they are applied on the message thread
+    // with processing suspended; exciter and topology changes compile
+    // the excitation tables and the coupling there too.
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+    void handleAsyncUpdate() override;
+
+    // What a state holds beyond the parameters, under stateLock. Set from
+    // a saved state or a program; handleAsyncUpdate() hands it to the
+    // voices when patchChanged.
+    juce::CriticalSection stateLock;
+    rgs::SynthPatch patch;
+    std::atomic<bool> patchChanged { false };
+    rgs::SynthState incoming;     // setStateInformation() scratch
+    std::vector<uint8_t> blob;    // getStateInformation() scratch
+    int currentProgram = 0;
+
+    // Set every parameter and the patch from state; the voices follow on
+    // the message thread, crossfading where they can
+    void applyState(const rgs::SynthState& state);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ResonantGraphSynthProcessor)
 };
@@ -0,0 +1,1245 @@
+/**
+ * rgs_bench: offline render benchmark for the DSP core
+ *
+ * Renders fixed scenarios through ResonatorGraph::processBlock without a
+ * host and prints per-scenario timings as JSON on stdout:
+ * - nsPerSample: wall time per rendered sample frame
+ * - realtimeFactor: audio seconds rendered per wall second
+ * - blockNs: p50 / p99 / max time of a single processBlock call
+ * - strikeBlockNs: p50 / max over only the blocks with note-ons, which
+ *   are too rare to show in the p99
+ *
+ * --verify renders every scenario through the scalar reference engine and
+ * the chosen SIMD engine (simd, or the sub-block schedule with
+ * --engine block) in lockstep and reports the largest output deviation.
+ * --engine multirate and --engine modal are compared by level instead
+ * (see LevelMatch), and modal's single note also partial by partial
+ * (see PartialMatch).
+ *
+ * --voices N renders through a VoiceManager with N voices instead of a
+ * single graph (idle voices are free, so the load decides the cost).
+ *
+ * --decay strikes C4 once into every topology at the default settings,
+ * and again at full coupling, and fails unless the graph is asleep within
+ * getTailSeconds() plus DECAY_MARGIN: coupling must let a note die away,
+ * not hold it up. With --voices N it renders through a VoiceManager and
+ * waits for every voice to go idle instead, which is what frees them for
+ * the next notes without a steal.
+ *
+ * --quality eco|normal|reference|all picks the fastmath tier the engine
+ * runs at. --accuracy instead checks every fastmath function against
+ * libm over its range and times it; it fails when an error exceeds the
+ * bound documented in FastMath.h.
+ *
+ * --exciter pluck|strike and --hardness H pick the excitation tables
+ * note-ons strike with (default: ExcitationTable::standard()).
+ *
+ * --threads N|scaling spreads Engine::Block over a WorkerPool of N
+ * threads (scaling: 1, 2, 4, 8 and 16, one scenario each), or with
+ * --voices the voices, whatever the engine. Each result
+ * then carries its speedup over the same scenario on one thread, and
+ * the threads the pool really started (no more than the hardware has;
+ * 1 when its workers could not get realtime scheduling, which the engine
+ * requires before it uses them).
+ * --layout grid is the 512-node worst case: 72 steps per octave from A0.
+ *
+ * Built with RGS_PROFILING (Debug, or -DRGS_PROFILING=ON), each result
+ * also carries "profile": Profiler::dumpJson() for its blocks, with time
+ * per processing phase.
+ *
+ * --trace FILE writes a Chrome trace of every timed block (Trace.h), one
+ * process per scenario: open it in ui.perfetto.dev to find the blocks
+ * behind a p99.
+ *
+ * Usage: rgs_bench [--quick] [--seconds S] [--filter TEXT] [--out FILE]
+ *                  [--engine scalar|simd|block|multirate|modal|all] [--isa scalar|sse2|avx2|avx512]
+ *                  [--layout octave|piano|midi|grid|all] [--voices N] [--verify]
+ *                  [--quality eco|normal|reference|all] [--accuracy] [--decay]
+ *                  [--exciter pluck|strike] [--hardness H] [--threads N|scaling]
+ *                  [--trace FILE]
+ */
+
+#include "core/Denormals.h"
+#include "core/ExcitationTable.h"
+#include "core/FastMath.h"
+#include "core/ModalBank.h"
+#include "core/Profiler.h"
+#include "core/ResonatorGraph.h"
+#include "core/Telemetry.h"
+#include "core/Trace.h"
+#include "core/VoiceManager.h"
+#include "core/WorkerPool.h"
+#include "core/simd/CpuFeatures.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+enum class Load {
+    SingleNote,  // One note re-struck every half second
+    DenseChord,  // Ten-note two-octave chord re-struck every quarter second
+    Burst,       // 48 notes from A0 in one instant every quarter second
+    Silent       // No notes: the cost of an idle instance
+};
+
+// Max abs output difference accepted between an engine and the scalar
+// libm reference (Quality::Reference), whatever quality the engine runs at
+constexpr double VERIFY_TOLERANCE = 1e-4;
+
+// Engine::MultiRate filters and delays its low nodes, so it is held to
+// the reference's level instead: the largest difference in dB between
+// the RMS of LEVEL_WINDOW windows, over windows above LEVEL_FLOOR. Both
+// render uncoupled: added coupling latency alone moves how the denser
+// topologies build up by several dB, even in Engine::Simd.
+constexpr double LEVEL_TOLERANCE_DB = 3.0;
+constexpr double LEVEL_WINDOW = 0.05;   // Seconds
+constexpr double LEVEL_FLOOR = 1e-3;    // -60 dBFS
+
+// Engine::Modal is held to the same level match, looser and per load:
+// its modes stop at the 8th harmonic, so whatever the exciter puts above
+// that is lost, more the brighter the exciter and the lower the note.
+// Worst windows today over every --exciter and --hardness, layout and
+// rate: 4.8 dB for C4 (hard pluck), 11.5 dB for the chord down to C3
+// (hard strike) and 15.3 dB for the burst from A0 (hard pluck; A0 alone
+// starts ~14 dB quieter). The default pluck: 3.8, 5.4 and 13.6 dB.
+constexpr double MODAL_SINGLE_TOLERANCE_DB = 5.5;
+constexpr double MODAL_CHORD_TOLERANCE_DB = 12.0;
+constexpr double MODAL_BURST_TOLERANCE_DB = 16.0;
+
+// Engine::Modal's single note (C4) is also held to the reference partial
+// by partial: Hann-windowed peaks of harmonics 1-8 over PARTIAL_WINDOW
+// from PARTIAL_SKIP after the strike, each within PARTIAL_CENTS_TOLERANCE
+// and PARTIAL_DB_TOLERANCE of the reference's. Only partials within
+// PARTIAL_RANGE_DB of the reference's strongest count: weaker ones sit
+// in the notches the strike position cuts, where two nearly equal
+// spectra differ by 10 dB or more. Today's worst is 2.5 dB with the
+// default pluck and 4.7 dB with a soft strike (--exciter strike
+// --hardness 0), and 2.1 cents (C4 at 44.1-192 kHz). The pitch error
+// grows with f0 / fs, the modes being tuned to exact harmonics and the
+// loop to its interpolated delay (C6 at 44.1 kHz is ~8 cents flat).
+constexpr int PARTIAL_NOTE = 60;
+constexpr double PARTIAL_SKIP = 0.05;     // Seconds
+constexpr double PARTIAL_WINDOW = 0.4;    // Seconds, before the next strike
+constexpr double PARTIAL_RANGE_DB = 20.0;
+constexpr double PARTIAL_DB_TOLERANCE = 5.0;
+constexpr double PARTIAL_CENTS_TOLERANCE = 3.0;
+
+// --decay: seconds past ResonatorGraph::getTailSeconds() a struck note
+// may take to put the graph to sleep
+constexpr double DECAY_MARGIN = 1.0;
+constexpr float DECAY_COUPLINGS[] = { 0.3f, 1.0f };   // The default, and full
+
+double toleranceFor(rgs::Engine engine, Load load) {
+    switch (engine) {
+        case rgs::Engine::MultiRate: return LEVEL_TOLERANCE_DB;
+        case rgs::Engine::Modal:
+            switch (load) {
+                case Load::DenseChord: return MODAL_CHORD_TOLERANCE_DB;
+                case Load::Burst:      return MODAL_BURST_TOLERANCE_DB;
+                case Load::SingleNote:
+                case Load::Silent:     return MODAL_SINGLE_TOLERANCE_DB;
+            }
+            break;
+        case rgs::Engine::Scalar:
+        case rgs::Engine::Simd:
+        case rgs::Engine::Block:     break;
+    }
+    return VERIFY_TOLERANCE;
+}
+
+struct LayoutChoice {
+    const char* name;
+    rgs::GraphLayout layout;
+};
+
+const LayoutChoice LAYOUTS[] = {
+    { "octave", rgs::GraphLayout::octave() },
+    { "piano88", rgs::GraphLayout::piano() },
+    { "midi128", rgs::GraphLayout::fullMidi() },
+    { "grid512", rgs::GraphLayout::grid(21, 512, 72) }
+};
+
+struct Scenario {
+    std::string name;
+    LayoutChoice layout;
+    rgs::Engine engine;
+    rgs::fastmath::Quality quality;
+    int voices;              // 0: one ResonatorGraph
+    int threads;             // WorkerPool size: voices, or Engine::Block
+    int baseline;            // Index of the one-thread run, or -1
+    rgs::ExciterSettings exciter;
+    Load load;
+    rgs::Topology topology;
+    double sampleRate;
+    int blockSize;
+};
+
+struct Result {
+    double nsPerSample = 0.0;
+    double realtimeFactor = 0.0;
+    double p50 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+    double strikeP50 = 0.0;
+    double strikeMax = 0.0;
+    double deadlineNs = 0.0;
+    int overruns = 0;
+    int blocks = 0;
+    int edges = 0;
+    int nodes = 0;
+    int peakVoices = 0;
+    int threads = 1;
+    double maxDeviation = 0.0;  // --verify only (dB for Engine::MultiRate and Modal)
+    bool partials = false;      // --verify, Engine::Modal single note: PartialMatch ran
+    double partialDb = 0.0;
+    double partialCents = 0.0;
+    std::string profile;        // Profiler::dumpJson(), RGS_PROFILING builds only
+};
+
+struct Options {
+    double seconds = 1.0;
+    bool quick = false;
+    bool verify = false;
+    bool accuracy = false;
+    bool decay = false;
+    std::vector<rgs::Engine> engines = { rgs::Engine::Simd };
+    std::vector<rgs::fastmath::Quality> qualities = { rgs::fastmath::Quality::Normal };
+    std::vector<LayoutChoice> layouts = { LAYOUTS[0] };
+    int voices = 0;
+    std::vector<int> threads = { 1 };
+    rgs::ExciterSettings exciter;
+    std::string filter;
+    std::string outPath;
+    std::string tracePath;
+};
+
+const char* engineName(rgs::Engine engine) {
+    switch (engine) {
+        case rgs::Engine::Scalar: return "scalar";
+        case rgs::Engine::Simd:   return "simd";
+        case rgs::Engine::Block:  return "block";
+        case rgs::Engine::MultiRate: return "multirate";
+        case rgs::Engine::Modal:  return "modal";
+    }
+    return "?";
+}
+
+const char* qualityName(rgs::fastmath::Quality quality) {
+    switch (quality) {
+        case rgs::fastmath::Quality::Eco:       return "eco";
+        case rgs::fastmath::Quality::Normal:    return "normal";
+        case rgs::fastmath::Quality::Reference: return "reference";
+    }
+    return "?";
+}
+
+const char* topologyName(rgs::Topology topo) {
+    switch (topo) {
+        case rgs::Topology::Chromatic: return "chromatic";
+        case rgs::Topology::Fifths:    return "fifths";
+        case rgs::Topology::Tonnetz:   return "tonnetz";
+        case rgs::Topology::Harmonic:  return "harmonic";
+        case rgs::Topology::Custom:    return "custom";
+    }
+    return "unknown";
+}
+
+const char* loadName(Load load) {
+    switch (load) {
+        case Load::SingleNote: return "single";
+        case Load::DenseChord: return "chord";
+        case Load::Burst:      return "burst";
+        case Load::Silent:     return "silent";
+    }
+    return "unknown";
+}
+
+std::vector<Scenario> buildScenarios(const Options& options) {
+    const Load loads[] = { Load::SingleNote, Load::DenseChord, Load::Burst, Load::Silent };
+    const rgs::Topology topologies[] = {
+        rgs::Topology::Chromatic, rgs::Topology::Fifths,
+        rgs::Topology::Tonnetz, rgs::Topology::Harmonic
+    };
+
+    std::vector<double> rates = { 44100.0, 96000.0, 192000.0 };
+    std::vector<int> blocks = { 32, 64, 128, 256, 512, 1024, 2048 };
+    if (options.quick) {
+        rates = { 48000.0 };
+        blocks = { 64, 512 };
+    }
+
+    // Verification runs the scalar reference inside each scenario
+    std::vector<rgs::Engine> engines = options.engines;
+    if (options.verify) {
+        engines.erase(std::remove(engines.begin(), engines.end(), rgs::Engine::Scalar), engines.end());
+        if (engines.empty()) {
+            engines = { rgs::Engine::Simd };
+        }
+    }
+
+    std::vector<Scenario> scenarios;
+    for (const auto& layout : options.layouts) {
+        for (auto engine : engines) {
+            // Voices render on a pool, and a single graph's sub-block schedule
+            const bool pooled = options.voices > 0 || engine == rgs::Engine::Block;
+            const std::vector<int> threadCounts = pooled ? options.threads : std::vector<int> { 1 };
+
+            for (auto quality : options.qualities) {
+                for (auto load : loads) {
+                    for (auto topo : topologies) {
+                        for (double rate : rates) {
+                            for (int block : blocks) {
+                                int baseline = -1;
+                                for (int threads : threadCounts) {
+                                    Scenario s;
+                                    s.layout = layout;
+                                    s.engine = engine;
+                                    s.quality = quality;
+                                    s.voices = options.voices;
+                                    s.threads = threads;
+                                    s.baseline = threads > 1 ? baseline : -1;
+                                    s.exciter = options.exciter;
+                                    s.load = load;
+                                    s.topology = topo;
+                                    s.sampleRate = rate;
+                                    s.blockSize = block;
+                                    s.name = std::string(layout.name) + "/" + engineName(engine) + "/"
+                                           + (threads > 1 ? "t" + std::to_string(threads) + "/" : "")
+                                           + (quality != rgs::fastmath::Quality::Normal
+                                                  ? std::string(qualityName(quality)) + "/" : "")
+                                           + (s.voices > 0 ? "v" + std::to_string(s.voices) + "/" : "")
+                                           + loadName(load) + "/" + topologyName(topo) + "/"
+                                           + std::to_string(static_cast<int>(rate)) + "/"
+                                           + std::to_string(block);
+
+                                    if (options.filter.empty() || s.name.find(options.filter) != std::string::npos) {
+                                        if (threads == 1) {
+                                            baseline = static_cast<int>(scenarios.size());
+                                        }
+                                        scenarios.push_back(s);
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return scenarios;
+}
+
+long long strikeInterval(const Scenario& scenario) {
+    return static_cast<long long>(
+        scenario.sampleRate * (scenario.load == Load::SingleNote ? 0.5 : 0.25));
+}
+
+// Note-ons due inside [blockStart, blockStart + blockSize), at their exact offsets
+void collectStrikes(const Scenario& scenario, long long blockStart, int blockSize,
+                    long long& nextStrike, std::vector<rgs::NoteEvent>& events) {
+    static const int CHORD[] = { 48, 52, 55, 60, 64, 67, 70, 72, 76, 79 };
+
+    events.clear();
+    if (scenario.load == Load::Silent) {
+        return;
+    }
+    while (nextStrike < blockStart + blockSize) {
+        int offset = static_cast<int>(nextStrike - blockStart);
+        if (scenario.load == Load::SingleNote) {
+            events.push_back(rgs::NoteEvent::noteOn(offset, PARTIAL_NOTE, 0.8f));
+        } else if (scenario.load == Load::Burst) {
+            // The longest loops, all struck in one block: the worst case
+            // for note-on cost (strikeBlockNs)
+            for (int note = 21; note < 21 + 48; note++) {
+                events.push_back(rgs::NoteEvent::noteOn(offset, note, 0.6f));
+            }
+        } else {
+            for (int note : CHORD) {
+                events.push_back(rgs::NoteEvent::noteOn(offset, note, 0.7f));
+            }
+        }
+        nextStrike += strikeInterval(scenario);
+    }
+}
+
+double percentile(std::vector<double> sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    std::sort(sorted.begin(), sorted.end());
+    auto index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// A single graph or a voice pool, whichever the scenario asks for
+class Synth {
+public:
+    Synth(const Scenario& scenario, rgs::Engine engine, rgs::fastmath::Quality quality) {
+        if (scenario.voices > 0) {
+            voices = std::make_unique<rgs::VoiceManager>();
+            voices->setEngine(engine);
+            voices->setQuality(quality);
+            voices->setTopology(scenario.topology);
+            voices->setExciter(scenario.exciter);
+            voices->prepare(scenario.sampleRate, scenario.layout.layout, scenario.blockSize,
+                            scenario.voices);
+            voices->setMaxActiveVoices(scenario.voices);
+            if (scenario.threads > 1) {
+                pool = std::make_unique<rgs::WorkerPool>(scenario.threads);
+                voices->setWorkerPool(pool.get());
+            }
+        } else {
+            single = std::make_unique<rgs::ResonatorGraph>();
+            single->setEngine(engine);
+            if (scenario.threads > 1) {
+                pool = std::make_unique<rgs::WorkerPool>(scenario.threads);
+                single->setWorkerPool(pool.get());
+            }
+            single->setQuality(quality);
+            single->setTopology(scenario.topology);
+            if (scenario.exciter != rgs::ExciterSettings{}) {
+                table = std::make_unique<rgs::ExcitationTable>(scenario.exciter);
+                single->setExcitation(table.get());
+            }
+            single->prepare(scenario.sampleRate, scenario.layout.layout);
+        }
+    }
+
+    void process(float* left, float* right, int numSamples,
+                 const std::vector<rgs::NoteEvent>& events) {
+        const int numEvents = static_cast<int>(events.size());
+        if (voices != nullptr) {
+            voices->processBlock(left, right, numSamples, events.data(), numEvents);
+        } else {
+            single->processBlock(left, right, numSamples, events.data(), numEvents);
+        }
+    }
+
+    void setTracer(rgs::profiling::Tracer* tracer, int track) {
+        if (voices != nullptr) {
+            voices->setTracer(tracer, track);
+        } else {
+            single->setTracer(tracer, track, 0);
+        }
+    }
+
+    void setGlobalCoupling(float amount) {
+        if (voices != nullptr) {
+            voices->setGlobalCoupling(amount);
+        } else {
+            single->setGlobalCoupling(amount);
+        }
+    }
+
+    void reset() {
+        if (voices != nullptr) {
+            voices->reset();
+        } else {
+            single->reset();
+        }
+    }
+
+    const rgs::ResonatorGraph& graph() const { return voices != nullptr ? voices->getVoice(0) : *single; }
+    const float* energies() const { return voices != nullptr ? voices->getEnergies() : single->getEnergies(); }
+    int threads() const { return pool != nullptr && pool->isRealtime() ? pool->getNumThreads() : 1; }
+    const rgs::profiling::PhaseTimes& phaseTimes() const {
+        return voices != nullptr ? voices->getPhaseTimes() : single->getPhaseTimes();
+    }
+    int activeVoices() const { return voices != nullptr ? voices->getNumActiveVoices() : 1; }
+    bool isAsleep() const { return voices != nullptr ? voices->getNumActiveVoices() == 0 : single->isAsleep(); }
+    double tailSeconds() const { return voices != nullptr ? voices->getTailSeconds() : single->getTailSeconds(); }
+    int awakeNodes() const {
+        if (single != nullptr) {
+            return single->getNumAwakeNodes();
+        }
+        int nodes = 0;
+        for (int v = 0; v < voices->getNumVoices(); v++) {
+            nodes += voices->getVoice(v).getNumAwakeNodes();
+        }
+        return nodes;
+    }
+
+private:
+    std::unique_ptr<rgs::ExcitationTable> table;   // For single, outlives it
+    std::unique_ptr<rgs::WorkerPool> pool;         // Outlives both
+    std::unique_ptr<rgs::ResonatorGraph> single;
+    std::unique_ptr<rgs::VoiceManager> voices;
+};
+
+// tracer, when given and recording, sees every timed block on track
+Result run(const Scenario& scenario, const Options& options,
+           rgs::profiling::Tracer* tracer = nullptr, int track = 0) {
+    Synth synth(scenario, scenario.engine, scenario.quality);
+
+    // Published every block, as the plugin does for its editor
+    rgs::TelemetryChannel telemetry;
+    telemetry.prepare(scenario.sampleRate);
+
+    rgs::profiling::Profiler profiler;
+    profiler.prepare(scenario.sampleRate);
+
+    const int blockSize = scenario.blockSize;
+    const auto totalSamples = static_cast<long long>(options.seconds * scenario.sampleRate);
+    const int numBlocks = static_cast<int>((totalSamples + blockSize - 1) / blockSize);
+
+    std::vector<float> left(static_cast<size_t>(blockSize));
+    std::vector<float> right(static_cast<size_t>(blockSize));
+    std::vector<double> blockTimes;
+    blockTimes.reserve(static_cast<size_t>(numBlocks));
+    std::vector<double> strikeTimes;
+    std::vector<rgs::NoteEvent> events;
+    events.reserve(256);
+
+    // Warm caches and branch predictors before timing
+    long long warmStrike = 0;
+    for (int i = 0; i < 8; i++) {
+        collectStrikes(scenario, 0, blockSize, warmStrike, events);
+        synth.process(left.data(), right.data(), blockSize, events);
+    }
+    synth.reset();
+
+    const bool tracing = tracer != nullptr && tracer->isRecording();
+    if (tracing) {
+        tracer->setTrack(track, scenario.name, scenario.sampleRate);
+        synth.setTracer(tracer, track);
+    }
+
+    long long samplePos = 0;
+    long long nextStrike = 0;
+    double totalNs = 0.0;
+    int peakVoices = 0;
+
+    for (int b = 0; b < numBlocks; b++) {
+        collectStrikes(scenario, samplePos, blockSize, nextStrike, events);
+
+        rgs::profiling::PhaseTimes phases;
+        rgs::profiling::PhaseTimer timer(phases);
+
+        auto start = Clock::now();
+        const uint64_t startTicks = tracing ? rgs::profiling::now() : 0;
+        timer.start();
+        synth.process(left.data(), right.data(), blockSize, events);
+        timer.skip();
+        telemetry.publish(synth.graph(), synth.energies(), left.data(), right.data(), blockSize);
+        timer.lap(rgs::profiling::Phase::Telemetry);
+        timer.total(rgs::profiling::Phase::Block);
+
+        phases.add(synth.phaseTimes());
+        profiler.record(phases, blockSize);
+
+        if (tracing) {
+            rgs::profiling::TraceRecord record;
+            record.type = rgs::profiling::TraceRecord::Type::Callback;
+            record.track = static_cast<uint16_t>(track);
+            record.a = blockSize;
+            record.b = static_cast<int>(events.size());
+            record.c = synth.activeVoices();
+            record.d = synth.awakeNodes();
+            record.start = startTicks;
+            record.end = rgs::profiling::now();
+            record.setPhases(phases);
+            tracer->record(record);
+        }
+
+        auto ns = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+        blockTimes.push_back(ns);
+        if (!events.empty()) {
+            strikeTimes.push_back(ns);
+        }
+        totalNs += ns;
+        samplePos += blockSize;
+        peakVoices = std::max(peakVoices, synth.activeVoices());
+    }
+
+    Result r;
+    r.blocks = numBlocks;
+    r.edges = synth.graph().getNumEdges();
+    r.nodes = synth.graph().getNumNodes();
+    r.peakVoices = peakVoices;
+    r.threads = synth.threads();
+    r.nsPerSample = totalNs / static_cast<double>(samplePos);
+    r.realtimeFactor = (static_cast<double>(samplePos) / scenario.sampleRate) / (totalNs * 1e-9);
+    r.deadlineNs = 1e9 * blockSize / scenario.sampleRate;
+    r.p50 = percentile(blockTimes, 0.50);
+    r.p99 = percentile(blockTimes, 0.99);
+    r.max = *std::max_element(blockTimes.begin(), blockTimes.end());
+    if (!strikeTimes.empty()) {
+        r.strikeP50 = percentile(strikeTimes, 0.50);
+        r.strikeMax = *std::max_element(strikeTimes.begin(), strikeTimes.end());
+    }
+    r.overruns = static_cast<int>(std::count_if(blockTimes.begin(), blockTimes.end(),
+        [&](double t) { return t > r.deadlineNs; }));
+    if constexpr (rgs::profiling::ENABLED) {
+        r.profile = profiler.dumpJson();
+    }
+    return r;
+}
+
+// Running windowed RMS comparison for Engine::MultiRate and Engine::Modal
+class LevelMatch {
+public:
+    explicit LevelMatch(double sampleRate)
+        : window(std::max(1, static_cast<int>(LEVEL_WINDOW * sampleRate))) {}
+
+    void add(float reference, float candidate) {
+        referenceSum += static_cast<double>(reference) * reference;
+        candidateSum += static_cast<double>(candidate) * candidate;
+        if (++count < window) {
+            return;
+        }
+        const double referenceRms = std::sqrt(referenceSum / window);
+        const double candidateRms = std::sqrt(candidateSum / window);
+        if (referenceRms > LEVEL_FLOOR) {
+            const double db = 20.0 * std::log10(std::max(candidateRms, 1e-9) / referenceRms);
+            worstDb = std::max(worstDb, std::abs(db));
+        }
+        referenceSum = candidateSum = 0.0;
+        count = 0;
+    }
+
+    double getWorstDb() const { return worstDb; }
+
+private:
+    int window;
+    int count = 0;
+    double referenceSum = 0.0;
+    double candidateSum = 0.0;
+    double worstDb = 0.0;
+};
+
+// Partial-by-partial comparison of the first note, for Engine::Modal
+class PartialMatch {
+public:
+    explicit PartialMatch(double sampleRate)
+        : sampleRate(sampleRate),
+          skip(static_cast<long long>(PARTIAL_SKIP * sampleRate)),
+          length(static_cast<size_t>(PARTIAL_WINDOW * sampleRate)) {
+        reference.reserve(length);
+        candidate.reserve(length);
+    }
+
+    void add(float referenceSample, float candidateSample) {
+        if (position++ >= skip && reference.size() < length) {
+            reference.push_back(referenceSample);
+            candidate.push_back(candidateSample);
+        }
+    }
+
+    // Once the window is full: the worst partial of harmonics of fundamental
+    void compare(double fundamental) {
+        applyWindow(reference);
+        applyWindow(candidate);
+
+        double peakHz[rgs::simd::MODAL_MODES], peakDb[rgs::simd::MODAL_MODES];
+        int numPartials = 0;
+        double strongest = -1e9;
+        for (int k = 1; k <= rgs::simd::MODAL_MODES
+                        && k * fundamental < rgs::ModalBank::MAX_MODE_FREQUENCY * sampleRate; k++) {
+            findPeak(reference, k * fundamental, peakHz[numPartials], peakDb[numPartials]);
+            strongest = std::max(strongest, peakDb[numPartials]);
+            numPartials++;
+        }
+
+        for (int i = 0; i < numPartials; i++) {
+            if (peakDb[i] < strongest - PARTIAL_RANGE_DB) {
+                continue;
+            }
+            double hz = 0.0, db = 0.0;
+            findPeak(candidate, (i + 1) * fundamental, hz, db);
+            worstDb = std::max(worstDb, std::abs(db - peakDb[i]));
+            worstCents = std::max(worstCents, std::abs(1200.0 * std::log2(hz / peakHz[i])));
+        }
+    }
+
+    double getWorstDb() const { return worstDb; }
+    double getWorstCents() const { return worstCents; }
+
+private:
+    static void applyWindow(std::vector<float>& x) {
+        const double scale = 2.0 * 3.14159265358979323846 / static_cast<double>(x.size() - 1);
+        for (size_t i = 0; i < x.size(); i++) {
+            x[i] *= static_cast<float>(0.5 - 0.5 * std::cos(scale * static_cast<double>(i)));
+        }
+    }
+
+    // Magnitude of x at hz (Goertzel)
+    double magnitude(const std::vector<float>& x, double hz) const {
+        const double coeff = 2.0 * std::cos(2.0 * 3.14159265358979323846 * hz / sampleRate);
+        double s1 = 0.0, s2 = 0.0;
+        for (float v : x) {
+            const double s0 = v + coeff * s1 - s2;
+            s2 = s1;
+            s1 = s0;
+        }
+        return std::sqrt(std::max(1e-30, s1 * s1 + s2 * s2 - coeff * s1 * s2));
+    }
+
+    // The largest peak within 2% of hz, a bin apart, then fitted with a
+    // parabola through its neighbours' log magnitudes
+    void findPeak(const std::vector<float>& x, double hz, double& peakHz, double& peakDb) const {
+        const double bin = sampleRate / static_cast<double>(x.size());
+        double best = 0.0;
+        peakHz = hz;
+        for (double f = hz * 0.98; f <= hz * 1.02; f += bin) {
+            const double m = magnitude(x, f);
+            if (m > best) {
+                best = m;
+                peakHz = f;
+            }
+        }
+        const double below = std::log(magnitude(x, peakHz - bin));
+        const double at = std::log(best);
+        const double above = std::log(magnitude(x, peakHz + bin));
+        const double curve = below - 2.0 * at + above;
+        const double offset = curve < 0.0 ? 0.5 * (below - above) / curve : 0.0;
+        peakHz += offset * bin;
+        peakDb = 20.0 / std::log(10.0) * (at - 0.25 * (below - above) * offset);
+    }
+
+    double sampleRate;
+    long long skip;
+    size_t length;
+    long long position = 0;
+    std::vector<float> reference;
+    std::vector<float> candidate;
+    double worstDb = 0.0;
+    double worstCents = 0.0;
+};
+
+bool passes(const Scenario& scenario, const Result& r) {
+    return r.maxDeviation <= toleranceFor(scenario.engine, scenario.load)
+        && r.partialDb <= PARTIAL_DB_TOLERANCE && r.partialCents <= PARTIAL_CENTS_TOLERANCE;
+}
+
+Result verify(const Scenario& scenario, const Options& options) {
+    Synth reference(scenario, rgs::Engine::Scalar, rgs::fastmath::Quality::Reference);
+    Synth candidate(scenario, scenario.engine, scenario.quality);
+
+    const int blockSize = scenario.blockSize;
+    const auto totalSamples = static_cast<long long>(options.seconds * scenario.sampleRate);
+
+    std::vector<float> refLeft(static_cast<size_t>(blockSize)), refRight(refLeft.size());
+    std::vector<float> left(refLeft.size()), right(refLeft.size());
+    std::vector<rgs::NoteEvent> events;
+
+    const bool levelOnly = scenario.engine == rgs::Engine::MultiRate || scenario.engine == rgs::Engine::Modal;
+    LevelMatch leftLevel(scenario.sampleRate), rightLevel(scenario.sampleRate);
+    if (levelOnly) {
+        reference.setGlobalCoupling(0.0f);
+        candidate.setGlobalCoupling(0.0f);
+    }
+
+    Result r;
+    r.partials = scenario.engine == rgs::Engine::Modal && scenario.load == Load::SingleNote;
+    PartialMatch partials(scenario.sampleRate);
+    long long nextStrike = 0;
+    for (long long pos = 0; pos < totalSamples; pos += blockSize) {
+        collectStrikes(scenario, pos, blockSize, nextStrike, events);
+        reference.process(refLeft.data(), refRight.data(), blockSize, events);
+        candidate.process(left.data(), right.data(), blockSize, events);
+
+        for (size_t i = 0; i < left.size(); i++) {
+            if (levelOnly) {
+                leftLevel.add(refLeft[i], left[i]);
+                rightLevel.add(refRight[i], right[i]);
+                if (r.partials) {
+                    partials.add(refLeft[i] + refRight[i], left[i] + right[i]);
+                }
+                continue;
+            }
+            r.maxDeviation = std::max(r.maxDeviation, static_cast<double>(std::abs(left[i] - refLeft[i])));
+            r.maxDeviation = std::max(r.maxDeviation, static_cast<double>(std::abs(right[i] - refRight[i])));
+        }
+        r.blocks++;
+    }
+    if (levelOnly) {
+        r.maxDeviation = std::max(leftLevel.getWorstDb(), rightLevel.getWorstDb());
+    }
+    if (r.partials) {
+        partials.compare(440.0 * std::pow(2.0, (PARTIAL_NOTE - 69) / 12.0));
+        r.partialDb = partials.getWorstDb();
+        r.partialCents = partials.getWorstCents();
+    }
+    return r;
+}
+
+struct DecayResult {
+    std::string name;
+    double seconds = 0.0;   // Until asleep (voices: idle), or limit when it never was
+    double limit = 0.0;
+    bool asleep = false;
+};
+
+// One C4 at the default settings but coupling, rendered until the graph
+// sleeps, or every voice is idle
+DecayResult measureDecay(const Scenario& scenario, float coupling) {
+    Synth synth(scenario, scenario.engine, scenario.quality);
+    synth.setGlobalCoupling(coupling);
+
+    DecayResult r;
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), "/c%.1f", coupling);
+    r.name = scenario.name + suffix;
+    r.limit = synth.tailSeconds() + DECAY_MARGIN;
+
+    const int blockSize = scenario.blockSize;
+    const auto limitSamples = static_cast<long long>(r.limit * scenario.sampleRate);
+    std::vector<float> left(static_cast<size_t>(blockSize)), right(left.size());
+    std::vector<rgs::NoteEvent> events = { rgs::NoteEvent::noteOn(0, 60, 0.8f) };
+
+    long long pos = 0;
+    for (; pos < limitSamples && !r.asleep; pos += blockSize) {
+        synth.process(left.data(), right.data(), blockSize, events);
+        events.clear();
+        r.asleep = synth.isAsleep();
+    }
+    r.seconds = static_cast<double>(pos) / scenario.sampleRate;
+    return r;
+}
+
+// Every layout, engine and topology asked for, at 48 kHz in 512-sample blocks
+std::vector<Scenario> buildDecayScenarios(const Options& options) {
+    const rgs::Topology topologies[] = {
+        rgs::Topology::Chromatic, rgs::Topology::Fifths,
+        rgs::Topology::Tonnetz, rgs::Topology::Harmonic
+    };
+
+    std::vector<Scenario> scenarios;
+    for (const auto& layout : options.layouts) {
+        for (auto engine : options.engines) {
+            for (auto topo : topologies) {
+                Scenario s;
+                s.layout = layout;
+                s.engine = engine;
+                s.quality = options.qualities.front();
+                s.voices = options.voices;
+                s.threads = 1;
+                s.baseline = -1;
+                s.exciter = options.exciter;
+                s.load = Load::SingleNote;
+                s.topology = topo;
+                s.sampleRate = 48000.0;
+                s.blockSize = 512;
+                s.name = std::string(layout.name) + "/" + engineName(engine) + "/"
+                       + (s.voices > 0 ? "v" + std::to_string(s.voices) + "/" : "")
+                       + "decay/" + topologyName(topo);
+
+                if (options.filter.empty() || s.name.find(options.filter) != std::string::npos) {
+                    scenarios.push_back(s);
+                }
+            }
+        }
+    }
+    return scenarios;
+}
+
+void writeDecayJson(FILE* out, const std::vector<DecayResult>& results) {
+    std::fprintf(out, "{\n  \"benchmark\": \"rgs_bench decay\",\n  \"scenarios\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        std::fprintf(out,
+            "    {\"name\": \"%s\", \"seconds\": %.2f, \"limit\": %.2f, \"pass\": %s}%s\n",
+            r.name.c_str(), r.seconds, r.limit, r.asleep ? "true" : "false",
+            i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+}
+
+struct AccuracyResult {
+    std::string name;
+    double maxError = 0.0;
+    double bound = 0.0;
+    double nsPerValue = 0.0;
+};
+
+// Worst error of fn against a double-precision reference over [lo, hi],
+// and its throughput over a buffer of those inputs
+template <typename Fn, typename Ref>
+AccuracyResult measureAccuracy(const char* name, Fn fn, Ref reference,
+                               float lo, float hi, bool relative, float bound) {
+    AccuracyResult r;
+    r.name = name;
+    r.bound = bound;
+
+    constexpr int POINTS = 1 << 20;
+    std::vector<float> inputs(POINTS), outputs(POINTS);
+    for (int i = 0; i < POINTS; i++) {
+        inputs[i] = lo + (hi - lo) * static_cast<float>(i) / (POINTS - 1);
+    }
+
+    for (int i = 0; i < POINTS; i++) {
+        const double expected = reference(static_cast<double>(inputs[i]));
+        double error = std::abs(static_cast<double>(fn(inputs[i])) - expected);
+        if (relative) {
+            error /= std::abs(expected);
+        }
+        r.maxError = std::max(r.maxError, error);
+    }
+
+    // Throughput over an L1-sized slice spread across the range
+    constexpr int SLICE = 2048;
+    constexpr int PASSES = 4096;
+    std::vector<float> slice(SLICE);
+    for (int i = 0; i < SLICE; i++) {
+        slice[i] = inputs[static_cast<size_t>(i) * (POINTS / SLICE)];
+    }
+
+    const auto start = Clock::now();
+    for (int pass = 0; pass < PASSES; pass++) {
+        for (int i = 0; i < SLICE; i++) {
+            outputs[i] = fn(slice[i]);
+        }
+    }
+    const auto ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    r.nsPerValue = ns / (static_cast<double>(SLICE) * PASSES);
+
+    // Keep the timed loop from being optimised away
+    volatile float sink = outputs[SLICE / 3];
+    (void) sink;
+    return r;
+}
+
+// Every fastmath tier next to libm over the range the engine uses it on
+std::vector<AccuracyResult> runAccuracy() {
+    namespace fm = rgs::fastmath;
+    auto tanhRef = [](double x) { return std::tanh(x); };
+    auto pow2Ref = [](double x) { return std::exp2(x); };
+    auto expRef = [](double x) { return std::exp(x); };
+    auto sinRef = [](double x) { return std::sin(x); };
+
+    return {
+        measureAccuracy("tanh/normal", [](float x) { return fm::tanh(x); }, tanhRef, -10.0f, 10.0f, false, fm::TANH_MAX_ERROR),
+        measureAccuracy("tanh/eco", [](float x) { return fm::tanhEco(x); }, tanhRef, -10.0f, 10.0f, false, fm::TANH_ECO_MAX_ERROR),
+        measureAccuracy("tanh/libm", [](float x) { return std::tanh(x); }, tanhRef, -10.0f, 10.0f, false, fm::TANH_MAX_ERROR),
+        measureAccuracy("pow2/normal", [](float x) { return fm::pow2(x); }, pow2Ref, -100.0f, 100.0f, true, fm::POW2_MAX_ERROR),
+        measureAccuracy("pow2/eco", [](float x) { return fm::pow2Eco(x); }, pow2Ref, -100.0f, 100.0f, true, fm::POW2_ECO_MAX_ERROR),
+        measureAccuracy("pow2/libm", [](float x) { return std::exp2(x); }, pow2Ref, -100.0f, 100.0f, true, fm::POW2_MAX_ERROR),
+        measureAccuracy("exp/normal", [](float x) { return fm::exp(x); }, expRef, -10.0f, 10.0f, true, fm::EXP_MAX_ERROR),
+        measureAccuracy("exp/eco", [](float x) { return fm::expEco(x); }, expRef, -10.0f, 10.0f, true, fm::EXP_ECO_MAX_ERROR),
+        measureAccuracy("exp/libm", [](float x) { return std::exp(x); }, expRef, -10.0f, 10.0f, true, fm::EXP_MAX_ERROR),
+        measureAccuracy("sin/normal", [](float x) { return fm::sin(x); }, sinRef, -1000.0f, 1000.0f, false, fm::SIN_MAX_ERROR),
+        measureAccuracy("sin/eco", [](float x) { return fm::sinEco(x); }, sinRef, -1000.0f, 1000.0f, false, fm::SIN_ECO_MAX_ERROR),
+        measureAccuracy("sin/libm", [](float x) { return std::sin(x); }, sinRef, -1000.0f, 1000.0f, false, fm::SIN_MAX_ERROR)
+    };
+}
+
+void writeAccuracyJson(FILE* out, const std::vector<AccuracyResult>& results) {
+    std::fprintf(out, "{\n  \"benchmark\": \"rgs_bench accuracy\",\n  \"functions\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        std::fprintf(out,
+            "    {\"name\": \"%s\", \"maxError\": %.3g, \"bound\": %g, \"nsPerValue\": %.3f, \"pass\": %s}%s\n",
+            r.name.c_str(), r.maxError, r.bound, r.nsPerValue,
+            r.maxError <= r.bound ? "true" : "false", i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+}
+
+void writeJson(FILE* out, const std::vector<Scenario>& scenarios,
+               const std::vector<Result>& results, const Options& options) {
+    std::fprintf(out, "{\n  \"benchmark\": \"rgs_bench\",\n");
+    std::fprintf(out, "  \"secondsPerScenario\": %.3f,\n", options.seconds);
+    std::fprintf(out, "  \"isa\": \"%s\",\n", rgs::simd::getIsaName(rgs::simd::getActiveIsa()));
+    if (options.verify) {
+        std::fprintf(out, "  \"tolerance\": %g,\n", VERIFY_TOLERANCE);
+    }
+    std::fprintf(out, "  \"scenarios\": [\n");
+
+    for (size_t i = 0; i < scenarios.size(); i++) {
+        const auto& s = scenarios[i];
+        const auto& r = results[i];
+        const char* separator = i + 1 < scenarios.size() ? "," : "";
+
+        // Against the same scenario on one thread, when it ran
+        const double speedup = s.baseline >= 0 ? results[s.baseline].nsPerSample / r.nsPerSample : 1.0;
+
+        if (options.verify) {
+            char partials[128] = "";
+            if (r.partials) {
+                std::snprintf(partials, sizeof(partials),
+                              "\"partialDb\": %.2f, \"partialCents\": %.2f, ", r.partialDb, r.partialCents);
+            }
+            std::fprintf(out,
+                "    {\"name\": \"%s\", \"maxDeviation\": %.3g, \"tolerance\": %g, %s\"pass\": %s}%s\n",
+                s.name.c_str(), r.maxDeviation, toleranceFor(s.engine, s.load), partials,
+                passes(s, r) ? "true" : "false", separator);
+            continue;
+        }
+
+        std::fprintf(out,
+            "    {\"name\": \"%s\", \"layout\": \"%s\", \"engine\": \"%s\", \"quality\": \"%s\", "
+            "\"load\": \"%s\", "
+            "\"topology\": \"%s\", \"sampleRate\": %d, \"blockSize\": %d, \"blocks\": %d, "
+            "\"nodes\": %d, \"edges\": %d, \"voices\": %d, \"peakVoices\": %d, \"threads\": %d, "
+            "\"nsPerSample\": %.2f, \"realtimeFactor\": %.2f, \"speedup\": %.2f, "
+            "\"blockNs\": {\"p50\": %.0f, \"p99\": %.0f, \"max\": %.0f}, "
+            "\"strikeBlockNs\": {\"p50\": %.0f, \"max\": %.0f}, "
+            "\"deadlineNs\": %.0f, \"overruns\": %d%s%s}%s\n",
+            s.name.c_str(), s.layout.name, engineName(s.engine), qualityName(s.quality), loadName(s.load),
+            topologyName(s.topology), static_cast<int>(s.sampleRate), s.blockSize, r.blocks,
+            r.nodes, r.edges, s.voices, r.peakVoices, r.threads,
+            r.nsPerSample, r.realtimeFactor, speedup,
+            r.p50, r.p99, r.max,
+            r.strikeP50, r.strikeMax,
+            r.deadlineNs, r.overruns, r.profile.empty() ? "" : ", \"profile\": ", r.profile.c_str(),
+            separator);
+    }
+
+    std::fprintf(out, "  ]\n}\n");
+}
+
+bool parseArgs(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(arg, "--quick") == 0) {
+            options.quick = true;
+        } else if (std::strcmp(arg, "--verify") == 0) {
+            options.verify = true;
+        } else if (std::strcmp(arg, "--accuracy") == 0) {
+            options.accuracy = true;
+        } else if (std::strcmp(arg, "--decay") == 0) {
+            options.decay = true;
+        } else if (std::strcmp(arg, "--quality") == 0 && hasValue) {
+            std::string quality = argv[++i];
+            if (quality == "eco") {
+                options.qualities = { rgs::fastmath::Quality::Eco };
+            } else if (quality == "normal") {
+                options.qualities = { rgs::fastmath::Quality::Normal };
+            } else if (quality == "reference") {
+                options.qualities = { rgs::fastmath::Quality::Reference };
+            } else if (quality == "all") {
+                options.qualities = { rgs::fastmath::Quality::Eco, rgs::fastmath::Quality::Normal,
+                                      rgs::fastmath::Quality::Reference };
+            } else {
+                std::fprintf(stderr, "rgs_bench: unknown quality '%s'\n", quality.c_str());
+                return false;
+            }
+        } else if (std::strcmp(arg, "--engine") == 0 && hasValue) {
+            std::string engine = argv[++i];
+            if (engine == "scalar") {
+                options.engines = { rgs::Engine::Scalar };
+            } else if (engine == "simd") {
+                options.engines = { rgs::Engine::Simd };
+            } else if (engine == "block") {
+                options.engines = { rgs::Engine::Block };
+            } else if (engine == "multirate") {
+                options.engines = { rgs::Engine::MultiRate };
+            } else if (engine == "modal") {
+                options.engines = { rgs::Engine::Modal };
+            } else if (engine == "all") {
+                options.engines = { rgs::Engine::Scalar, rgs::Engine::Simd, rgs::Engine::Block,
+                                    rgs::Engine::MultiRate, rgs::Engine::Modal };
+            } else {
+                std::fprintf(stderr, "rgs_bench: unknown engine '%s'\n", engine.c_str());
+                return false;
+            }
+        } else if (std::strcmp(arg, "--layout") == 0 && hasValue) {
+            std::string layout = argv[++i];
+            if (layout == "all") {
+                options.layouts.assign(std::begin(LAYOUTS), std::end(LAYOUTS));
+            } else if (layout == "octave") {
+                options.layouts = { LAYOUTS[0] };
+            } else if (layout == "piano") {
+                options.layouts = { LAYOUTS[1] };
+            } else if (layout == "midi") {
+                options.layouts = { LAYOUTS[2] };
+            } else if (layout == "grid") {
+                options.layouts = { LAYOUTS[3] };
+            } else {
+                std::fprintf(stderr, "rgs_bench: unknown layout '%s'\n", layout.c_str());
+                return false;
+            }
+        } else if (std::strcmp(arg, "--isa") == 0 && hasValue) {
+            std::string isa = argv[++i];
+            bool found = false;
+            for (auto candidate : { rgs::simd::Isa::Scalar, rgs::simd::Isa::Sse2,
+                                    rgs::simd::Isa::Avx2, rgs::simd::Isa::Avx512 }) {
+                if (isa == rgs::simd::getIsaName(candidate)) {
+                    rgs::simd::setIsaLimit(candidate);
+                    found = true;
+                }
+            }
+            if (!found) {
+                std::fprintf(stderr, "rgs_bench: unknown isa '%s'\n", isa.c_str());
+                return false;
+            }
+        } else if (std::strcmp(arg, "--voices") == 0 && hasValue) {
+            options.voices = std::clamp(std::atoi(argv[++i]), 0, rgs::VoiceManager::MAX_VOICES);
+        } else if (std::strcmp(arg, "--threads") == 0 && hasValue) {
+            const std::string threads = argv[++i];
+            if (threads == "scaling") {
+                options.threads = { 1, 2, 4, 8, 16 };
+            } else {
+                options.threads = { std::clamp(std::atoi(threads.c_str()), 1, rgs::WorkerPool::MAX_THREADS) };
+            }
+        } else if (std::strcmp(arg, "--exciter") == 0 && hasValue) {
+            const std::string type = argv[++i];
+            if (type == "pluck") {
+                options.exciter.type = rgs::Exciter::Type::Pluck;
+            } else if (type == "strike") {
+                options.exciter.type = rgs::Exciter::Type::Strike;
+            } else {
+                std::fprintf(stderr, "rgs_bench: unknown exciter '%s'\n", type.c_str());
+                return false;
+            }
+        } else if (std::strcmp(arg, "--hardness") == 0 && hasValue) {
+            options.exciter.hardness = std::clamp(static_cast<float>(std::atof(argv[++i])), 0.0f, 1.0f);
+        } else if (std::strcmp(arg, "--seconds") == 0 && hasValue) {
+            options.seconds = std::max(0.01, std::atof(argv[++i]));
+        } else if (std::strcmp(arg, "--filter") == 0 && hasValue) {
+            options.filter = argv[++i];
+        } else if (std::strcmp(arg, "--out") == 0 && hasValue) {
+            options.outPath = argv[++i];
+        } else if (std::strcmp(arg, "--trace") == 0 && hasValue) {
+            options.tracePath = argv[++i];
+        } else {
+            std::fprintf(stderr,
+                "usage: rgs_bench [--quick] [--seconds S] [--filter TEXT] [--out FILE]\n"
+                "                 [--engine scalar|simd|block|multirate|modal|all] [--isa scalar|sse2|avx2|avx512]\n"
+                "                 [--layout octave|piano|midi|grid|all] [--voices N] [--verify]\n"
+                "                 [--quality eco|normal|reference|all] [--accuracy] [--decay]\n"
+                "                 [--exciter pluck|strike] [--hardness H] [--threads N|scaling]\n"
+                "                 [--trace FILE]\n");
+            return false;
+        }
+    }
+    return true;
+}
+
+FILE* openOutput(const Options& options) {
+    if (options.outPath.empty()) {
+        return stdout;
+    }
+    FILE* out = std::fopen(options.outPath.c_str(), "w");
+    if (out == nullptr) {
+        std::fprintf(stderr, "rgs_bench: cannot write %s\n", options.outPath.c_str());
+    }
+    return out;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        return 2;
+    }
+
+    if (options.accuracy) {
+        auto results = runAccuracy();
+        bool passed = true;
+        for (const auto& r : results) {
+            passed = passed && r.maxError <= r.bound;
+            std::fprintf(stderr, "%-16s max error %.3g (bound %g)  %.2f ns/value\n",
+                         r.name.c_str(), r.maxError, r.bound, r.nsPerValue);
+        }
+
+        FILE* out = openOutput(options);
+        if (out == nullptr) {
+            return 1;
+        }
+        writeAccuracyJson(out, results);
+        if (out != stdout) {
+            std::fclose(out);
+        }
+        return passed ? 0 : 1;
+    }
+
+    if (options.decay) {
+        rgs::ScopedFlushDenormals noDenormals;
+        std::vector<DecayResult> results;
+        bool passed = true;
+        for (const auto& scenario : buildDecayScenarios(options)) {
+            for (float coupling : DECAY_COUPLINGS) {
+                results.push_back(measureDecay(scenario, coupling));
+                const auto& r = results.back();
+                passed = passed && r.asleep;
+                std::fprintf(stderr, "%-40s %s after %.2f s (limit %.2f s)\n", r.name.c_str(),
+                             r.asleep ? "asleep" : "AWAKE", r.seconds, r.limit);
+            }
+        }
+
+        FILE* out = openOutput(options);
+        if (out == nullptr) {
+            return 1;
+        }
+        writeDecayJson(out, results);
+        if (out != stdout) {
+            std::fclose(out);
+        }
+        return passed ? 0 : 1;
+    }
+
+    auto scenarios = buildScenarios(options);
+    if (scenarios.empty()) {
+        std::fprintf(stderr, "rgs_bench: no scenario matches '%s'\n", options.filter.c_str());
+        return 1;
+    }
+
+    rgs::ScopedFlushDenormals noDenormals;
+
+    rgs::profiling::Tracer tracer;
+    if (!options.tracePath.empty()) {
+        std::string error;
+        if (!tracer.start(options.tracePath, error)) {
+            std::fprintf(stderr, "rgs_bench: %s\n", error.c_str());
+            return 1;
+        }
+    }
+
+    std::vector<Result> results;
+    results.reserve(scenarios.size());
+    bool passed = true;
+
+    for (const auto& scenario : scenarios) {
+        std::fprintf(stderr, "%-40s", scenario.name.c_str());
+
+        if (options.verify) {
+            results.push_back(verify(scenario, options));
+            const auto& r = results.back();
+            passed = passed && passes(scenario, r);
+            if (r.partials) {
+                std::fprintf(stderr, " max deviation %.3g  partials %.2f dB %.2f cents\n",
+                             r.maxDeviation, r.partialDb, r.partialCents);
+            } else {
+                std::fprintf(stderr, " max deviation %.3g\n", r.maxDeviation);
+            }
+        } else {
+            results.push_back(run(scenario, options, &tracer, static_cast<int>(results.size())));
+            std::fprintf(stderr, " %8.2f ns/sample  x%.1f realtime\n",
+                         results.back().nsPerSample, results.back().realtimeFactor);
+        }
+    }
+
+    if (tracer.isRecording()) {
+        tracer.stop();
+        if (tracer.getDropped() > 0) {
+            std::fprintf(stderr, "rgs_bench: trace ring overflowed, %llu records dropped\n",
+                         static_cast<unsigned long long>(tracer.getDropped()));
+        }
+    }
+
+    FILE* out = openOutput(options);
+    if (out == nullptr) {
+        return 1;
+    }
+
+    writeJson(out, scenarios, results, options);
+
+    if (out != stdout) {
+        std::fclose(out);
+    }
+    return passed ? 0 : 1;
+}
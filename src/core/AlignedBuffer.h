@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+namespace rgs {
+
+/**
+ * Zero-initialised heap array aligned to a cache line
+ *
+ * Backing store for structure-of-arrays DSP state: every lane array
+ * starts on a 64-byte boundary so SIMD loads never split a cache line.
+ * Allocation only happens in allocate(), never on the audio thread.
+ */
+template <typename T>
+class AlignedBuffer {
+    static_assert(std::is_trivially_copyable<T>::value, "AlignedBuffer holds plain data only");
+
+public:
+    static constexpr size_t ALIGNMENT = 64;
+
+    AlignedBuffer() = default;
+    ~AlignedBuffer() { release(); }
+
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+    AlignedBuffer(AlignedBuffer&& other) noexcept
+        : ptr(other.ptr), count(other.count) {
+        other.ptr = nullptr;
+        other.count = 0;
+    }
+
+    AlignedBuffer& operator=(AlignedBuffer&& other) noexcept {
+        if (this != &other) {
+            release();
+            ptr = other.ptr;
+            count = other.count;
+            other.ptr = nullptr;
+            other.count = 0;
+        }
+        return *this;
+    }
+
+    // Reallocate to n elements, all zero
+    void allocate(size_t n) {
+        release();
+        if (n > 0) {
+            ptr = static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(ALIGNMENT)));
+            count = n;
+            clear();
+        }
+    }
+
+    void clear() {
+        if (ptr != nullptr) {
+            std::memset(static_cast<void*>(ptr), 0, count * sizeof(T));
+        }
+    }
+
+    T* data() { return ptr; }
+    const T* data() const { return ptr; }
+    size_t size() const { return count; }
+
+    T& operator[](size_t i) { return ptr[i]; }
+    const T& operator[](size_t i) const { return ptr[i]; }
+
+private:
+    void release() {
+        if (ptr != nullptr) {
+            ::operator delete(static_cast<void*>(ptr), std::align_val_t(ALIGNMENT));
+            ptr = nullptr;
+            count = 0;
+        }
+    }
+
+    T* ptr = nullptr;
+    size_t count = 0;
+};
+
+} // namespace rgs
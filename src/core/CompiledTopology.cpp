@@ -0,0 +1,132 @@
+#include "CompiledTopology.h"
+#include <algorithm>
+#include <cmath>
+
+namespace rgs {
+
+CompiledTopology::CompiledTopology(const GraphLayout& layout, Topology topo)
+    : numNodes(layout.numNodes), topology(topo) {
+    buildPreset(layout);
+    compile();
+}
+
+CompiledTopology::CompiledTopology(const GraphLayout& layout, Topology topo, const CouplingEdge* edits, int numEdits)
+    : numNodes(layout.numNodes), topology(topo) {
+    buildPreset(layout);
+    for (int e = 0; e < numEdits; e++) {
+        setWeight(edits[e].from, edits[e].to, edits[e].weight);
+    }
+    compile();
+}
+
+CompiledTopology::CompiledTopology(const CompiledTopology& other, int from, int to, float weight)
+    : numNodes(other.numNodes), topology(other.topology), edited(other.edited), weights(other.weights) {
+    setWeight(from, to, weight);
+    compile();
+}
+
+void CompiledTopology::setWeight(int from, int to, float weight) {
+    if (from >= 0 && from < numNodes && to >= 0 && to < numNodes) {
+        weights[static_cast<size_t>(from * numNodes + to)] = std::clamp(weight, 0.0f, 1.0f);
+        edited = true;
+    }
+}
+
+void CompiledTopology::buildPreset(const GraphLayout& layout) {
+    weights.assign(static_cast<size_t>(numNodes) * static_cast<size_t>(numNodes), 0.0f);
+
+    // Connect node i to the node `interval` semitones away. Folded
+    // layouts wrap around the ring; keyboard layouts drop edges that
+    // would leave the range. Grid layouts connect the nearest step.
+    auto connect = [&](int i, int interval, float w) {
+        const int steps = static_cast<int>(std::lround(interval * layout.stepsPerOctave / 12.0));
+        if (steps == 0) {
+            return;
+        }
+        int j = i + steps;
+        if (layout.foldOctaves) {
+            j = ((j % numNodes) + numNodes) % numNodes;
+        } else if (j < 0 || j >= numNodes) {
+            return;
+        }
+        weights[static_cast<size_t>(i * numNodes + j)] = w;
+    };
+
+    switch (topology) {
+        case Topology::Chromatic:
+            // Connect each node to neighbors +-1 semitone
+            for (int i = 0; i < numNodes; i++) {
+                connect(i, -1, 0.3f);
+                connect(i, +1, 0.3f);
+            }
+            break;
+
+        case Topology::Fifths:
+            // Circle of fifths: each node connects to +7 and -7 semitones
+            for (int i = 0; i < numNodes; i++) {
+                connect(i, +7, 0.6f);
+                connect(i, -7, 0.6f);   // Folded: -7 = +5
+            }
+            break;
+
+        case Topology::Tonnetz:
+            // Neo-Riemannian: triangular lattice with M3, m3, P5
+            for (int i = 0; i < numNodes; i++) {
+                connect(i, 4, 0.5f);    // Major third
+                connect(i, 3, 0.4f);    // Minor third
+                connect(i, 7, 0.7f);    // Perfect fifth
+            }
+            break;
+
+        case Topology::Harmonic:
+            // Harmonic series connections
+            // Connect to nodes that are harmonics (octave, fifth, etc.)
+            for (int i = 0; i < numNodes; i++) {
+                // Octave above (a self-loop when folded onto one octave)
+                connect(i, 12, 0.8f);
+                // Fifth
+                connect(i, 7, 0.6f);
+                // Major third
+                connect(i, 4, 0.4f);
+            }
+            break;
+
+        case Topology::Custom:
+            // Leave empty, user will set manually
+            break;
+    }
+}
+
+void CompiledTopology::compile() {
+    const auto n = static_cast<size_t>(numNodes);
+    auto edge = [this](int src, int tgt) { return src != tgt && getWeight(src, tgt) > 0.0f; };
+
+    edgeStart.assign(n + 1, 0);
+    for (int src = 0; src < numNodes; src++) {
+        edgeStart[src] = static_cast<int>(edgeTarget.size());
+        for (int tgt = 0; tgt < numNodes; tgt++) {
+            if (edge(src, tgt)) {
+                edgeTarget.push_back(tgt);
+                edgeWeight.push_back(getWeight(src, tgt));
+            }
+        }
+    }
+    edgeStart[n] = static_cast<int>(edgeTarget.size());
+
+    inStart.assign(n + 1, 0);
+    for (int tgt = 0; tgt < numNodes; tgt++) {
+        inStart[tgt] = static_cast<int>(inSource.size());
+        float sum = 0.0f;
+        for (int src = 0; src < numNodes; src++) {
+            if (edge(src, tgt)) {
+                inSource.push_back(src);
+                inWeight.push_back(getWeight(src, tgt));
+                sum += getWeight(src, tgt);
+            }
+        }
+        maxInputWeight = std::max(maxInputWeight, sum);
+    }
+    inStart[n] = static_cast<int>(inSource.size());
+}
+
+} // namespace rgs
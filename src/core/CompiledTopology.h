@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace rgs {
+
+/**
+ * Graph topology types
+ */
+enum class Topology {
+    Chromatic,   // Each node connects to +-1 semitone
+    Fifths,      // Circle of fifths connections
+    Tonnetz,     // Neo-Riemannian triangular lattice
+    Harmonic,    // Harmonic series from each node
+    Custom       // User-defined
+};
+
+/**
+ * How many nodes a graph has and which MIDI notes they stand for
+ *
+ * Node i rests at MIDI note lowestNote + i, one semitone apart.
+ * - foldOctaves: every MIDI note maps onto a node by pitch class and the
+ *   node is retuned to the played octave (the classic 12-node circle).
+ *   Topology intervals wrap around the node ring.
+ * - otherwise each note has its own node (full keyboard) and topology
+ *   intervals connect real pitches across octaves without wrapping.
+ *
+ * Keyboard layouts may divide the octave into stepsPerOctave nodes
+ * instead of 12 (grid): a MIDI note plays the nearest node, and topology
+ * intervals keep their size in pitch. Folded layouts are always 12.
+ */
+struct GraphLayout {
+    int numNodes = 12;
+    int lowestNote = 60;         // C4
+    bool foldOctaves = true;
+    int stepsPerOctave = 12;
+
+    static GraphLayout octave() { return {}; }
+    static GraphLayout keyboard(int lowestNote, int numNodes) { return { numNodes, lowestNote, false }; }
+    static GraphLayout piano() { return keyboard(21, 88); }       // A0 - C8
+    static GraphLayout fullMidi() { return keyboard(0, 128); }
+    static GraphLayout grid(int lowestNote, int numNodes, int stepsPerOctave) {
+        return { numNodes, lowestNote, false, stepsPerOctave };
+    }
+
+    bool operator==(const GraphLayout& other) const {
+        return numNodes == other.numNodes && lowestNote == other.lowestNote
+            && foldOctaves == other.foldOctaves && stepsPerOctave == other.stepsPerOctave;
+    }
+    bool operator!=(const GraphLayout& other) const { return !(*this == other); }
+};
+
+/**
+ * One coupling weight set by hand over a topology's own
+ */
+struct CouplingEdge {
+    int from = 0;
+    int to = 0;
+    float weight = 0.0f;   // 0-1; 0 removes the edge
+
+    bool operator==(const CouplingEdge& other) const {
+        return from == other.from && to == other.to && weight == other.weight;
+    }
+    bool operator!=(const CouplingEdge& other) const { return !(*this == other); }
+};
+
+/**
+ * A graph's coupling, compiled once and never changed after
+ *
+ * Built off the audio thread, from a Topology preset or as a copy of
+ * another with one edge changed, and handed to the audio thread whole
+ * (ResonatorGraph::setTopology, VoiceManager), so a render never sees a
+ * half-edited matrix and never pays for compiling one. Any number of
+ * graphs can share one.
+ *
+ * Holds the dense numNodes x numNodes weights, row = source, for
+ * lookups, and the edges twice as compressed sparse rows: by source,
+ * which the per-sample engines scatter over, and by target with sources
+ * ascending, which lets the partitioned engine gather each target's
+ * inputs in the order the rows by source add them. Self-loops and zero
+ * weights compile to no edge: a node already feeds itself.
+ */
+class CompiledTopology {
+public:
+    // The preset's edges for layout, as ResonatorGraph::getLayout()
+    // reports it (node count and steps already clamped)
+    CompiledTopology(const GraphLayout& layout, Topology topology);
+
+    // The preset with edits applied in order (a preset's saved coupling).
+    // Edits naming nodes out of range are skipped.
+    CompiledTopology(const GraphLayout& layout, Topology topology, const CouplingEdge* edits, int numEdits);
+
+    // A copy of other with from -> to set to weight, clamped to 0-1.
+    // Nodes out of range copy other unchanged.
+    CompiledTopology(const CompiledTopology& other, int from, int to, float weight);
+
+    int getNumNodes() const { return numNodes; }
+    int getNumEdges() const { return static_cast<int>(edgeTarget.size()); }
+
+    // The preset this started from; isEdited() once any edge was set
+    Topology getTopology() const { return topology; }
+    bool isEdited() const { return edited; }
+
+    float getWeight(int from, int to) const { return weights[static_cast<size_t>(from * numNodes + to)]; }
+
+    // By source: edges of node i are [edgeStarts[i], edgeStarts[i + 1])
+    const int* getEdgeStarts() const { return edgeStart.data(); }
+    const int* getEdgeTargets() const { return edgeTarget.data(); }
+    const float* getEdgeWeights() const { return edgeWeight.data(); }
+
+    // By target, sources ascending
+    const int* getInputStarts() const { return inStart.data(); }
+    const int* getInputSources() const { return inSource.data(); }
+    const float* getInputWeights() const { return inWeight.data(); }
+
+    // The largest sum of weights into one node, 0 with no edges
+    float getMaxInputWeight() const { return maxInputWeight; }
+
+private:
+    void buildPreset(const GraphLayout& layout);
+    void setWeight(int from, int to, float weight);
+    void compile();
+
+    int numNodes = 0;
+    Topology topology = Topology::Custom;
+    bool edited = false;
+
+    std::vector<float> weights;
+
+    std::vector<int> edgeStart;
+    std::vector<int> edgeTarget;
+    std::vector<float> edgeWeight;
+
+    std::vector<int> inStart;
+    std::vector<int> inSource;
+    std::vector<float> inWeight;
+    float maxInputWeight = 0.0f;
+};
+
+} // namespace rgs
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define RGS_DENORMALS_SSE 1
+#elif defined(__aarch64__)
+    #define RGS_DENORMALS_ARM64 1
+#endif
+
+namespace rgs {
+
+/**
+ * Flush denormals to zero for the lifetime of the object
+ *
+ * Headless equivalent of juce::ScopedNoDenormals: decaying resonators
+ * spend most of their tail in denormal range, which costs 10-100x on x86.
+ * Hosts set this up for the plugin; offline tools must do it themselves.
+ */
+class ScopedFlushDenormals {
+public:
+    ScopedFlushDenormals() {
+#if RGS_DENORMALS_SSE
+        previous = _mm_getcsr();
+        _mm_setcsr(previous | 0x8040);  // FTZ | DAZ
+#elif RGS_DENORMALS_ARM64
+        uint64_t fpcr;
+        asm volatile("mrs %0, fpcr" : "=r"(fpcr));
+        previous = fpcr;
+        asm volatile("msr fpcr, %0" : : "r"(fpcr | (1ull << 24)));  // FZ
+#endif
+    }
+
+    ~ScopedFlushDenormals() {
+#if RGS_DENORMALS_SSE
+        _mm_setcsr(static_cast<unsigned int>(previous));
+#elif RGS_DENORMALS_ARM64
+        asm volatile("msr fpcr, %0" : : "r"(previous));
+#endif
+    }
+
+    ScopedFlushDenormals(const ScopedFlushDenormals&) = delete;
+    ScopedFlushDenormals& operator=(const ScopedFlushDenormals&) = delete;
+
+private:
+    uint64_t previous = 0;
+};
+
+} // namespace rgs
@@ -0,0 +1,113 @@
+#include "ExcitationTable.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace rgs {
+
+namespace {
+
+// Lengths MIN_LENGTH, 2 MIN_LENGTH ... MAX_LENGTH; the shape of length n
+// starts n - MIN_LENGTH floats into its layer
+constexpr int LAYER_SIZE = 2 * ExcitationTable::MAX_LENGTH - ExcitationTable::MIN_LENGTH;
+
+// RMS of uniform noise in [-1, 1], the level strikes used to have
+constexpr float TARGET_RMS = 0.57735026919f;
+
+void normalise(float* shape, int length) {
+    float sumSquares = 0.0f;
+    float peak = 0.0f;
+    for (int i = 0; i < length; i++) {
+        sumSquares += shape[i] * shape[i];
+        peak = std::max(peak, std::abs(shape[i]));
+    }
+    if (peak <= 0.0f) {
+        return;
+    }
+
+    // Match the RMS, but never peak past full scale
+    const float rms = std::sqrt(sumSquares / static_cast<float>(length));
+    const float gain = std::min(TARGET_RMS / rms, 1.0f / peak);
+    for (int i = 0; i < length; i++) {
+        shape[i] *= gain;
+    }
+}
+
+} // namespace
+
+ExcitationTable::ExcitationTable(const ExciterSettings& s) : settings(s) {
+    shapes.assign(static_cast<size_t>(NUM_LAYERS * LAYER_SIZE), 0.0f);
+
+    for (int layer = 0; layer < NUM_LAYERS; layer++) {
+        // Softer layers are duller: half the hardness at the bottom one
+        const float layerVelocity = static_cast<float>(layer + 1) / NUM_LAYERS;
+
+        // Each layer restarts the noise so a table depends only on its
+        // settings
+        Exciter exciter;
+        exciter.setType(settings.type);
+        exciter.setPosition(settings.position);
+        exciter.setHardness(settings.hardness * (0.5f + 0.5f * layerVelocity));
+
+        for (int length = MIN_LENGTH; length <= MAX_LENGTH; length <<= 1) {
+            float* shape = shapes.data() + layer * LAYER_SIZE + (length - MIN_LENGTH);
+            exciter.generate(shape, length, 1.0f);
+            normalise(shape, length);
+        }
+    }
+}
+
+int ExcitationTable::layerFor(float velocity) {
+    return std::clamp(static_cast<int>(velocity * NUM_LAYERS), 0, NUM_LAYERS - 1);
+}
+
+int ExcitationTable::lengthFor(int loopLength) {
+    int length = MIN_LENGTH;
+    while (length < MAX_LENGTH && (length << 1) <= loopLength) {
+        length <<= 1;
+    }
+    return length;
+}
+
+const float* ExcitationTable::getShape(int layer, int length) const {
+    return shapes.data() + layer * LAYER_SIZE + (length - MIN_LENGTH);
+}
+
+ExcitationTable::Strike ExcitationTable::strike(int loopLength, float velocity, int decimation) const {
+    loopLength = std::max(loopLength, MIN_LENGTH);
+    const int length = lengthFor(loopLength * decimation);
+
+    Strike s;
+    s.shape = getShape(layerFor(velocity), length);
+    s.lengthMask = length - 1;
+    s.lag = loopLength;
+    s.remaining = loopLength;
+    // Stretch only: the step is at most decimation (exactly 1 when the
+    // lengths match)
+    s.step = (static_cast<uint32_t>(length) << 16) / static_cast<uint32_t>(loopLength);
+    s.velocity = velocity;
+    return s;
+}
+
+void ExcitationTable::Strike::deliver(float* line, int mask, int writePos, int count) {
+    count = std::min(count, remaining);
+    const int start = writePos - lag;
+    for (int i = 0; i < count; i++) {
+        // The loop is periodic, so the last sample interpolates towards
+        // the first
+        const int index = static_cast<int>(phase >> 16);
+        const float frac = static_cast<float>(phase & 0xFFFF) * (1.0f / 65536.0f);
+        const float a = shape[index];
+        const float b = shape[(index + 1) & lengthMask];
+        line[(start + i) & mask] += (a + (b - a) * frac) * velocity;
+        phase += step;
+    }
+    remaining -= count;
+}
+
+const ExcitationTable& ExcitationTable::standard() {
+    static const ExcitationTable table { ExciterSettings{} };
+    return table;
+}
+
+} // namespace rgs
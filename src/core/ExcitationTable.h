@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Exciter.h"
+#include <cstdint>
+#include <vector>
+
+namespace rgs {
+
+/**
+ * What a strike sounds like: exciter type, hardness and position
+ */
+struct ExciterSettings {
+    Exciter::Type type = Exciter::Type::Pluck;
+    float hardness = 0.5f;   // 0-1
+    float position = 0.5f;   // 0.1-0.9 of the string
+
+    bool operator==(const ExciterSettings& other) const {
+        return type == other.type && hardness == other.hardness
+            && position == other.position;
+    }
+    bool operator!=(const ExciterSettings& other) const { return !(*this == other); }
+};
+
+/**
+ * Exciter output rendered ahead of time, one set per ExciterSettings
+ *
+ * Holds a shape for each of NUM_LAYERS velocity layers (softer layers
+ * render with less hardness) at every power-of-two length from
+ * MIN_LENGTH to MAX_LENGTH, normalised to the loudness of a uniform
+ * noise burst. A note-on takes the longest length that fits the node's
+ * loop and stretches it across the loop by linear interpolation: tables
+ * are only ever stretched, never shrunk, so the shape stays band-limited
+ * to the loop. No transcendentals or noise at note-on.
+ *
+ * A Strike delivers the stretched shape into a delay line in pieces, as
+ * the loop reaches it, so a burst of note-ons costs a few samples each
+ * per sample instead of whole loops in one go.
+ *
+ * Construction allocates and runs Exciter for every shape: build tables
+ * off the audio thread. A built table is immutable and can be shared by
+ * any number of graphs.
+ */
+class ExcitationTable {
+public:
+    static constexpr int NUM_LAYERS = 4;
+    static constexpr int MIN_LENGTH = 2;
+    static constexpr int MAX_LENGTH = 8192;
+
+    explicit ExcitationTable(const ExciterSettings& settings);
+
+    const ExciterSettings& getSettings() const { return settings; }
+
+    /**
+     * One note-on, delivered as the loop comes round to it
+     *
+     * Shape sample i goes lag samples behind the line's write position
+     * at time i: the slot the loop reads at time i, so the shape plays
+     * from its start. No read reaches a slot before then, so delivering
+     * a sample at a time sounds exactly like delivering it all at once.
+     */
+    struct Strike {
+        const float* shape = nullptr;
+        int lengthMask = 0;
+        int lag = 0;            // Loop length when struck
+        int remaining = 0;
+        uint32_t phase = 0;     // 16.16 position in shape
+        uint32_t step = 0;
+        float velocity = 0.0f;
+
+        bool active() const { return remaining > 0; }
+
+        // Add the next count samples (fewer at the end) to a line of
+        // mask + 1 samples whose write position is now writePos
+        void deliver(float* line, int mask, int writePos, int count);
+    };
+
+    // A strike of the given velocity (0-1) on a loop of loopLength samples.
+    // It reads this table: deliver it in full before the table goes away.
+    // A loop running at 1/decimation of the rate gets the shape for its
+    // length at full rate, read every decimation-th sample, so it keeps
+    // the same low-frequency content.
+    Strike strike(int loopLength, float velocity, int decimation = 1) const;
+
+    static int layerFor(float velocity);
+    static int lengthFor(int loopLength);
+    const float* getShape(int layer, int length) const;
+
+    // Plucks with the default settings, built on first use. Graphs touch
+    // it when constructed so the audio thread never builds it.
+    static const ExcitationTable& standard();
+
+private:
+    ExciterSettings settings;
+    std::vector<float> shapes;   // Per layer, every length back to back
+};
+
+} // namespace rgs
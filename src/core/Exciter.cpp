@@ -1,4 +1,5 @@
 #include "Exciter.h"
+#include "FastMath.h"
 #include <algorithm>
 
 namespace rgs {
@@ -13,25 +14,15 @@ void Exciter::generate(float* buffer, int numSamples, float velocity) {
             float lpfCoeff = 0.3f + hardness * 0.6f;
             float lpfState = 0.0f;
 
-            // Position affects the excitation shape
-            // Plucking near the bridge = brighter
-            // Plucking near center = fuller
-            float brightnessBoost = 1.0f - std::abs(position - 0.5f) * 2.0f;
-
             for (int i = 0; i < numSamples; i++) {
                 // Envelope: quick attack, short decay
-                float env = std::exp(-static_cast<float>(i) / (numSamples * 0.3f));
+                float env = fastmath::exp(-static_cast<float>(i) / (numSamples * 0.3f));
 
                 float noise = nextNoise();
 
                 // Lowpass based on hardness
                 lpfState = lpfCoeff * noise + (1.0f - lpfCoeff) * lpfState;
-                float sample = lpfState * env * velocity;
-
-                // Boost harmonics based on position
-                sample *= (0.7f + brightnessBoost * 0.3f);
-
-                buffer[i] = sample;
+                buffer[i] = lpfState * env * velocity;
             }
             break;
         }
@@ -47,15 +38,15 @@ void Exciter::generate(float* buffer, int numSamples, float velocity) {
                 // Raised cosine envelope
                 float env = 0.0f;
                 if (t < attackTime) {
-                    env = 0.5f * (1.0f - std::cos(3.14159f * t / attackTime));
+                    env = 0.5f * (1.0f - fastmath::cos(3.14159f * t / attackTime));
                 } else {
                     float decay = (t - attackTime) / (1.0f - attackTime);
-                    env = std::exp(-decay * 5.0f);
+                    env = fastmath::exp(-decay * 5.0f);
                 }
 
                 // Mix of noise and sine for strike
                 float noise = nextNoise();
-                float sine = std::sin(t * 3.14159f * 4.0f);
+                float sine = fastmath::sin(t * 3.14159f * 4.0f);
                 float mix = hardness * noise + (1.0f - hardness) * sine;
 
                 buffer[i] = mix * env * velocity;
@@ -63,6 +54,14 @@ void Exciter::generate(float* buffer, int numSamples, float velocity) {
             break;
         }
     }
+
+    // Position: exciting the string at a fraction p of its length cancels
+    // every harmonic that has a node there, a comb with a delay of p
+    // periods. Backwards so it can run in place.
+    const int offset = static_cast<int>(position * static_cast<float>(numSamples));
+    for (int i = numSamples - 1; i >= offset && offset > 0; i--) {
+        buffer[i] -= buffer[i - offset];
+    }
 }
 
 float Exciter::nextNoise() {
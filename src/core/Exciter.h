@@ -9,11 +9,16 @@ namespace rgs {
 /**
  * Excitation generator for resonators
  *
- * Generates the initial impulse that sets a resonator vibrating.
- * Different excitation types produce different timbres:
+ * Generates the initial impulse that sets a resonator vibrating, one
+ * period of the string long. Different excitation types produce
+ * different timbres:
  * - Pluck: Sharp attack, like a guitar pick
  * - Strike: Softer, like a hammer (piano, mallet)
  * - Bow: Sustained excitation (future)
+ *
+ * generate() costs an exp and a noise sample per sample, too much for a
+ * note-on: the audio thread reads ExcitationTable, rendered from this
+ * ahead of time.
  */
 class Exciter {
 public:
@@ -41,7 +46,7 @@ private:
     float nextNoise();
 
     Type type = Type::Pluck;
-    float position = 0.5f;   // Where on the string to excite (affects harmonics)
+    float position = 0.5f;   // Where on the string to excite (combs out harmonics)
     float hardness = 0.5f;   // Soft (muted) to hard (bright)
     uint32_t noiseState = 54321;
 };
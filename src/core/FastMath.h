@@ -0,0 +1,281 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace rgs::fastmath {
+
+/**
+ * Engine-wide accuracy of the transcendental functions in the audio path
+ *
+ * - Eco: cheaper approximations, errors around 1e-4
+ * - Normal: approximations at float precision (the default)
+ * - Reference: libm, for validating the other two
+ *
+ * The SIMD bank has no libm path: Reference runs the Normal tanh there,
+ * which is within 3.6e-7 of it.
+ */
+enum class Quality {
+    Eco,
+    Normal,
+    Reference
+};
+
+// Documented bounds, checked against libm by rgs_bench --accuracy.
+// tanh and sin: absolute error. pow2 and exp: relative error.
+constexpr float TANH_MAX_ERROR = 4e-7f;
+constexpr float TANH_ECO_MAX_ERROR = 8e-5f;
+constexpr float POW2_MAX_ERROR = 3e-7f;
+constexpr float POW2_ECO_MAX_ERROR = 1.1e-4f;
+constexpr float EXP_MAX_ERROR = 3e-7f;
+constexpr float EXP_ECO_MAX_ERROR = 1.1e-4f;
+constexpr float SIN_MAX_ERROR = 3e-7f;         // |x| <= 1000
+constexpr float SIN_ECO_MAX_ERROR = 1.2e-4f;
+
+// The vector forms take V, an operation set as in simd/BankKernel.h.
+// They are the only part of this header the per-ISA kernels may use:
+// the scalar functions below call the standard library.
+
+/**
+ * Rational tanh, max abs error 3.6e-7 against libm
+ *
+ * Odd 13th / even 6th order minimax fit, exact to float precision once
+ * the input is clamped to +-7.9053 where tanh rounds to +-1.
+ */
+template <class V>
+inline typename V::Vec tanh(typename V::Vec x) {
+    const auto limit = V::set1(7.90531110763549805f);
+    x = V::min(V::max(x, V::sub(V::zero(), limit)), limit);
+    const auto x2 = V::mul(x, x);
+
+    auto p = V::set1(-2.76076847742355e-16f);
+    p = V::madd(p, x2, V::set1(2.00018790482477e-13f));
+    p = V::madd(p, x2, V::set1(-8.60467152213735e-11f));
+    p = V::madd(p, x2, V::set1(5.12229709037114e-08f));
+    p = V::madd(p, x2, V::set1(1.48572235717979e-05f));
+    p = V::madd(p, x2, V::set1(6.37261928875436e-04f));
+    p = V::madd(p, x2, V::set1(4.89352455891786e-03f));
+    p = V::mul(p, x);
+
+    auto q = V::set1(1.19825839466702e-06f);
+    q = V::madd(q, x2, V::set1(1.18534705686654e-04f));
+    q = V::madd(q, x2, V::set1(2.26843463243900e-03f));
+    q = V::madd(q, x2, V::set1(4.89352455891786e-03f));
+
+    return V::div(p, q);
+}
+
+/**
+ * Eco tanh, max abs error 7.1e-5 against libm
+ *
+ * Lambert's continued fraction cut at 7th / 6th order, clamped to
+ * +-4.79 where it is closest to +-1. Five fewer multiply-adds.
+ */
+template <class V>
+inline typename V::Vec tanhEco(typename V::Vec x) {
+    const auto limit = V::set1(4.79f);
+    x = V::min(V::max(x, V::sub(V::zero(), limit)), limit);
+    const auto x2 = V::mul(x, x);
+
+    auto p = V::add(x2, V::set1(378.0f));
+    p = V::madd(p, x2, V::set1(17325.0f));
+    p = V::madd(p, x2, V::set1(135135.0f));
+    p = V::mul(p, x);
+
+    auto q = V::madd(V::set1(28.0f), x2, V::set1(3150.0f));
+    q = V::madd(q, x2, V::set1(62370.0f));
+    q = V::madd(q, x2, V::set1(135135.0f));
+
+    return V::div(p, q);
+}
+
+namespace detail {
+
+// Scalar operation set for the vector forms
+struct ScalarOps {
+    using Vec = float;
+    static Vec set1(float x) { return x; }
+    static Vec zero() { return 0.0f; }
+    static Vec add(Vec a, Vec b) { return a + b; }
+    static Vec sub(Vec a, Vec b) { return a - b; }
+    static Vec mul(Vec a, Vec b) { return a * b; }
+    static Vec div(Vec a, Vec b) { return a / b; }
+    static Vec madd(Vec a, Vec b, Vec c) { return a * b + c; }
+    static Vec min(Vec a, Vec b) { return b < a ? b : a; }
+    static Vec max(Vec a, Vec b) { return a < b ? b : a; }
+};
+
+// 2^n for integer n in [-126, 127]
+inline float exponent(int n) {
+    const uint32_t bits = static_cast<uint32_t>(n + 127) << 23;
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+// Round to nearest without a libm call
+inline int nearest(float x) {
+    return static_cast<int>(x + (x < 0.0f ? -0.5f : 0.5f));
+}
+
+// 2^f for f in [-0.5, 0.5], minimax polynomials (5th / 3rd order)
+inline float pow2Fraction(float f) {
+    float p = 1.3264776030144211e-3f;
+    p = p * f + 9.671513379284211e-3f;
+    p = p * f + 5.5507336134291e-2f;
+    p = p * f + 2.4022242070083247e-1f;
+    p = p * f + 6.931469776491546e-1f;
+    return p * f + 1.0f;
+}
+
+inline float pow2FractionEco(float f) {
+    float p = 5.5009198782406295e-2f;
+    p = p * f + 2.4221098974437436e-1f;
+    p = p * f + 6.932828896562359e-1f;
+    return p * f + 1.0f;
+}
+
+inline float clamp(float x, float lo, float hi) {
+    x = x < lo ? lo : x;
+    return x > hi ? hi : x;
+}
+
+// x = n ln 2 + r with r exact (two-part ln 2, Cody-Waite), so only
+// r log2 e rounds; returns n and sets f = r log2 e in about [-0.5, 0.5]
+inline int splitExp(float x, float& f) {
+    const int n = nearest(x * 1.44269504088896341f);
+    const float r = (x - static_cast<float>(n) * 0.693145751953125f)
+                  - static_cast<float>(n) * 1.42860682030941723e-6f;
+    f = r * 1.44269504088896341f;
+    return n;
+}
+
+// x reduced to [-pi/2, pi/2] with the same sine
+inline float reduceSin(float x) {
+    // Two-part 2 pi keeps the reduction exact for |x| up to ~1e3
+    const int k = nearest(x * 0.159154943091895336f);
+    float r = x - static_cast<float>(k) * 6.28125f;
+    r -= static_cast<float>(k) * 1.93530717958647692e-3f;
+
+    // sin(pi - r) = sin(r)
+    const float halfPi = 1.57079632679489662f;
+    const float pi = 3.14159265358979324f;
+    r = r > halfPi ? pi - r : r;
+    r = r < -halfPi ? -pi - r : r;
+    return r;
+}
+
+} // namespace detail
+
+// Scalar forms: only selects, no branches, so loops over them vectorise
+// (GCC needs -fno-trapping-math to if-convert the selects; rgs_core sets
+// it). Inputs are assumed finite.
+
+inline float tanh(float x) { return tanh<detail::ScalarOps>(x); }
+inline float tanhEco(float x) { return tanhEco<detail::ScalarOps>(x); }
+
+/**
+ * 2^x, max rel error 1.8e-7 (Eco: 1.0e-4)
+ *
+ * The nearest integer n goes into the exponent bits, the remainder in
+ * [-0.5, 0.5] through a polynomial. x is clamped to [-126, 127], the
+ * normal float range.
+ */
+inline float pow2(float x) {
+    x = detail::clamp(x, -126.0f, 127.0f);
+    const int n = detail::nearest(x);
+    return detail::pow2Fraction(x - static_cast<float>(n)) * detail::exponent(n);
+}
+
+inline float pow2Eco(float x) {
+    x = detail::clamp(x, -126.0f, 127.0f);
+    const int n = detail::nearest(x);
+    return detail::pow2FractionEco(x - static_cast<float>(n)) * detail::exponent(n);
+}
+
+/**
+ * e^x, max rel error 3e-7 (Eco: 1.1e-4)
+ *
+ * Same polynomial as pow2 after an exact reduction by ln 2. x is
+ * clamped to [-87, 88], the normal float range.
+ */
+inline float exp(float x) {
+    float f;
+    const int n = detail::splitExp(detail::clamp(x, -87.0f, 88.0f), f);
+    return detail::pow2Fraction(f) * detail::exponent(n);
+}
+
+inline float expEco(float x) {
+    float f;
+    const int n = detail::splitExp(detail::clamp(x, -87.0f, 88.0f), f);
+    return detail::pow2FractionEco(f) * detail::exponent(n);
+}
+
+/**
+ * sin(x), max abs error 3e-7 for |x| <= 1000 (Eco: 1.2e-4)
+ *
+ * Reduced to [-pi/2, pi/2], then an odd minimax polynomial
+ * (9th / 5th order).
+ */
+inline float sin(float x) {
+    const float r = detail::reduceSin(x);
+    const float r2 = r * r;
+
+    float p = 2.6000547336660507e-6f;
+    p = p * r2 - 1.980661517892226e-4f;
+    p = p * r2 + 8.33301729108941e-3f;
+    p = p * r2 - 1.6666657096472975e-1f;
+    return r + r * r2 * p;
+}
+
+inline float sinEco(float x) {
+    const float r = detail::reduceSin(x);
+    const float r2 = r * r;
+
+    float p = 7.633771692026173e-3f;
+    p = p * r2 - 1.6607862046904515e-1f;
+    return r + r * r2 * p;
+}
+
+inline float cos(float x) { return sin(x + 1.57079632679489662f); }
+inline float cosEco(float x) { return sinEco(x + 1.57079632679489662f); }
+
+// Quality-selected scalar forms
+inline float tanh(Quality q, float x) {
+    switch (q) {
+        case Quality::Eco:       return tanhEco(x);
+        case Quality::Normal:    return tanh(x);
+        case Quality::Reference: break;
+    }
+    return std::tanh(x);
+}
+
+inline float exp(Quality q, float x) {
+    switch (q) {
+        case Quality::Eco:       return expEco(x);
+        case Quality::Normal:    return exp(x);
+        case Quality::Reference: break;
+    }
+    return std::exp(x);
+}
+
+inline float sin(Quality q, float x) {
+    switch (q) {
+        case Quality::Eco:       return sinEco(x);
+        case Quality::Normal:    return sin(x);
+        case Quality::Reference: break;
+    }
+    return std::sin(x);
+}
+
+inline float pow2(Quality q, float x) {
+    switch (q) {
+        case Quality::Eco:       return pow2Eco(x);
+        case Quality::Normal:    return pow2(x);
+        case Quality::Reference: break;
+    }
+    return std::exp2(x);
+}
+
+} // namespace rgs::fastmath
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+namespace rgs {
+
+/**
+ * A request from a non-audio thread, applied by the audio thread
+ *
+ * Posted through ResonatorGraph::post() and drained at the start of the
+ * next processBlock, so GUI notes never touch engine state while it is
+ * being rendered. Coupling edits are compiled off the audio thread
+ * instead (ResonatorGraph::setCoupling).
+ */
+struct GraphCommand {
+    enum class Type : uint8_t {
+        NoteOn,        // note, value = velocity
+        NoteOff,       // note
+        Reset          // silence every node
+    };
+
+    Type type = Type::Reset;
+    int a = 0;          // Note
+    float value = 0.0f;
+
+    static GraphCommand noteOn(int note, float velocity) {
+        return { Type::NoteOn, note, velocity };
+    }
+
+    static GraphCommand noteOff(int note) {
+        return { Type::NoteOff, note, 0.0f };
+    }
+
+    static GraphCommand reset() {
+        return { Type::Reset, 0, 0.0f };
+    }
+};
+
+} // namespace rgs
@@ -0,0 +1,96 @@
+#include "GraphPartition.h"
+#include <algorithm>
+
+namespace rgs {
+
+namespace {
+
+// Bounds build() on the audio thread; real topologies settle in a few
+constexpr int MAX_SWAPS = 4 * GraphPartition::MAX_GROUPS;
+
+// Smaller gains are rounding, not a better cut
+constexpr float MIN_GAIN = 1e-6f;
+
+} // namespace
+
+void GraphPartition::build(int numNodes, const int* edgeStart, const int* edgeTarget,
+                           const float* edgeWeight, int parts) {
+    numGroups = std::clamp((numNodes + NodeBank::SLEEP_GROUP - 1) / NodeBank::SLEEP_GROUP, 1, MAX_GROUPS);
+    numParts = std::clamp(parts, 1, numGroups);
+
+    // Edges inside a group never cross a cut and are left out
+    weights.fill(0.0f);
+    for (int src = 0; src < numNodes; src++) {
+        const int a = src / NodeBank::SLEEP_GROUP;
+        for (int e = edgeStart[src]; e < edgeStart[src + 1]; e++) {
+            const int b = edgeTarget[e] / NodeBank::SLEEP_GROUP;
+            if (a != b) {
+                weightAt(a, b) += edgeWeight[e];
+                weightAt(b, a) += edgeWeight[e];
+            }
+        }
+    }
+
+    // Contiguous runs, the first numGroups % numParts one group longer
+    for (int g = 0; g < numGroups; g++) {
+        partOf[g] = g * numParts / numGroups;
+    }
+
+    auto updateLinks = [this] {
+        links.fill(0.0f);
+        cutWeight = 0.0f;
+        for (int g = 0; g < numGroups; g++) {
+            for (int h = 0; h < numGroups; h++) {
+                linkAt(g, partOf[h]) += weightAt(g, h);
+                if (h > g && partOf[h] != partOf[g]) {
+                    cutWeight += weightAt(g, h);
+                }
+            }
+        }
+    };
+    updateLinks();
+
+    // Best single swap each round, until none helps
+    for (int swaps = 0; swaps < MAX_SWAPS && numParts > 1; swaps++) {
+        float bestGain = MIN_GAIN;
+        int bestA = -1;
+        int bestB = -1;
+
+        for (int a = 0; a < numGroups; a++) {
+            for (int b = a + 1; b < numGroups; b++) {
+                const int p = partOf[a];
+                const int q = partOf[b];
+                if (p == q) {
+                    continue;
+                }
+                const float gain = linkAt(a, q) - linkAt(a, p) + linkAt(b, p) - linkAt(b, q)
+                                 - 2.0f * weightAt(a, b);
+                if (gain > bestGain) {
+                    bestGain = gain;
+                    bestA = a;
+                    bestB = b;
+                }
+            }
+        }
+
+        if (bestA < 0) {
+            break;
+        }
+        std::swap(partOf[bestA], partOf[bestB]);
+        updateLinks();
+    }
+
+    // Group lists per part, ascending
+    int next = 0;
+    for (int p = 0; p < numParts; p++) {
+        partStart[p] = next;
+        for (int g = 0; g < numGroups; g++) {
+            if (partOf[g] == p) {
+                order[next++] = g;
+            }
+        }
+    }
+    partStart[numParts] = next;
+}
+
+} // namespace rgs
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "NodeBank.h"
+#include <array>
+
+namespace rgs {
+
+/**
+ * Splits a graph's sleep groups into equal parts with few edges between
+ * them, one part per task when ResonatorGraph spreads a sub-block over a
+ * WorkerPool
+ *
+ * Groups are the unit because they are what the bank processes and what
+ * sleeps. build() starts from contiguous runs of groups (topology
+ * intervals are short in pitch, so neighbours mostly share a run), then
+ * swaps single groups between parts in the manner of Kernighan-Lin while
+ * a swap lowers the weight of the cut. Sizes never change, and equal
+ * inputs give the same parts.
+ *
+ * Fixed storage: build() is realtime safe and can follow every coupling
+ * change.
+ */
+class GraphPartition {
+public:
+    static constexpr int MAX_GROUPS = 32;   // ResonatorGraph::MAX_NODES / SLEEP_GROUP
+
+    // Coupling in compressed sparse rows by source node, as
+    // CompiledTopology holds it. numParts is clamped to the groups.
+    void build(int numNodes, const int* edgeStart, const int* edgeTarget, const float* edgeWeight,
+               int numParts);
+
+    int getNumParts() const { return numParts; }
+    int getNumGroups() const { return numGroups; }
+
+    // Groups of a part in ascending order
+    int getPartSize(int part) const { return partStart[part + 1] - partStart[part]; }
+    const int* getPartGroups(int part) const { return order.data() + partStart[part]; }
+    int getPartOf(int group) const { return partOf[group]; }
+
+    // Summed weight of the edges between parts
+    float getCutWeight() const { return cutWeight; }
+
+private:
+    float& weightAt(int a, int b) { return weights[static_cast<size_t>(a * MAX_GROUPS + b)]; }
+    float& linkAt(int group, int part) { return links[static_cast<size_t>(group * MAX_GROUPS + part)]; }
+
+    int numGroups = 0;
+    int numParts = 0;
+    float cutWeight = 0.0f;
+
+    // Symmetric group-to-group coupling, both directions summed
+    std::array<float, MAX_GROUPS * MAX_GROUPS> weights {};
+
+    // Weight from each group into each part
+    std::array<float, MAX_GROUPS * MAX_GROUPS> links {};
+
+    std::array<int, MAX_GROUPS> partOf {};
+    std::array<int, MAX_GROUPS> order {};
+    std::array<int, MAX_GROUPS + 1> partStart {};
+};
+
+} // namespace rgs
@@ -0,0 +1,104 @@
+#include "HalfBand.h"
+#include "NodeBank.h"
+#include <algorithm>
+
+namespace rgs {
+
+namespace simd {
+
+namespace {
+
+// Scalar stand-ins for the vector operations the filters use
+struct ScalarOps {
+    using Vec = float;
+    static constexpr int WIDTH = 1;
+
+    static Vec load(const float* p) { return *p; }
+    static void store(float* p, Vec v) { *p = v; }
+    static Vec set1(float x) { return x; }
+    static Vec add(Vec a, Vec b) { return a + b; }
+    static Vec sub(Vec a, Vec b) { return a - b; }
+    static Vec mul(Vec a, Vec b) { return a * b; }
+    static Vec madd(Vec a, Vec b, Vec c) { return a * b + c; }
+};
+
+} // namespace
+
+void decimateScalar(HalfBandLanes& lanes) {
+    decimateWith<ScalarOps>(lanes);
+}
+
+void interpolateScalar(HalfBandLanes& lanes) {
+    interpolateWith<ScalarOps>(lanes);
+}
+
+} // namespace simd
+
+namespace {
+
+simd::HalfBandKernel kernelFor(simd::Isa isa, bool interpolating) {
+#if RGS_SIMD_X86
+    switch (isa) {
+        case simd::Isa::Avx512: return interpolating ? simd::interpolateAvx512 : simd::decimateAvx512;
+        case simd::Isa::Avx2:   return interpolating ? simd::interpolateAvx2 : simd::decimateAvx2;
+        case simd::Isa::Sse2:   return interpolating ? simd::interpolateSse2 : simd::decimateSse2;
+        case simd::Isa::Scalar: break;
+    }
+#else
+    (void) isa;
+#endif
+    return interpolating ? simd::interpolateScalar : simd::decimateScalar;
+}
+
+} // namespace
+
+void HalfBandFilter::prepare(int numLanes) {
+    lanes = numLanes;
+    states.allocate(static_cast<size_t>(simd::HALF_BAND_STATE_ROWS * lanes));
+    kernel = kernelFor(simd::getActiveIsa(), interpolating);
+}
+
+void HalfBandFilter::reset() {
+    states.clear();
+}
+
+void HalfBandFilter::clearLane(int lane) {
+    for (int r = 0; r < simd::HALF_BAND_STATE_ROWS; r++) {
+        states[static_cast<size_t>(r * lanes + lane)] = 0.0f;
+    }
+}
+
+void HalfBandFilter::run(const float* in0, const float* in1, float* out0, float* out1,
+                         const uint8_t* awakeGroups) {
+    constexpr int group = NodeBank::SLEEP_GROUP;
+    const int numGroups = lanes / group;
+    for (int g = 0; g < numGroups;) {
+        if (!awakeGroups[g]) {
+            std::fill_n(out0 + g * group, group, 0.0f);
+            if (out1 != nullptr) {
+                std::fill_n(out1 + g * group, group, 0.0f);
+            }
+            g++;
+            continue;
+        }
+        int end = g + 1;
+        while (end < numGroups && awakeGroups[end]) {
+            end++;
+        }
+
+        // One kernel call per run, offset like ResonatorBank::runView
+        const int first = g * group;
+        simd::HalfBandLanes view;
+        view.states = states.data() + first;
+        view.stateStride = lanes;
+        view.in0 = in0 + first;
+        view.in1 = in1 != nullptr ? in1 + first : nullptr;
+        view.out0 = out0 + first;
+        view.out1 = out1 != nullptr ? out1 + first : nullptr;
+        view.numLanes = (end - g) * group;
+        kernel(view);
+        g = end;
+    }
+}
+
+} // namespace rgs
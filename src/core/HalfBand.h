@@ -0,0 +1,70 @@
+#pragma once
+
+#include "AlignedBuffer.h"
+#include "simd/CpuFeatures.h"
+#include "simd/HalfBandKernel.h"
+#include <cstdint>
+
+namespace rgs {
+
+/**
+ * 2:1 rate changes for a block of lanes, with a polyphase IIR half-band
+ *
+ * Two chains of first-order allpass sections at the lower rate whose
+ * outputs are averaged (decimator) or interleaved (interpolator). The
+ * response is flat within 0.001 dB up to PASSBAND of the higher rate and
+ * at least 63 dB down from 0.29, for simd::HALF_BAND_STAGES multiplies per
+ * lower-rate sample. The group delay is about 2 higher-rate samples at low
+ * frequencies, rising to 5.6 at the passband edge; a linear-phase FIR with
+ * the same rejection would need ~11 and several times the arithmetic.
+ *
+ * Rows are lanes wide (structure-of-arrays) in whole sleep groups and run
+ * through the per-ISA kernels picked at prepare(), as ResonatorBank does.
+ * A sleeping group (zero in, zero state) is skipped and reads as zero.
+ */
+class HalfBandFilter {
+public:
+    static constexpr float PASSBAND = 0.21f;   // Of the higher rate
+
+    // Picks the kernel for simd::getActiveIsa()
+    void prepare(int numLanes);
+    void reset();
+    void clearLane(int lane);
+
+protected:
+    explicit HalfBandFilter(bool interpolating) : interpolating(interpolating) {}
+
+    // The kernel over every run of awake groups; rows of sleeping groups
+    // in out0 (and out1 when given) are zeroed
+    void run(const float* in0, const float* in1, float* out0, float* out1,
+             const uint8_t* awakeGroups);
+
+private:
+    bool interpolating;
+    simd::HalfBandKernel kernel = simd::decimateScalar;
+    AlignedBuffer<float> states;
+    int lanes = 0;
+};
+
+class HalfBandDecimator : public HalfBandFilter {
+public:
+    HalfBandDecimator() : HalfBandFilter(false) {}
+
+    // Two consecutive input rows in, one output row out
+    void process(const float* in0, const float* in1, float* out, const uint8_t* awakeGroups) {
+        run(in0, in1, out, nullptr, awakeGroups);
+    }
+};
+
+// The matching 1:2 interpolator
+class HalfBandInterpolator : public HalfBandFilter {
+public:
+    HalfBandInterpolator() : HalfBandFilter(true) {}
+
+    // One input row in, two consecutive output rows out
+    void process(const float* in, float* out0, float* out1, const uint8_t* awakeGroups) {
+        run(in, nullptr, out0, out1, awakeGroups);
+    }
+};
+
+} // namespace rgs
@@ -0,0 +1,281 @@
+#include "ModalBank.h"
+#include "Resonator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace rgs {
+
+namespace simd {
+
+namespace {
+
+// Scalar stand-ins for the vector operations the modes use
+struct ScalarOps {
+    using Vec = float;
+    using Mask = bool;
+    static constexpr int WIDTH = 1;
+
+    static Vec load(const float* p) { return *p; }
+    static void store(float* p, Vec v) { *p = v; }
+    static Vec set1(float x) { return x; }
+    static Vec zero() { return 0.0f; }
+
+    static Vec add(Vec a, Vec b) { return a + b; }
+    static Vec sub(Vec a, Vec b) { return a - b; }
+    static Vec mul(Vec a, Vec b) { return a * b; }
+    static Vec div(Vec a, Vec b) { return a / b; }
+    static Vec madd(Vec a, Vec b, Vec c) { return a * b + c; }
+    static Vec min(Vec a, Vec b) { return b < a ? b : a; }
+    static Vec max(Vec a, Vec b) { return a < b ? b : a; }
+    static Vec abs(Vec a) { return std::abs(a); }
+
+    static Mask greater(Vec a, Vec b) { return a > b; }
+    static Mask notNan(Vec a) { return a == a; }
+    static Vec select(Mask m, Vec a, Vec b) { return m ? a : b; }
+};
+
+} // namespace
+
+void processModalScalar(ModalLanes& lanes) {
+    processModal<ScalarOps>(lanes);
+}
+
+} // namespace simd
+
+namespace {
+
+simd::ModalKernel kernelFor(simd::Isa isa) {
+#if RGS_SIMD_X86
+    switch (isa) {
+        case simd::Isa::Avx512: return simd::processModalAvx512;
+        case simd::Isa::Avx2:   return simd::processModalAvx2;
+        case simd::Isa::Sse2:   return simd::processModalSse2;
+        case simd::Isa::Scalar: break;
+    }
+#else
+    (void) isa;
+#endif
+    return simd::processModalScalar;
+}
+
+} // namespace
+
+void ModalBank::prepare(double sr, int nodes, const float*) {
+    sampleRate = sr;
+    numNodes = nodes;
+    numLanes = (nodes + simd::MAX_WIDTH - 1) / simd::MAX_WIDTH * simd::MAX_WIDTH;
+
+    const auto lanes = static_cast<size_t>(numLanes);
+    modes.allocate(lanes / simd::MAX_WIDTH * simd::MODAL_TILE);
+    for (auto* buffer : { &energy, &output, &clipped, &lastDrive, &input, &frequency, &damping, &lpfCoeff }) {
+        buffer->allocate(lanes);
+    }
+    loopLength.assign(lanes, 0.0);
+    dampingDecay.assign(lanes, 0.0);
+    modeCos.assign(lanes * simd::MODAL_MODES, 0.0);
+    modeDecay.assign(lanes * simd::MODAL_MODES, 0.0);
+    strikes.clear();
+    strikes.reserve(lanes * STRIKES_PER_NODE);
+
+    // Same defaults as Resonator; padding lanes keep zero coefficients
+    for (int i = 0; i < numNodes; i++) {
+        frequency[i] = 440.0f;
+        damping[i] = 0.998f;
+        setBrightness(i, 0.8f);
+    }
+
+    isa = simd::getActiveIsa();
+    kernel = kernelFor(isa);
+
+    view.modes = modes.data();
+    view.input = input.data();
+    view.clipped = clipped.data();
+    view.lastDrive = lastDrive.data();
+    view.energy = energy.data();
+    view.output = output.data();
+    view.numLanes = numLanes;
+    view.energyDecay = 0.9995f;
+
+    reset();
+}
+
+void ModalBank::setFrequency(int node, float freq) {
+    frequency[node] = std::clamp(freq, Resonator::MIN_FREQUENCY, Resonator::MAX_FREQUENCY);
+    updateModes(node);
+}
+
+void ModalBank::setDamping(int node, float d) {
+    // Ramps land here for every node each control block: one pow, no
+    // per-mode libm calls
+    damping[node] = std::clamp(d, 0.9f, 0.9999f);
+    updateDamping(node);
+    writeModes(node);
+}
+
+void ModalBank::setBrightness(int node, float b) {
+    // The KS loop lowpass this node's decay follows
+    lpfCoeff[node] = 0.2f + std::clamp(b, 0.0f, 1.0f) * 0.8f;
+    updateModes(node);
+}
+
+void ModalBank::updateModes(int node) {
+    const auto n = static_cast<size_t>(node);
+    const double c = lpfCoeff[node];
+    const double q = 1.0 - c;
+    const double pi = 3.14159265358979323846;
+
+    // The loop ResonatorBank builds for this pitch: a fractional delay
+    // read by linear interpolation, plus the lowpass's ~(1 - c) / c
+    const double delay = sampleRate / frequency[node] - 0.5;
+    const double frac = delay - std::floor(delay);
+    loopLength[n] = delay + q / c;
+
+    for (int m = 0; m < simd::MODAL_MODES; m++) {
+        const auto at = n * simd::MODAL_MODES + static_cast<size_t>(m);
+        const double modeFrequency = (m + 1) * static_cast<double>(frequency[node]);
+        if (modeFrequency >= MAX_MODE_FREQUENCY * sampleRate) {
+            modeCos[at] = 1.0;
+            modeDecay[at] = 0.0;
+            continue;
+        }
+
+        // Each trip round the loop, harmonic k loses the gains of the
+        // lowpass and the interpolation at its frequency (and the damping)
+        const double w = 2.0 * pi * modeFrequency / sampleRate;
+        const double cosW = std::cos(w);
+        const double lowpassLoss = std::log(c) - 0.5 * std::log(1.0 - 2.0 * q * cosW + q * q);
+        const double interpolationLoss = 0.5 * std::log(1.0 - 2.0 * frac * (1.0 - frac) * (1.0 - cosW));
+        modeCos[at] = cosW;
+        modeDecay[at] = std::exp((lowpassLoss + interpolationLoss) / loopLength[n]);
+    }
+
+    updateDamping(node);
+    writeModes(node);
+}
+
+void ModalBank::updateDamping(int node) {
+    const auto n = static_cast<size_t>(node);
+    dampingDecay[n] = std::pow(static_cast<double>(damping[node]), 1.0 / loopLength[n]);
+}
+
+void ModalBank::writeModes(int node) {
+    const auto n = static_cast<size_t>(node);
+    const double period = sampleRate / frequency[node];
+
+    for (int m = 0; m < simd::MODAL_MODES; m++) {
+        const auto at = n * simd::MODAL_MODES + static_cast<size_t>(m);
+        const double r = dampingDecay[n] * modeDecay[at];
+
+        // Impulse response gain r^n cos(n w), in phase with an impulse
+        // added to the KS line: a period of drive with spectrum X then
+        // rings at 2 |X| / period, as the KS harmonic does
+        modes[simd::modeIndex(node, m, simd::MODE_A1)] = static_cast<float>(2.0 * r * modeCos[at]);
+        modes[simd::modeIndex(node, m, simd::MODE_A2)] = static_cast<float>(-r * r);
+        modes[simd::modeIndex(node, m, simd::MODE_GAIN)] = modeDecay[at] > 0.0 ? static_cast<float>(2.0 / period) : 0.0f;
+    }
+}
+
+void ModalBank::setQuality(fastmath::Quality quality) {
+    view.ecoTanh = quality == fastmath::Quality::Eco;
+}
+
+void ModalBank::excite(int node, const ExcitationTable& table, float velocity) {
+    // One loop period of the shape, as the KS node would take it. Strikes
+    // on a node add up, as they do in its line; with the list full, the
+    // new one takes the place of one on the same node (or the oldest)
+    const int period = static_cast<int>(std::lround(sampleRate / frequency[node]));
+    const Strike strike { node, table.strike(std::max(period, 2), velocity) };
+    if (strikes.size() < strikes.capacity()) {
+        strikes.push_back(strike);
+    } else if (!strikes.empty()) {
+        auto same = std::find_if(strikes.begin(), strikes.end(),
+                                 [node](const Strike& s) { return s.node == node; });
+        *(same != strikes.end() ? same : strikes.begin()) = strike;
+    }
+    energy[node] = std::max(energy[node], std::abs(velocity));
+}
+
+void ModalBank::finishStrikes() {
+    strikes.clear();
+}
+
+void ModalBank::process(const float* in, const uint8_t* awakeGroups) {
+    const int numGroups = numLanes / SLEEP_GROUP;
+    for (int g = 0; g < numGroups; g++) {
+        if (awakeGroups[g]) {
+            const int first = g * SLEEP_GROUP;
+            const int inputs = std::min(SLEEP_GROUP, numNodes - first);
+            std::memcpy(input.data() + first, in + first, sizeof(float) * static_cast<size_t>(inputs));
+        }
+    }
+
+    // This sample of every strike in flight, added to its node's drive
+    for (size_t s = 0; s < strikes.size();) {
+        auto& strike = strikes[s];
+        float drive = 0.0f;
+        strike.shape.deliver(&drive, 0, 0, 1);
+        input[strike.node] += drive;
+        if (strike.shape.active()) {
+            s++;
+        } else {
+            strike = strikes.back();
+            strikes.pop_back();
+        }
+    }
+
+    // One kernel call per run of consecutive awake groups
+    for (int g = 0; g < numGroups;) {
+        if (!awakeGroups[g]) {
+            g++;
+            continue;
+        }
+        int end = g + 1;
+        while (end < numGroups && awakeGroups[end]) {
+            end++;
+        }
+
+        const int first = g * SLEEP_GROUP;
+        simd::ModalLanes run = view;
+        run.modes += simd::modeIndex(first, 0, 0);
+        run.input += first;
+        run.clipped += first;
+        run.lastDrive += first;
+        run.energy += first;
+        run.output += first;
+        run.numLanes = (end - g) * SLEEP_GROUP;
+        kernel(run);
+        g = end;
+    }
+}
+
+void ModalBank::clearModes(int node) {
+    for (int m = 0; m < simd::MODAL_MODES; m++) {
+        modes[simd::modeIndex(node, m, simd::MODE_Y1)] = 0.0f;
+        modes[simd::modeIndex(node, m, simd::MODE_Y2)] = 0.0f;
+    }
+}
+
+void ModalBank::silence(int node) {
+    clearModes(node);
+    energy[node] = 0.0f;
+    output[node] = 0.0f;
+    clipped[node] = 0.0f;
+    lastDrive[node] = 0.0f;
+    strikes.erase(std::remove_if(strikes.begin(), strikes.end(),
+                                 [node](const Strike& s) { return s.node == node; }),
+                  strikes.end());
+}
+
+void ModalBank::reset() {
+    for (int i = 0; i < numLanes; i++) {
+        clearModes(i);
+    }
+    energy.clear();
+    output.clear();
+    clipped.clear();
+    lastDrive.clear();
+    strikes.clear();
+}
+
+} // namespace rgs
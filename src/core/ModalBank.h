@@ -0,0 +1,112 @@
+#pragma once
+
+#include "AlignedBuffer.h"
+#include "NodeBank.h"
+#include "simd/CpuFeatures.h"
+#include "simd/ModalKernel.h"
+#include <cstdint>
+#include <vector>
+
+namespace rgs {
+
+/**
+ * Modal bank: each node a set of damped sinusoids (Engine::Modal)
+ *
+ * Instead of a delay line, a node is simd::MODAL_MODES two-pole
+ * resonators at the first harmonics of its pitch. State is a few floats
+ * per mode whatever the pitch, and every node runs the same arithmetic,
+ * so one kernel call advances the same mode of 4/8/16 nodes per
+ * instruction with no gather or scatter. Cost is flat across the
+ * keyboard and memory does not grow with low notes.
+ *
+ * Modes are tuned to behave like the Karplus-Strong loop ResonatorBank
+ * builds for the same settings:
+ * - mode k loses what harmonic k loses each trip round the loop (damping,
+ *   lowpass, interpolation), spread over the loop's length
+ * - drive (strikes and coupling) rings mode k in phase with, and at the
+ *   level of, harmonic k of the same samples added to the line
+ * - the sum goes through the same soft clamp, and what the clamp takes
+ *   off is fed back as drive, as the loop writes the clamped sample back
+ * - modes at or above MAX_MODE_FREQUENCY of the sample rate are off
+ *
+ * So levels and decay times follow Engine::Simd for the partials both
+ * have, within a dB or two. What differs:
+ * - nothing above the last mode: bright plucks of low notes lose most of
+ *   their energy (A0 sounds ~14 dB quieter at first)
+ * - the attack builds up over the strike's period instead of starting
+ *   at once, and coupling reaches a node only near its modes, so dense
+ *   topologies sustain less
+ *
+ * Strikes are fed in a sample at a time as the node processes, and
+ * strikes on the same node add up. Those still in flight at
+ * finishStrikes() are cut short, since a resonator cannot take its input
+ * ahead of time; the modes keep ringing from where they are.
+ *
+ * Frequency and brightness changes recompute the modes, a few libm calls
+ * each; damping changes (ramps included) cost one pow per node.
+ */
+class ModalBank : public NodeBank {
+public:
+    static constexpr float MAX_MODE_FREQUENCY = 0.45f;   // Of the sample rate
+    static constexpr int STRIKES_PER_NODE = 4;           // In flight, on average
+
+    void prepare(double sampleRate, int numNodes, const float* lowestFrequencies) override;
+
+    void setFrequency(int node, float freq) override;
+    void setDamping(int node, float damping) override;
+    void setBrightness(int node, float brightness) override;
+
+    // Eco selects fastmath::tanhEco for the output clamp
+    void setQuality(fastmath::Quality quality) override;
+
+    void excite(int node, const ExcitationTable& table, float velocity) override;
+    void finishStrikes() override;
+    void process(const float* input, const uint8_t* awakeGroups) override;
+    void silence(int node) override;
+
+    const float* getEnergies() const override { return energy.data(); }
+    const float* getOutputs() const override { return output.data(); }
+
+    void reset() override;
+
+    simd::Isa getIsa() const { return isa; }
+
+private:
+    void updateModes(int node);
+    void updateDamping(int node);
+    void writeModes(int node);
+    void clearModes(int node);
+
+    double sampleRate = 44100.0;
+    int numNodes = 0;
+    int numLanes = 0;
+
+    // Mode state and coefficients, in tiles (simd::modeIndex())
+    AlignedBuffer<float> modes;
+
+    // Lane state
+    AlignedBuffer<float> energy, output, clipped, lastDrive;
+    AlignedBuffer<float> input;
+
+    // Control-rate per-node values (not touched by the kernel)
+    AlignedBuffer<float> frequency, damping, lpfCoeff;
+    std::vector<double> loopLength, dampingDecay;
+
+    // Per node and mode (node * MODAL_MODES + mode): cos w, and the decay
+    // per sample from all but the damping (0: the mode is off)
+    std::vector<double> modeCos, modeDecay;
+
+    // Strikes in flight (unordered), up to STRIKES_PER_NODE per lane
+    struct Strike {
+        int node;
+        ExcitationTable::Strike shape;
+    };
+    std::vector<Strike> strikes;
+
+    simd::ModalLanes view {};
+
+    simd::Isa isa = simd::Isa::Scalar;
+    simd::ModalKernel kernel = simd::processModalScalar;
+};
+
+} // namespace rgs
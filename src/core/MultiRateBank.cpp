@@ -0,0 +1,236 @@
+#include "MultiRateBank.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace rgs {
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+
+// Highest frequency the loop lowpass keeps: where one pass through it
+// halves the amplitude, or Nyquist if it never does
+double loopBandwidth(double sampleRate, float brightness) {
+    // Same coefficient as Resonator::setBrightness
+    const double a = 0.2 + 0.8 * std::clamp(static_cast<double>(brightness), 0.0, 1.0);
+    if (a >= 2.0 / 3.0) {
+        return sampleRate * 0.5;
+    }
+
+    // |a / (1 - p e^-jw)| = 0.5 with p = 1 - a
+    const double p = 1.0 - a;
+    const double cosW = (1.0 + p * p - 4.0 * a * a) / (2.0 * p);
+    return std::acos(std::clamp(cosW, -1.0, 1.0)) / (2.0 * PI) * sampleRate;
+}
+
+} // namespace
+
+int MultiRateBank::chooseDivider(double sampleRate, float highestFrequency, float brightness) {
+    const double bandwidth = std::min(loopBandwidth(sampleRate, brightness),
+                                      static_cast<double>(AUDIBLE_BANDWIDTH));
+
+    int divider = 1;
+    while (divider < MAX_DIVIDER) {
+        // The next 2:1 stage runs from sampleRate / divider down
+        const double stageRate = sampleRate / divider;
+        if (bandwidth > HalfBandFilter::PASSBAND * stageRate) {
+            break;
+        }
+        if (stageRate * 0.5 / highestFrequency < MIN_LOOP) {
+            break;
+        }
+        divider *= 2;
+    }
+    return divider;
+}
+
+void MultiRateBank::planRates(double sampleRate, int nodes, const float* highestFrequencies,
+                              float brightness) {
+    const int numGroups = (nodes + SLEEP_GROUP - 1) / SLEEP_GROUP;
+    plannedDividers.assign(static_cast<size_t>(numGroups), MAX_DIVIDER);
+    for (int i = 0; i < nodes; i++) {
+        int& divider = plannedDividers[static_cast<size_t>(i / SLEEP_GROUP)];
+        divider = std::min(divider, chooseDivider(sampleRate, highestFrequencies[i], brightness));
+    }
+    for (int g = 1; g < numGroups; g++) {
+        plannedDividers[g] = std::min(plannedDividers[g], plannedDividers[g - 1]);
+    }
+}
+
+int MultiRateBank::getDivider(int node) const {
+    return classes[groupClass[static_cast<size_t>(node / SLEEP_GROUP)]].divider;
+}
+
+void MultiRateBank::prepare(double sampleRate, int nodes, const float* lowestFrequencies) {
+    const int numGroups = (nodes + SLEEP_GROUP - 1) / SLEEP_GROUP;
+    if (static_cast<int>(plannedDividers.size()) != numGroups) {
+        plannedDividers.assign(static_cast<size_t>(numGroups), 1);
+    }
+    groupClass.assign(static_cast<size_t>(numGroups), 0);
+
+    // Dividers fall along the groups: slowest run first. Only the last
+    // group can be partial, and it ends the last run.
+    int group = 0;
+    for (int k = 0; k < static_cast<int>(classes.size()); k++) {
+        RateClass& c = classes[static_cast<size_t>(k)];
+        c.divider = MAX_DIVIDER >> k;
+        c.firstGroup = group;
+        while (group < numGroups && plannedDividers[static_cast<size_t>(group)] == c.divider) {
+            groupClass[static_cast<size_t>(group)] = static_cast<uint8_t>(k);
+            group++;
+        }
+        c.numGroups = group - c.firstGroup;
+        c.firstNode = c.firstGroup * SLEEP_GROUP;
+        c.numNodes = std::min(group * SLEEP_GROUP, nodes) - c.firstNode;
+        c.numLanes = c.numGroups * SLEEP_GROUP;
+
+        c.bank.setRateDivider(c.divider);
+        c.bank.prepare(sampleRate / c.divider, c.numNodes, lowestFrequencies + c.firstNode);
+
+        const auto lanes = static_cast<size_t>(c.numLanes);
+        c.inputRows.allocate(lanes * static_cast<size_t>(c.divider));
+        c.outputRows.allocate(lanes * static_cast<size_t>(c.divider));
+        c.midRows.allocate(lanes * 2);
+        c.slowInput.allocate(lanes);
+        for (auto& d : c.decimators) {
+            d.prepare(c.numLanes);
+        }
+        for (auto& in : c.interpolators) {
+            in.prepare(c.numLanes);
+        }
+    }
+
+    energies.allocate(static_cast<size_t>(nodes));
+    outputs.allocate(static_cast<size_t>(nodes));
+    reset();
+}
+
+void MultiRateBank::setFrequency(int node, float freq) {
+    RateClass& c = classOf(node);
+    c.bank.setFrequency(node - c.firstNode, freq);
+}
+
+void MultiRateBank::setDamping(int node, float damping) {
+    // Applied once per loop period at any rate: no scaling
+    RateClass& c = classOf(node);
+    c.bank.setDamping(node - c.firstNode, damping);
+}
+
+void MultiRateBank::setBrightness(int node, float brightness) {
+    RateClass& c = classOf(node);
+    c.bank.setBrightness(node - c.firstNode, brightness);
+}
+
+void MultiRateBank::setQuality(fastmath::Quality quality) {
+    for (auto& c : classes) {
+        c.bank.setQuality(quality);
+    }
+}
+
+void MultiRateBank::excite(int node, const ExcitationTable& table, float velocity) {
+    RateClass& c = classOf(node);
+    c.bank.excite(node - c.firstNode, table, velocity);
+    energies[node] = c.bank.getEnergies()[node - c.firstNode];
+}
+
+void MultiRateBank::finishStrikes() {
+    for (auto& c : classes) {
+        c.bank.finishStrikes();
+    }
+}
+
+void MultiRateBank::process(const float* input, const uint8_t* awakeGroups) {
+    for (auto& c : classes) {
+        if (c.numGroups == 0) {
+            continue;
+        }
+
+        const uint8_t* awake = awakeGroups + c.firstGroup;
+        const auto count = sizeof(float) * static_cast<size_t>(c.numNodes);
+        const int row = phase & (c.divider - 1);
+        if (c.divider > 1) {
+            std::memcpy(c.inputRows.data() + row * c.numLanes, input + c.firstNode, count);
+        }
+
+        // Every lane of a sleeping run is silenced and its rows are zero:
+        // skipping the tick leaves it as running it would
+        const bool anyAwake = std::any_of(awake, awake + c.numGroups, [](uint8_t a) { return a != 0; });
+        if (row == c.divider - 1 && anyAwake) {
+            tick(c, input + c.firstNode, awake);
+            std::memcpy(energies.data() + c.firstNode, c.bank.getEnergies(), count);
+        }
+
+        const float* out = c.divider > 1 ? c.outputRows.data() + row * c.numLanes : c.bank.getOutputs();
+        std::memcpy(outputs.data() + c.firstNode, out, count);
+    }
+    phase = (phase + 1) & (MAX_DIVIDER - 1);
+}
+
+void MultiRateBank::tick(RateClass& c, const float* input, const uint8_t* awake) {
+    if (c.divider == 1) {
+        c.bank.process(input, awake);
+        return;
+    }
+
+    const int lanes = c.numLanes;
+    float* in = c.inputRows.data();
+    float* out = c.outputRows.data();
+    float* mid = c.midRows.data();
+    float* slow = c.slowInput.data();
+
+    if (c.divider == 2) {
+        c.decimators[0].process(in, in + lanes, slow, awake);
+        c.bank.process(slow, awake);
+        c.interpolators[0].process(c.bank.getOutputs(), out, out + lanes, awake);
+        return;
+    }
+
+    // Divider 4: two cascaded stages each way
+    c.decimators[0].process(in, in + lanes, mid, awake);
+    c.decimators[0].process(in + 2 * lanes, in + 3 * lanes, mid + lanes, awake);
+    c.decimators[1].process(mid, mid + lanes, slow, awake);
+    c.bank.process(slow, awake);
+    c.interpolators[1].process(c.bank.getOutputs(), mid, mid + lanes, awake);
+    c.interpolators[0].process(mid, out, out + lanes, awake);
+    c.interpolators[0].process(mid + lanes, out + 2 * lanes, out + 3 * lanes, awake);
+}
+
+void MultiRateBank::silence(int node) {
+    RateClass& c = classOf(node);
+    const int lane = node - c.firstNode;
+    c.bank.silence(lane);
+    for (auto& d : c.decimators) {
+        d.clearLane(lane);
+    }
+    for (auto& in : c.interpolators) {
+        in.clearLane(lane);
+    }
+    if (c.divider > 1) {
+        for (int r = 0; r < c.divider; r++) {
+            c.inputRows[static_cast<size_t>(r * c.numLanes + lane)] = 0.0f;
+            c.outputRows[static_cast<size_t>(r * c.numLanes + lane)] = 0.0f;
+        }
+    }
+    energies[node] = 0.0f;
+    outputs[node] = 0.0f;
+}
+
+void MultiRateBank::reset() {
+    for (auto& c : classes) {
+        c.bank.reset();
+        for (auto& d : c.decimators) {
+            d.reset();
+        }
+        for (auto& in : c.interpolators) {
+            in.reset();
+        }
+        c.inputRows.clear();
+        c.outputRows.clear();
+    }
+    energies.clear();
+    outputs.clear();
+    phase = 0;
+}
+
+} // namespace rgs
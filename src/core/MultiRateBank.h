@@ -0,0 +1,104 @@
+#pragma once
+
+#include "AlignedBuffer.h"
+#include "HalfBand.h"
+#include "NodeBank.h"
+#include "ResonatorBank.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace rgs {
+
+/**
+ * Resonator banks at full, half and quarter rate (Engine::MultiRate)
+ *
+ * Low strings spend most of their cost on content nobody hears: C2 at
+ * 96 kHz loops over ~1470 samples, and its loop lowpass leaves little
+ * above a few kHz. Each SLEEP_GROUP of nodes is given a rate divider at
+ * prepare() (chooseDivider) and runs in a ResonatorBank at that rate.
+ * Coupling input reaches it through half-band decimators, its output
+ * comes back through the matching interpolators, so the graph still
+ * sees one output per node per host sample.
+ *
+ * Differences from Engine::Simd:
+ * - reduced-rate nodes lose content above HalfBandFilter::PASSBAND of
+ *   each stage, which chooseDivider keeps above what the node can produce
+ * - their coupling and output lag by the filters and the buffering: a
+ *   round trip at low frequencies takes about 5 host samples at divider
+ *   2 and 16 at divider 4, against 1 for Engine::Simd
+ *
+ * The plan follows the brightness at planRates(); brightening later
+ * keeps the rates. Without a plan every group runs at full rate.
+ */
+class MultiRateBank : public NodeBank {
+public:
+    static constexpr int MAX_DIVIDER = 4;
+    static constexpr float AUDIBLE_BANDWIDTH = 18000.0f;
+    static constexpr int MIN_LOOP = 32;   // Samples at the reduced rate
+
+    // Largest divider (1, 2 or 4) that keeps every 2:1 stage's passband
+    // above the loop's bandwidth (capped at AUDIBLE_BANDWIDTH) and the
+    // loop at highestFrequency at least MIN_LOOP samples long
+    static int chooseDivider(double sampleRate, float highestFrequency, float brightness);
+
+    // Fix each group's divider for the next prepare(): the smallest any
+    // of its nodes needs, and never more than an earlier group's, so each
+    // rate is one run of groups (keyboard layouts rise in pitch anyway).
+    // highestFrequencies: per node, the highest pitch it can be tuned to.
+    void planRates(double sampleRate, int numNodes, const float* highestFrequencies, float brightness);
+
+    // Divider of a node's group
+    int getDivider(int node) const;
+
+    void prepare(double sampleRate, int numNodes, const float* lowestFrequencies) override;
+
+    void setFrequency(int node, float freq) override;
+    void setDamping(int node, float damping) override;
+    void setBrightness(int node, float brightness) override;
+    void setQuality(fastmath::Quality quality) override;
+
+    void excite(int node, const ExcitationTable& table, float velocity) override;
+    void finishStrikes() override;
+    void process(const float* input, const uint8_t* awakeGroups) override;
+    void silence(int node) override;
+
+    const float* getEnergies() const override { return energies.data(); }
+    const float* getOutputs() const override { return outputs.data(); }
+
+    void reset() override;
+
+private:
+    // The run of groups at one divider, in a bank of its own
+    struct RateClass {
+        int divider = 1;
+        int firstGroup = 0;
+        int numGroups = 0;
+        int firstNode = 0;
+        int numNodes = 0;
+        int numLanes = 0;
+        ResonatorBank bank;
+
+        // divider rows of host-rate input, divider rows of output ready
+        // for the host samples up to the next tick
+        AlignedBuffer<float> inputRows, outputRows;
+        AlignedBuffer<float> midRows;      // Two half-rate rows (divider 4)
+        AlignedBuffer<float> slowInput;
+
+        // [0]: host <-> half rate, [1]: half <-> quarter rate
+        std::array<HalfBandDecimator, 2> decimators;
+        std::array<HalfBandInterpolator, 2> interpolators;
+    };
+
+    RateClass& classOf(int node) { return classes[groupClass[static_cast<size_t>(node / SLEEP_GROUP)]]; }
+    void tick(RateClass& c, const float* input, const uint8_t* awake);
+
+    std::array<RateClass, 3> classes;   // Dividers 4, 2, 1, in node order
+    std::vector<int> plannedDividers;   // Per group
+    std::vector<uint8_t> groupClass;
+    int phase = 0;                      // Host samples, mod MAX_DIVIDER
+
+    AlignedBuffer<float> energies, outputs;
+};
+
+} // namespace rgs
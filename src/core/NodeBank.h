@@ -0,0 +1,64 @@
+#pragma once
+
+#include "ExcitationTable.h"
+#include "FastMath.h"
+#include <cstdint>
+
+namespace rgs {
+
+/**
+ * A set of resonator nodes advanced together, one sample at a time
+ *
+ * ResonatorGraph owns one bank and drives it with the coupling
+ * excitation for every node. Implementations are free to store node
+ * state however suits them (objects, structure-of-arrays, SIMD lanes)
+ * as long as they expose per-node energy and output as flat arrays.
+ *
+ * Nodes sleep in groups of SLEEP_GROUP consecutive nodes (one SIMD
+ * register at the widest ISA). A sleeping group is skipped by process();
+ * the graph only puts a group to sleep after silence() has zeroed every
+ * node in it, so skipping it is exactly equivalent to processing it.
+ *
+ * prepare() may allocate; everything else must be realtime safe.
+ */
+class NodeBank {
+public:
+    static constexpr int SLEEP_GROUP = 16;
+
+    virtual ~NodeBank() = default;
+
+    // lowestFrequencies: per node, the lowest pitch it will be tuned to.
+    // Delay lines are sized from it; lower pitches clamp to the line.
+    virtual void prepare(double sampleRate, int numNodes, const float* lowestFrequencies) = 0;
+
+    virtual void setFrequency(int node, float freq) = 0;
+    virtual void setDamping(int node, float damping) = 0;
+    virtual void setBrightness(int node, float brightness) = 0;
+
+    // Accuracy of the loop's soft clamp, for every node
+    virtual void setQuality(fastmath::Quality quality) = 0;
+
+    // Strike one node with a table shape (note-on), velocity 0-1. The
+    // shape is fed in over the node's next loop period as it processes
+    // (ExcitationTable::Strike), so note-on itself costs almost nothing.
+    virtual void excite(int node, const ExcitationTable& table, float velocity) = 0;
+
+    // Deliver every strike still in flight now; after this no node reads
+    // an ExcitationTable until its next excite()
+    virtual void finishStrikes() = 0;
+
+    // Advance every node of each awake group by one sample; input holds
+    // one value per node, awakeGroups one flag per group
+    virtual void process(const float* input, const uint8_t* awakeGroups) = 0;
+
+    // Zero one node's state (delay line, filters, energy, output)
+    virtual void silence(int node) = 0;
+
+    // Per-node state after the last process() call, numNodes entries
+    virtual const float* getEnergies() const = 0;
+    virtual const float* getOutputs() const = 0;
+
+    virtual void reset() = 0;
+};
+
+} // namespace rgs
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+namespace rgs {
+
+/**
+ * A timestamped note event inside one audio block
+ *
+ * sampleOffset is relative to the start of the block passed to
+ * ResonatorGraph::processBlock, so the excitation lands on that exact
+ * sample instead of the block boundary.
+ */
+struct NoteEvent {
+    enum class Type : uint8_t {
+        NoteOn,
+        NoteOff
+    };
+
+    int sampleOffset = 0;
+    Type type = Type::NoteOn;
+    int note = 0;
+    float velocity = 0.0f;   // 0-1, note-on only
+
+    static NoteEvent noteOn(int offset, int note, float velocity) {
+        return { offset, Type::NoteOn, note, velocity };
+    }
+
+    static NoteEvent noteOff(int offset, int note) {
+        return { offset, Type::NoteOff, note, 0.0f };
+    }
+};
+
+} // namespace rgs
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "SpscQueue.h"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace rgs {
+
+/**
+ * Hands immutable objects built on one thread to the audio thread
+ *
+ * The producer builds an object (allocating as it likes) and publishes
+ * it; the audio thread adopts the newest one with update() at a block
+ * boundary and retires the one it replaced into a queue. The producer
+ * frees retired objects on its next publish(), so the audio thread never
+ * allocates or frees. An object published but never adopted is freed by
+ * the next publish().
+ *
+ * A consumer that keeps reading the object it replaced for a while (a
+ * crossfade) adopts with updateKeepingPrevious() instead and hands the
+ * old one back with retirePrevious() once it is done.
+ *
+ * One producer thread, one consumer thread. The destructor frees
+ * everything, so neither may be running then.
+ */
+template <typename T>
+class ObjectExchange {
+public:
+    explicit ObjectExchange(size_t retireCapacity = 8) : retired(retireCapacity) {}
+
+    ~ObjectExchange() {
+        collectRetired();
+        delete previous;
+        delete pending.exchange(nullptr, std::memory_order_acquire);
+    }
+
+    ObjectExchange(const ObjectExchange&) = delete;
+    ObjectExchange& operator=(const ObjectExchange&) = delete;
+
+    // Producer thread only
+    void publish(std::unique_ptr<T> object) {
+        collectRetired();
+        latest = object.get();
+        delete pending.exchange(object.release(), std::memory_order_acq_rel);
+    }
+
+    // Producer thread only: the newest object published, or nullptr.
+    // Neither side frees it before the next publish(), so the producer
+    // can read it to build the next one.
+    const T* getLatest() const { return latest; }
+
+    // Consumer thread only. Adopts the newest published object; returns
+    // true when get() changed. With the retire queue full the swap waits
+    // for a later call.
+    bool update() {
+        if (!hasPending()) {
+            return false;
+        }
+        if (current != nullptr && !retired.push(current.get())) {
+            return false;
+        }
+        current.release();
+        current.reset(pending.exchange(nullptr, std::memory_order_acquire));
+        return true;
+    }
+
+    // Consumer thread only. As update(), but the replaced object stays
+    // alive as getPrevious() until retirePrevious(). Waits while one is
+    // still held.
+    bool updateKeepingPrevious() {
+        if (previous != nullptr || !hasPending()) {
+            return false;
+        }
+        previous = current.release();
+        current.reset(pending.exchange(nullptr, std::memory_order_acquire));
+        return true;
+    }
+
+    // Consumer thread only. Hands getPrevious() back to be freed; false
+    // while the retire queue is full, to be tried again later.
+    bool retirePrevious() {
+        if (previous != nullptr && !retired.push(previous)) {
+            return false;
+        }
+        previous = nullptr;
+        return true;
+    }
+
+    // Consumer thread only; nullptr unless updateKeepingPrevious() kept one
+    const T* getPrevious() const { return previous; }
+
+    // Whether update() has something to adopt. On the producer thread
+    // only a hint: the consumer may adopt it right after.
+    bool hasPending() const { return pending.load(std::memory_order_relaxed) != nullptr; }
+
+    // Consumer thread only; nullptr until the first update() that adopts
+    const T* get() const { return current.get(); }
+
+private:
+    void collectRetired() {
+        T* object = nullptr;
+        while (retired.pop(object)) {
+            delete object;
+        }
+    }
+
+    std::unique_ptr<T> current;
+    T* previous = nullptr;
+    const T* latest = nullptr;   // Producer side
+    std::atomic<T*> pending { nullptr };
+    SpscQueue<T*> retired;
+};
+
+} // namespace rgs
@@ -0,0 +1,115 @@
+#include "Presets.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace rgs {
+namespace presets {
+
+namespace {
+
+// MIDI note of a layout's node, as ResonatorGraph::getNodeNote()
+int nodeNote(const GraphLayout& layout, int node) {
+    const int steps = layout.foldOctaves ? 12 : std::max(layout.stepsPerOctave, 1);
+    return layout.lowestNote + static_cast<int>(std::lround(node * 12.0 / steps));
+}
+
+void initial(SynthState&) {}
+
+// Harmonic couplings, struck near the end of the string
+void resonantPiano(SynthState& state) {
+    state.topology = Topology::Harmonic;
+    state.exciter = { Exciter::Type::Strike, 0.6f, 0.12f };
+    state.damping = 0.998f;
+    state.brightness = 0.65f;
+    state.coupling = 0.35f;
+}
+
+// Every string drives the C and G strings, which ring on as drones
+void extendedSitar(SynthState& state) {
+    state.topology = Topology::Fifths;
+    state.exciter = { Exciter::Type::Pluck, 0.85f, 0.15f };
+    state.damping = 0.9985f;
+    state.brightness = 0.85f;
+    state.coupling = 0.5f;
+
+    const auto& layout = state.layout;
+    auto& patch = state.patch;
+    auto isDrone = [&](int node) {
+        const int pitchClass = nodeNote(layout, node) % 12;
+        return pitchClass == 0 || pitchClass == 7;
+    };
+    patch.numNodes = layout.numNodes;
+    for (int to = 0; to < layout.numNodes; to++) {
+        if (!isDrone(to)) {
+            continue;
+        }
+        patch.nodes[static_cast<size_t>(to)].gain = 0.8f;
+        for (int from = 0; from < layout.numNodes; from++) {
+            if (from != to && patch.edges.size() < SynthPatch::MAX_EDGES) {
+                patch.edges.push_back({ from, to, 0.35f });
+            }
+        }
+    }
+}
+
+// Hard strikes on long-ringing, bright strings across the lattice
+void coralBell(SynthState& state) {
+    state.topology = Topology::Tonnetz;
+    state.exciter = { Exciter::Type::Strike, 0.9f, 0.3f };
+    state.damping = 0.9995f;
+    state.brightness = 0.9f;
+    state.coupling = 0.45f;
+}
+
+// Soft plucks, strong coupling and neighbouring strings panned apart
+void structuralPad(SynthState& state) {
+    state.topology = Topology::Harmonic;
+    state.exciter = { Exciter::Type::Pluck, 0.15f, 0.5f };
+    state.damping = 0.9992f;
+    state.brightness = 0.4f;
+    state.coupling = 0.8f;
+    state.voices = 12;
+
+    auto& patch = state.patch;
+    patch.numNodes = state.layout.numNodes;
+    for (int i = 0; i < patch.numNodes; i++) {
+        patch.nodes[static_cast<size_t>(i)] = { 0.9f, i % 2 == 0 ? 0.15f : 0.85f };
+    }
+}
+
+struct Preset {
+    const char* name;
+    void (*build)(SynthState&);
+};
+
+const Preset PRESETS[] = {
+    { "Inicial", initial },
+    { "Piano Resonante", resonantPiano },
+    { "Sitar Extendido", extendedSitar },
+    { "Campana Coral", coralBell },
+    { "Pad Estructural", structuralPad },
+};
+
+} // namespace
+
+int getNumPresets() {
+    return static_cast<int>(std::size(PRESETS));
+}
+
+const char* getPresetName(int index) {
+    return index >= 0 && index < getNumPresets() ? PRESETS[index].name : "";
+}
+
+bool makePreset(int index, const GraphLayout& layout, SynthState& state) {
+    if (index < 0 || index >= getNumPresets()) {
+        return false;
+    }
+    state.reset();
+    state.layout = layout;
+    PRESETS[index].build(state);
+    return true;
+}
+
+} // namespace presets
+} // namespace rgs
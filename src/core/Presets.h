@@ -0,0 +1,25 @@
+#pragma once
+
+#include "SynthState.h"
+
+namespace rgs {
+namespace presets {
+
+/**
+ * Factory sounds, the plugin's programs
+ *
+ * Each preset is a SynthState built for a layout, so per-node settings
+ * and coupling edits land on the nodes that layout has. Preset 0 is the
+ * plugin's defaults.
+ */
+int getNumPresets();
+
+// "" past the last preset
+const char* getPresetName(int index);
+
+// Replace state with the preset on layout. False (state untouched) for an
+// index out of range. Allocates.
+bool makePreset(int index, const GraphLayout& layout, SynthState& state);
+
+} // namespace presets
+} // namespace rgs
@@ -0,0 +1,183 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+namespace rgs::profiling {
+
+namespace {
+
+// Single writer: a load and a store, no read-modify-write
+template <typename T>
+void bump(std::atomic<T>& value, T amount) {
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+int bucketFor(double ns) {
+    if (ns <= Profiler::MIN_NS) {
+        return 0;
+    }
+    const int bucket = 1 + static_cast<int>(std::log2(ns / Profiler::MIN_NS) * Profiler::BUCKETS_PER_OCTAVE);
+    return std::min(bucket, Profiler::NUM_BUCKETS - 1);
+}
+
+double bucketEdge(int bucket) {
+    return Profiler::MIN_NS * std::exp2(static_cast<double>(bucket) / Profiler::BUCKETS_PER_OCTAVE);
+}
+
+} // namespace
+
+const char* getPhaseName(Phase phase) {
+    switch (phase) {
+        case Phase::Midi:      return "midi";
+        case Phase::Events:    return "events";
+        case Phase::Coupling:  return "coupling";
+        case Phase::Nodes:     return "nodes";
+        case Phase::Output:    return "output";
+        case Phase::Other:     return "other";
+        case Phase::Telemetry: return "telemetry";
+        case Phase::Block:     return "block";
+    }
+    return "?";
+}
+
+double getTicksPerSecond() {
+    static const double rate = [] {
+        using Clock = std::chrono::steady_clock;
+        const auto start = Clock::now();
+        const uint64_t startTicks = now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        const uint64_t ticks = now() - startTicks;
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return ticks > 0 && seconds > 0.0 ? static_cast<double>(ticks) / seconds : 1e9;
+    }();
+    return rate;
+}
+
+void Profiler::prepare(double sr) {
+    sampleRate = sr;
+    if constexpr (ENABLED) {
+        nsPerTick = 1e9 / getTicksPerSecond();
+    }
+    clear();
+}
+
+void Profiler::clear() {
+    for (auto& histogram : histograms) {
+        for (auto& count : histogram.counts) {
+            count.store(0, std::memory_order_relaxed);
+        }
+        histogram.totalNs.store(0.0, std::memory_order_relaxed);
+        histogram.maxNs.store(0.0, std::memory_order_relaxed);
+    }
+    overruns.store(0, std::memory_order_relaxed);
+    lastLoad.store(0.0, std::memory_order_relaxed);
+    totalLoad.store(0.0, std::memory_order_relaxed);
+    peakLoad.store(0.0, std::memory_order_relaxed);
+}
+
+void Profiler::record(const PhaseTimes& times, int numSamples) {
+    if constexpr (!ENABLED) {
+        return;
+    }
+    if (resetRequested.exchange(false, std::memory_order_relaxed)) {
+        clear();
+    }
+
+    for (int p = 0; p < NUM_PHASES; p++) {
+        auto& histogram = histograms[static_cast<size_t>(p)];
+        const double ns = static_cast<double>(times.ticks[static_cast<size_t>(p)]) * nsPerTick;
+        bump(histogram.counts[static_cast<size_t>(bucketFor(ns))], 1u);
+        bump(histogram.totalNs, ns);
+        if (ns > histogram.maxNs.load(std::memory_order_relaxed)) {
+            histogram.maxNs.store(ns, std::memory_order_relaxed);
+        }
+    }
+
+    const double deadlineNs = numSamples * 1e9 / sampleRate;
+    const double load = deadlineNs > 0.0 ? 100.0 * static_cast<double>(times[Phase::Block]) * nsPerTick / deadlineNs
+                                         : 0.0;
+    lastLoad.store(load, std::memory_order_relaxed);
+    bump(totalLoad, load);
+    if (load > peakLoad.load(std::memory_order_relaxed)) {
+        peakLoad.store(load, std::memory_order_relaxed);
+    }
+    if (load > 100.0) {
+        bump(overruns, uint64_t { 1 });
+    }
+}
+
+Profiler::Stats Profiler::getStats() const {
+    Stats stats;
+    for (int p = 0; p < NUM_PHASES; p++) {
+        const auto& histogram = histograms[static_cast<size_t>(p)];
+        auto& phase = stats.phases[static_cast<size_t>(p)];
+
+        std::array<uint32_t, NUM_BUCKETS> counts;
+        uint64_t blocks = 0;
+        for (int b = 0; b < NUM_BUCKETS; b++) {
+            counts[static_cast<size_t>(b)] = histogram.counts[static_cast<size_t>(b)].load(std::memory_order_relaxed);
+            blocks += counts[static_cast<size_t>(b)];
+        }
+        if (blocks == 0) {
+            continue;
+        }
+
+        // Percentiles from the bucket counts read above, so they agree
+        // with each other even while record() runs
+        auto percentile = [&](double fraction) {
+            const auto rank = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(blocks)));
+            uint64_t seen = 0;
+            for (int b = 0; b < NUM_BUCKETS; b++) {
+                seen += counts[static_cast<size_t>(b)];
+                if (seen >= std::max<uint64_t>(rank, 1)) {
+                    return b == 0 ? 0.0 : bucketEdge(b);
+                }
+            }
+            return bucketEdge(NUM_BUCKETS - 1);
+        };
+
+        phase.blocks = blocks;
+        phase.meanNs = histogram.totalNs.load(std::memory_order_relaxed) / static_cast<double>(blocks);
+        phase.maxNs = histogram.maxNs.load(std::memory_order_relaxed);
+        phase.p50Ns = std::min(percentile(0.5), phase.maxNs);
+        phase.p99Ns = std::min(percentile(0.99), phase.maxNs);
+    }
+
+    stats.blocks = stats.phases[static_cast<size_t>(Phase::Block)].blocks;
+    stats.overruns = overruns.load(std::memory_order_relaxed);
+    stats.loadPercent = lastLoad.load(std::memory_order_relaxed);
+    stats.peakLoadPercent = peakLoad.load(std::memory_order_relaxed);
+    if (stats.blocks > 0) {
+        stats.meanLoadPercent = totalLoad.load(std::memory_order_relaxed) / static_cast<double>(stats.blocks);
+    }
+    return stats;
+}
+
+std::string Profiler::dumpJson() const {
+    const Stats stats = getStats();
+    char line[256];
+    std::string json = "{";
+
+    std::snprintf(line, sizeof(line),
+                  "\"enabled\": %s, \"blocks\": %llu, \"overruns\": %llu, "
+                  "\"loadPercent\": { \"mean\": %.2f, \"peak\": %.2f }, \"phases\": {",
+                  ENABLED ? "true" : "false", static_cast<unsigned long long>(stats.blocks),
+                  static_cast<unsigned long long>(stats.overruns), stats.meanLoadPercent,
+                  stats.peakLoadPercent);
+    json += line;
+
+    for (int p = 0; p < NUM_PHASES; p++) {
+        const auto& phase = stats.phases[static_cast<size_t>(p)];
+        std::snprintf(line, sizeof(line),
+                      "%s \"%s\": { \"meanNs\": %.0f, \"p50Ns\": %.0f, \"p99Ns\": %.0f, \"maxNs\": %.0f }",
+                      p > 0 ? "," : "", getPhaseName(static_cast<Phase>(p)),
+                      phase.meanNs, phase.p50Ns, phase.p99Ns, phase.maxNs);
+        json += line;
+    }
+    json += " } }";
+    return json;
+}
+
+} // namespace rgs::profiling
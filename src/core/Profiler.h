@@ -0,0 +1,205 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #else
+        #include <x86intrin.h>
+    #endif
+#endif
+
+// Set by CMake for Debug builds and with -DRGS_PROFILING=ON. Without it
+// every timer below compiles to nothing.
+#ifndef RGS_PROFILING
+    #define RGS_PROFILING 0
+#endif
+
+namespace rgs::profiling {
+
+constexpr bool ENABLED = RGS_PROFILING != 0;
+
+/**
+ * Where a block's time goes. The graph phases are summed over voices, so
+ * with a WorkerPool they can add up to more than the block took.
+ */
+enum class Phase {
+    Midi,        // Processor: MIDI buffer to note events, parameter changes
+    Events,      // Commands, voice allocation, note-ons and strikes
+    Coupling,    // Coupling gather and excitation limiter
+    Nodes,       // Node loops: delay reads, filters, writes
+    Output,      // Pan mix, soft clip, voice sum
+    Other,       // Sleep checks, parameter glides, tail estimate
+    Telemetry,   // Processor: publishing the editor's snapshot
+    Block        // The whole block, wall time
+};
+
+constexpr int NUM_PHASES = 8;
+
+const char* getPhaseName(Phase phase);
+
+// Cheapest steady counter: the TSC on x86-64, the virtual counter on
+// arm64, nanoseconds elsewhere
+inline uint64_t now() {
+#if defined(__x86_64__) || defined(_M_X64)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t ticks;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Rate of now(), measured against steady_clock on first use (about 10 ms).
+// Not for the audio thread until something has called it once.
+double getTicksPerSecond();
+
+/**
+ * Counter ticks per phase, accumulated over one block
+ */
+struct PhaseTimes {
+    std::array<uint64_t, NUM_PHASES> ticks {};
+
+    uint64_t& operator[](Phase phase) { return ticks[static_cast<size_t>(phase)]; }
+    uint64_t operator[](Phase phase) const { return ticks[static_cast<size_t>(phase)]; }
+
+    void clear() {
+        if constexpr (ENABLED) {
+            ticks.fill(0);
+        }
+    }
+
+    void add(const PhaseTimes& other) {
+        if constexpr (ENABLED) {
+            for (size_t i = 0; i < ticks.size(); i++) {
+                ticks[i] += other.ticks[i];
+            }
+        }
+    }
+};
+
+/**
+ * Charges elapsed time to phases: lap() bills everything since the
+ * previous lap (or start()) to one phase, so consecutive sections need
+ * one counter read each
+ */
+class PhaseTimer {
+public:
+    explicit PhaseTimer(PhaseTimes& target) : times(target) {}
+
+    void start() {
+        if constexpr (ENABLED) {
+            first = last = now();
+        }
+    }
+
+    void lap(Phase phase) {
+        if constexpr (ENABLED) {
+            const uint64_t t = now();
+            times[phase] += t - last;
+            last = t;
+        }
+    }
+
+    // Bill nothing for the time since the last lap (it was timed
+    // elsewhere, e.g. by the voices)
+    void skip() {
+        if constexpr (ENABLED) {
+            last = now();
+        }
+    }
+
+    // Bill everything since start() to phase (Phase::Block)
+    void total(Phase phase) {
+        if constexpr (ENABLED) {
+            times[phase] += now() - first;
+        }
+    }
+
+private:
+    PhaseTimes& times;
+    uint64_t first = 0;
+    uint64_t last = 0;
+};
+
+/**
+ * Lock-free per-phase histograms of block times, with DSP load against
+ * the block deadline
+ *
+ * One thread (the audio thread) calls record() once per block; any
+ * thread reads getStats() or dumpJson() at any time. Buckets are
+ * logarithmic, BUCKETS_PER_OCTAVE to an octave of nanoseconds, so
+ * percentiles are upper bucket edges: within 19 % above the true value.
+ * Counters are relaxed atomics written by that one thread, so a reader
+ * may see a block half recorded, never a torn value.
+ *
+ * Without RGS_PROFILING, record() does nothing and every stat is zero.
+ */
+class Profiler {
+public:
+    static constexpr int BUCKETS_PER_OCTAVE = 4;
+    static constexpr int NUM_BUCKETS = 25 * BUCKETS_PER_OCTAVE;   // Up to ~0.5 s
+    static constexpr double MIN_NS = 16.0;                        // First bucket's upper edge
+
+    struct PhaseStats {
+        uint64_t blocks = 0;
+        double meanNs = 0.0;
+        double p50Ns = 0.0;
+        double p99Ns = 0.0;
+        double maxNs = 0.0;
+    };
+
+    struct Stats {
+        std::array<PhaseStats, NUM_PHASES> phases {};
+        uint64_t blocks = 0;
+        uint64_t overruns = 0;        // Blocks that took longer than their audio
+        double loadPercent = 0.0;     // Last block: Block time / block duration
+        double meanLoadPercent = 0.0;
+        double peakLoadPercent = 0.0;
+    };
+
+    // Calibrates the counter. Not for the audio thread.
+    void prepare(double sampleRate);
+
+    // Audio thread, once per block
+    void record(const PhaseTimes& times, int numSamples);
+
+    // Any thread: clears everything before the next record()
+    void reset() { resetRequested.store(true, std::memory_order_relaxed); }
+
+    // Any thread
+    Stats getStats() const;
+
+    // Any thread: getStats() as a JSON object, for rgs_bench and tests
+    std::string dumpJson() const;
+
+private:
+    struct Histogram {
+        std::array<std::atomic<uint32_t>, NUM_BUCKETS> counts {};
+        std::atomic<double> totalNs { 0.0 };
+        std::atomic<double> maxNs { 0.0 };
+    };
+
+    void clear();
+
+    std::array<Histogram, NUM_PHASES> histograms;
+    std::atomic<uint64_t> overruns { 0 };
+    std::atomic<double> lastLoad { 0.0 };
+    std::atomic<double> totalLoad { 0.0 };
+    std::atomic<double> peakLoad { 0.0 };
+    std::atomic<bool> resetRequested { false };
+
+    // Writer side
+    double sampleRate = 44100.0;
+    double nsPerTick = 1.0;
+};
+
+} // namespace rgs::profiling
@@ -0,0 +1,60 @@
+#pragma once
+
+namespace rgs {
+
+/**
+ * Linear ramp towards a target value
+ *
+ * Parameter changes glide over a fixed number of samples instead of
+ * jumping, which keeps automation free of zipper noise. Advancing by
+ * several samples at once lets callers update at sub-block rate.
+ */
+class Ramp {
+public:
+    // Jump straight to value
+    void reset(float value) {
+        current = target = value;
+        stepsLeft = 0;
+    }
+
+    // Glide from the current value to newTarget over numSteps samples
+    void setTarget(float newTarget, int numSteps) {
+        if (newTarget == target) {
+            return;
+        }
+        target = newTarget;
+        if (numSteps <= 0) {
+            reset(newTarget);
+            return;
+        }
+        increment = (target - current) / static_cast<float>(numSteps);
+        stepsLeft = numSteps;
+    }
+
+    bool isRamping() const { return stepsLeft > 0; }
+    int getStepsLeft() const { return stepsLeft; }
+    float getCurrent() const { return current; }
+    float getTarget() const { return target; }
+
+    // Advance numSteps samples and return the new value
+    float skip(int numSteps) {
+        if (numSteps >= stepsLeft) {
+            current = target;
+            stepsLeft = 0;
+        } else {
+            current += increment * static_cast<float>(numSteps);
+            stepsLeft -= numSteps;
+        }
+        return current;
+    }
+
+    float next() { return skip(1); }
+
+private:
+    float current = 0.0f;
+    float target = 0.0f;
+    float increment = 0.0f;
+    int stepsLeft = 0;
+};
+
+} // namespace rgs
@@ -4,18 +4,27 @@
 
 namespace rgs {
 
-Resonator::Resonator() {
-    delayLine.fill(0.0f);
+int Resonator::delaySizeFor(double sr, float lowestFrequency) {
+    float freq = std::clamp(lowestFrequency, MIN_FREQUENCY, MAX_FREQUENCY);
+    int needed = static_cast<int>(std::ceil(sr / freq)) + 2;
+
+    int size = MIN_DELAY_SIZE;
+    while (size < needed) {
+        size <<= 1;
+    }
+    return size;
 }
 
-void Resonator::prepare(double sr) {
+void Resonator::prepare(double sr, float* delayBuffer, int delaySize) {
     sampleRate = sr;
+    delayLine = delayBuffer;
+    delayMask = delaySize - 1;
     setFrequency(frequency);
     reset();
 }
 
 void Resonator::setFrequency(float freq) {
-    frequency = std::clamp(freq, 20.0f, 20000.0f);
+    frequency = std::clamp(freq, MIN_FREQUENCY, MAX_FREQUENCY);
 
     // Calculate delay length for this frequency
     float totalDelay = static_cast<float>(sampleRate) / frequency;
@@ -27,7 +36,8 @@ void Resonator::setFrequency(float freq) {
     delayLength = static_cast<int>(totalDelay);
     fractionalDelay = totalDelay - static_cast<float>(delayLength);
 
-    delayLength = std::clamp(delayLength, 2, MAX_DELAY - 1);
+    // Pitches below what the line was sized for clamp to its length
+    delayLength = std::clamp(delayLength, 2, std::max(2, delayMask));
 }
 
 void Resonator::setDamping(float d) {
@@ -48,20 +58,25 @@ void Resonator::setInharmonicity(float inharm) {
     apfCoeff = inharmonicity * 0.5f;
 }
 
-void Resonator::excite(float amount) {
-    // Fill delay line with filtered noise
-    for (int i = 0; i < delayLength; i++) {
-        float noise = nextNoise() * amount;
-        int pos = (writePos + MAX_DELAY - i) % MAX_DELAY;
-        delayLine[pos] += noise;
-    }
-    energy = std::max(energy, std::abs(amount));
+void Resonator::excite(const ExcitationTable& table, float velocity) {
+    finishStrike();
+    strike = table.strike(delayLength, velocity);
+    energy = std::max(energy, std::abs(velocity));
+}
+
+void Resonator::finishStrike() {
+    strike.deliver(delayLine, delayMask, writePos, strike.remaining);
 }
 
 float Resonator::process(float externalInput) {
+    // Feed the strike in just ahead of the read
+    if (strike.active()) {
+        strike.deliver(delayLine, delayMask, writePos, 1);
+    }
+
     // Read from delay line (with linear interpolation for fractional delay)
-    int readPos = (writePos + MAX_DELAY - delayLength) % MAX_DELAY;
-    int readPosNext = (readPos + MAX_DELAY - 1) % MAX_DELAY;
+    int readPos = (writePos - delayLength) & delayMask;
+    int readPosNext = (readPos - 1) & delayMask;
 
     float sample = delayLine[readPos] * (1.0f - fractionalDelay)
                  + delayLine[readPosNext] * fractionalDelay;
@@ -83,19 +98,20 @@ float Resonator::process(float externalInput) {
     // Add external input (sympathetic resonance)
     feedback += externalInput;
 
-    // Soft clamp to prevent blowup
-    feedback = std::tanh(feedback);
-
-    // Safety check
-    if (!std::isfinite(feedback)) {
+    // Safety check: tanh maps everything else into [-1, 1], so only a
+    // NaN can get through
+    if (feedback != feedback) {
         feedback = 0.0f;
     }
 
+    // Soft clamp to prevent blowup
+    feedback = fastmath::tanh(quality, feedback);
+
     // Write to delay line
     delayLine[writePos] = feedback;
 
     // Advance write position
-    writePos = (writePos + 1) % MAX_DELAY;
+    writePos = (writePos + 1) & delayMask;
 
     // Update energy (exponential decay + peak tracking)
     energy = energy * 0.9995f;
@@ -109,18 +125,15 @@ float Resonator::process(float externalInput) {
 }
 
 void Resonator::reset() {
-    delayLine.fill(0.0f);
+    if (delayLine != nullptr) {
+        std::fill_n(delayLine, delayMask + 1, 0.0f);
+    }
     writePos = 0;
+    strike = {};
     lpfState = 0.0f;
     apfState = 0.0f;
     energy = 0.0f;
     lastOutput = 0.0f;
 }
 
-float Resonator::nextNoise() {
-    // Simple LCG noise generator
-    noiseState = noiseState * 1103515245 + 12345;
-    return (static_cast<float>(noiseState) / static_cast<float>(UINT32_MAX)) * 2.0f - 1.0f;
-}
-
 } // namespace rgs
@@ -1,9 +1,7 @@
 #pragma once
 
-#include <juce_audio_basics/juce_audio_basics.h>
-#include <juce_dsp/juce_dsp.h>
-#include <array>
-#include <cstdint>
+#include "ExcitationTable.h"
+#include "FastMath.h"
 
 namespace rgs {
 
@@ -14,21 +12,36 @@ namespace rgs {
  * - Frequency-dependent damping
  * - Adjustable brightness (lowpass cutoff)
  * - Inharmonicity via allpass filter
+ *
+ * The delay line is borrowed: the owner sizes it with delaySizeFor() for
+ * the lowest pitch the resonator will play and passes it to prepare().
  */
 class Resonator {
 public:
-    static constexpr int MAX_DELAY = 4096;
+    static constexpr float MIN_FREQUENCY = 20.0f;
+    static constexpr float MAX_FREQUENCY = 20000.0f;
+    static constexpr int MIN_DELAY_SIZE = 16;   // One cache line
 
-    Resonator();
+    // Power-of-two line length holding one period of lowestFrequency
+    static int delaySizeFor(double sampleRate, float lowestFrequency);
 
-    void prepare(double sampleRate);
+    // delayBuffer holds delaySize floats (a power of two) and must
+    // outlive the resonator's use of it
+    void prepare(double sampleRate, float* delayBuffer, int delaySize);
     void setFrequency(float freq);
     void setDamping(float damping);      // 0.9 - 0.9999
     void setBrightness(float brightness); // 0 - 1
     void setInharmonicity(float inharm);  // 0 - 0.1
+    void setQuality(fastmath::Quality q) { quality = q; }
+
+    // Strike: the table's shape for this velocity (0-1) is fed into the
+    // loop over the next period, one sample per process() call. A strike
+    // still in flight is delivered in full first.
+    void excite(const ExcitationTable& table, float velocity);
 
-    // Inject energy (from exciter or sympathetic coupling)
-    void excite(float amount);
+    // Deliver the rest of a strike in flight now, so it no longer reads
+    // its table
+    void finishStrike();
 
     // Process one sample, return output
     float process(float externalInput = 0.0f);
@@ -43,16 +56,16 @@ public:
     void reset();
 
 private:
-    float nextNoise();
-
     double sampleRate = 44100.0;
     float frequency = 440.0f;
     float damping = 0.998f;
     float brightness = 0.8f;
     float inharmonicity = 0.0f;
+    fastmath::Quality quality = fastmath::Quality::Normal;
 
-    // Delay line
-    std::array<float, MAX_DELAY> delayLine{};
+    // Delay line (borrowed), indices wrap with delayMask
+    float* delayLine = nullptr;
+    int delayMask = 0;
     int writePos = 0;
     int delayLength = 100;
     float fractionalDelay = 0.0f;
@@ -66,7 +79,7 @@ private:
     // State
     float energy = 0.0f;
     float lastOutput = 0.0f;
-    uint32_t noiseState = 12345;
+    ExcitationTable::Strike strike;
 };
 
 } // namespace rgs
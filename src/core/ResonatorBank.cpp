@@ -0,0 +1,408 @@
+#include "ResonatorBank.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace rgs {
+
+namespace simd {
+
+namespace {
+
+// Scalar stand-ins for the vector operations, one lane at a time
+struct ScalarOps {
+    using Vec = float;
+    using Mask = bool;
+    static constexpr int WIDTH = 1;
+
+    static Vec load(const float* p) { return *p; }
+    static void store(float* p, Vec v) { *p = v; }
+    static Vec set1(float x) { return x; }
+    static Vec zero() { return 0.0f; }
+
+    static Vec add(Vec a, Vec b) { return a + b; }
+    static Vec sub(Vec a, Vec b) { return a - b; }
+    static Vec mul(Vec a, Vec b) { return a * b; }
+    static Vec div(Vec a, Vec b) { return a / b; }
+    static Vec madd(Vec a, Vec b, Vec c) { return a * b + c; }
+    static Vec min(Vec a, Vec b) { return b < a ? b : a; }
+    static Vec max(Vec a, Vec b) { return a < b ? b : a; }
+    static Vec abs(Vec a) { return std::abs(a); }
+
+    static Mask greater(Vec a, Vec b) { return a > b; }
+    static Mask notNan(Vec a) { return a == a; }
+    static Vec select(Mask m, Vec a, Vec b) { return m ? a : b; }
+};
+
+} // namespace
+
+void processBankScalar(BankLanes& lanes) {
+    processBank<ScalarOps>(lanes);
+}
+
+void processBankBlockScalar(BankLanes& lanes) {
+    processBankBlock<ScalarOps>(lanes);
+}
+
+} // namespace simd
+
+static_assert(NodeBank::SLEEP_GROUP % simd::MAX_WIDTH == 0,
+              "sleep groups must cover whole vectors at every ISA");
+
+namespace {
+
+simd::BankKernel kernelFor(simd::Isa isa) {
+#if RGS_SIMD_X86
+    switch (isa) {
+        case simd::Isa::Avx512: return simd::processBankAvx512;
+        case simd::Isa::Avx2:   return simd::processBankAvx2;
+        case simd::Isa::Sse2:   return simd::processBankSse2;
+        case simd::Isa::Scalar: break;
+    }
+#else
+    (void) isa;
+#endif
+    return simd::processBankScalar;
+}
+
+simd::BankKernel blockKernelFor(simd::Isa isa) {
+#if RGS_SIMD_X86
+    switch (isa) {
+        case simd::Isa::Avx512: return simd::processBankBlockAvx512;
+        case simd::Isa::Avx2:   return simd::processBankBlockAvx2;
+        case simd::Isa::Sse2:   return simd::processBankBlockSse2;
+        case simd::Isa::Scalar: break;
+    }
+#else
+    (void) isa;
+#endif
+    return simd::processBankBlockScalar;
+}
+
+} // namespace
+
+void ResonatorBank::prepare(double sr, int nodes, const float* lowestFrequencies) {
+    sampleRate = sr;
+    numNodes = nodes;
+    numLanes = (nodes + simd::MAX_WIDTH - 1) / simd::MAX_WIDTH * simd::MAX_WIDTH;
+
+    const auto lanes = static_cast<size_t>(numLanes);
+    for (auto* buffer : { &lpfState, &lpfCoeff, &apfState, &apfCoeff, &apfEnabled,
+                          &damping, &fractionalDelay, &energy, &output, &input,
+                          &read0, &read1, &feedback, &frequency }) {
+        buffer->allocate(lanes);
+    }
+    delayLength.allocate(lanes);
+    strikes.assign(lanes, {});
+    striking.clear();
+    striking.reserve(lanes);
+    lineOffset.allocate(lanes);
+    lineMask.allocate(lanes);
+    if (subBlocks) {
+        for (auto* buffer : { &outputBlock, &read0Block, &energyBlock, &inputBlock, &feedbackBlock }) {
+            buffer->allocate(lanes * MAX_SUB_BLOCK);
+        }
+    }
+
+    // Power-of-two lines of at least a cache line, back to back; padding
+    // lanes get a line for their 440 Hz default
+    int32_t total = 0;
+    int longest = Resonator::MIN_DELAY_SIZE;
+    for (int i = 0; i < numLanes; i++) {
+        int size = Resonator::delaySizeFor(sampleRate, i < numNodes ? lowestFrequencies[i] : 440.0f);
+        lineOffset[i] = total;
+        lineMask[i] = size - 1;
+        total += size;
+        longest = std::max(longest, size);
+    }
+    lines.allocate(static_cast<size_t>(total));
+    writeMask = longest - 1;
+
+    // Same defaults as Resonator; padding lanes keep them and stay silent
+    for (int i = 0; i < numLanes; i++) {
+        frequency[i] = 440.0f;
+        damping[i] = 0.998f;
+        setBrightness(i, 0.8f);
+        updateDelay(i);
+    }
+
+    isa = simd::getActiveIsa();
+    kernel = kernelFor(isa);
+    blockKernel = blockKernelFor(isa);
+
+    view.lpfState = lpfState.data();
+    view.lpfCoeff = lpfCoeff.data();
+    view.apfState = apfState.data();
+    view.apfCoeff = apfCoeff.data();
+    view.apfEnabled = apfEnabled.data();
+    view.damping = damping.data();
+    view.fractionalDelay = fractionalDelay.data();
+    view.delayLength = delayLength.data();
+    view.energy = energy.data();
+    view.output = output.data();
+    view.input = input.data();
+    view.read0 = read0.data();
+    view.read1 = read1.data();
+    view.feedback = feedback.data();
+    view.lines = lines.data();
+    view.lineOffset = lineOffset.data();
+    view.lineMask = lineMask.data();
+    view.numLanes = numLanes;
+    view.blockOutput = outputBlock.data();
+    view.blockRead0 = read0Block.data();
+    view.blockInput = inputBlock.data();
+    view.blockFeedback = feedbackBlock.data();
+    view.blockStride = numLanes;
+    view.energyDecay = std::pow(0.9995f, static_cast<float>(rateDivider));
+
+    reset();
+}
+
+void ResonatorBank::setFrequency(int node, float freq) {
+    frequency[node] = std::clamp(freq, Resonator::MIN_FREQUENCY, Resonator::MAX_FREQUENCY);
+    updateDelay(node);
+}
+
+void ResonatorBank::updateDelay(int node) {
+    // Mirrors Resonator::setFrequency
+    float totalDelay = static_cast<float>(sampleRate) / frequency[node];
+    totalDelay -= 0.5f;
+    totalDelay -= apfCoeff[node];
+
+    int length = static_cast<int>(totalDelay);
+    fractionalDelay[node] = totalDelay - static_cast<float>(length);
+    delayLength[node] = std::clamp(length, 2, std::max(2, static_cast<int>(lineMask[node])));
+}
+
+void ResonatorBank::setDamping(int node, float d) {
+    damping[node] = std::clamp(d, 0.9f, 0.9999f);
+}
+
+void ResonatorBank::setBrightness(int node, float b) {
+    const float coeff = 0.2f + std::clamp(b, 0.0f, 1.0f) * 0.8f;
+    if (rateDivider == 1) {
+        lpfCoeff[node] = coeff;
+        return;
+    }
+
+    // Each harmonic passes the loop lowpass once per period. Its loss
+    // there is ~ (1 - a) w^2 / a^2 at low w, and w grows with the divider:
+    // pick the coefficient that keeps (1 - a) / (a^2 divider^2) unchanged
+    const float k = static_cast<float>(rateDivider);
+    const float r = (1.0f - coeff) / (coeff * coeff * k * k);
+    lpfCoeff[node] = r > 0.0f ? (std::sqrt(1.0f + 4.0f * r) - 1.0f) / (2.0f * r) : 1.0f;
+}
+
+void ResonatorBank::setInharmonicity(int node, float inharm) {
+    float amount = std::clamp(inharm, 0.0f, 0.1f);
+    apfCoeff[node] = amount * 0.5f;
+    apfEnabled[node] = amount > 0.001f ? 1.0f : 0.0f;
+}
+
+void ResonatorBank::setQuality(fastmath::Quality quality) {
+    view.ecoTanh = quality == fastmath::Quality::Eco;
+}
+
+void ResonatorBank::excite(int node, const ExcitationTable& table, float velocity) {
+    // As Resonator::excite: finish a strike in flight, then start anew
+    auto& strike = strikes[static_cast<size_t>(node)];
+    if (strike.active()) {
+        strike.deliver(lines.data() + lineOffset[node], lineMask[node], writePos, strike.remaining);
+    } else {
+        striking.push_back(node);
+    }
+    strike = table.strike(delayLength[node], velocity, rateDivider);
+    energy[node] = std::max(energy[node], std::abs(velocity));
+}
+
+void ResonatorBank::finishStrikes() {
+    deliverStrikes(std::numeric_limits<int>::max());
+}
+
+void ResonatorBank::deliverStrikes(int numSamples) {
+    // The next numSamples of every strike in flight, just ahead of the
+    // reads that need them
+    for (size_t s = 0; s < striking.size();) {
+        const int node = striking[s];
+        auto& strike = strikes[static_cast<size_t>(node)];
+        strike.deliver(lines.data() + lineOffset[node], lineMask[node], writePos, numSamples);
+        if (strike.active()) {
+            s++;
+        } else {
+            striking[s] = striking.back();
+            striking.pop_back();
+        }
+    }
+}
+
+void ResonatorBank::cancelStrike(int node) {
+    strikes[static_cast<size_t>(node)] = {};
+    striking.erase(std::remove(striking.begin(), striking.end(), node), striking.end());
+}
+
+simd::BankLanes ResonatorBank::runView(int first, int count) const {
+    simd::BankLanes run = view;
+    run.lpfState += first;
+    run.lpfCoeff += first;
+    run.apfState += first;
+    run.apfCoeff += first;
+    run.apfEnabled += first;
+    run.damping += first;
+    run.fractionalDelay += first;
+    run.delayLength += first;
+    run.energy += first;
+    run.output += first;
+    run.input += first;
+    run.read0 += first;
+    run.read1 += first;
+    run.feedback += first;
+    run.lineOffset += first;
+    run.lineMask += first;
+    run.blockOutput += first;
+    run.blockRead0 += first;
+    run.blockInput += first;
+    run.blockFeedback += first;
+    run.writePos = writePos;
+    run.numLanes = count;
+    return run;
+}
+
+void ResonatorBank::process(const float* in, const uint8_t* awakeGroups) {
+    deliverStrikes(1);
+
+    // One kernel call per run of consecutive awake groups
+    forEachAwakeRun(awakeGroups, [&](int first, int count) {
+        const int inputs = std::min(count, numNodes - first);
+        std::memcpy(input.data() + first, in + first, sizeof(float) * static_cast<size_t>(inputs));
+
+        simd::BankLanes run = runView(first, count);
+        kernel(run);
+    });
+
+    // Sleeping lanes hold zeros, so the shared position can move on
+    writePos = (writePos + 1) & writeMask;
+}
+
+int ResonatorBank::getMaxSubBlock() const {
+    // Padding lanes never receive input and stay silent, so only real
+    // nodes bound the sub-block
+    int shortest = MAX_SUB_BLOCK;
+    for (int i = 0; i < numNodes; i++) {
+        shortest = std::min(shortest, static_cast<int>(delayLength[i]));
+    }
+    return shortest;
+}
+
+void ResonatorBank::readBlock(int numSamples, const uint8_t* awakeGroups) {
+    beginBlock(numSamples);
+    const int numGroups = numLanes / SLEEP_GROUP;
+    for (int g = 0; g < numGroups; g++) {
+        readGroup(numSamples, g, awakeGroups[g] != 0);
+    }
+}
+
+void ResonatorBank::writeBlock(int numSamples, const uint8_t* awakeGroups) {
+    forEachAwakeRun(awakeGroups, [&](int first, int count) {
+        writeLanes(numSamples, first, count);
+    });
+    endBlock(numSamples);
+}
+
+void ResonatorBank::beginBlock(int numSamples) {
+    deliverStrikes(numSamples);
+}
+
+void ResonatorBank::readGroup(int numSamples, int group, bool awake) {
+    const int stride = numLanes;
+    const int first = group * SLEEP_GROUP;
+
+    if (!awake) {
+        // Coupling may wake the group mid-sub-block; until then it
+        // reads silence
+        for (int k = 0; k < numSamples; k++) {
+            const int row = k * stride + first;
+            std::fill_n(outputBlock.data() + row, SLEEP_GROUP, 0.0f);
+            std::fill_n(read0Block.data() + row, SLEEP_GROUP, 0.0f);
+            std::fill_n(energyBlock.data() + row, SLEEP_GROUP, 0.0f);
+        }
+        return;
+    }
+
+    for (int i = first; i < first + SLEEP_GROUP; i++) {
+        // Consecutive samples read consecutive line positions, so each
+        // sample's second tap is the previous sample's first
+        const float* line = lines.data() + lineOffset[i];
+        const int mask = lineMask[i];
+        const int readPos = (writePos - delayLength[i]) & mask;
+        const float frac = fractionalDelay[i];
+
+        float previous = line[(readPos - 1) & mask];
+        float level = energy[i];
+        for (int k = 0; k < numSamples; k++) {
+            const float current = line[(readPos + k) & mask];
+            const float sample = current * (1.0f - frac) + previous * frac;
+            previous = current;
+
+            // Same decay-then-peak order as the kernel
+            const float decayed = level * view.energyDecay;
+            const float peak = std::abs(sample);
+            level = decayed < peak ? peak : decayed;
+
+            const int row = k * stride + i;
+            outputBlock[row] = sample;
+            read0Block[row] = current;
+            energyBlock[row] = level;
+        }
+        energy[i] = level;
+        output[i] = outputBlock[(numSamples - 1) * stride + i];
+    }
+}
+
+void ResonatorBank::writeGroup(int numSamples, int group) {
+    writeLanes(numSamples, group * SLEEP_GROUP, SLEEP_GROUP);
+}
+
+void ResonatorBank::endBlock(int numSamples) {
+    writePos = (writePos + numSamples) & writeMask;
+}
+
+void ResonatorBank::writeLanes(int numSamples, int first, int count) {
+    const int stride = numLanes;
+
+    simd::BankLanes run = runView(first, count);
+    run.numSamples = numSamples;
+    blockKernel(run);
+
+    // No line was read past the sub-block start, so the writes can wait
+    // until here and go out one contiguous span per lane
+    for (int i = first; i < first + count; i++) {
+        float* line = lines.data() + lineOffset[i];
+        const int mask = lineMask[i];
+        for (int k = 0; k < numSamples; k++) {
+            line[(writePos + k) & mask] = feedbackBlock[k * stride + i];
+        }
+    }
+}
+
+void ResonatorBank::silence(int node) {
+    std::fill_n(lines.data() + lineOffset[node], lineMask[node] + 1, 0.0f);
+    lpfState[node] = 0.0f;
+    apfState[node] = 0.0f;
+    energy[node] = 0.0f;
+    output[node] = 0.0f;
+    cancelStrike(node);
+}
+
+void ResonatorBank::reset() {
+    lines.clear();
+    lpfState.clear();
+    apfState.clear();
+    energy.clear();
+    output.clear();
+    std::fill(strikes.begin(), strikes.end(), ExcitationTable::Strike{});
+    striking.clear();
+    writePos = 0;
+}
+
+} // namespace rgs
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "AlignedBuffer.h"
+#include "NodeBank.h"
+#include "Resonator.h"
+#include "simd/BankKernel.h"
+#include "simd/CpuFeatures.h"
+#include <cstdint>
+#include <vector>
+
+namespace rgs {
+
+/**
+ * Structure-of-arrays Karplus-Strong bank
+ *
+ * Holds the state of every node in aligned lane arrays so one kernel
+ * call advances 4/8/16 nodes per instruction (SSE2/AVX2/AVX-512). The
+ * kernel is picked at prepare() time from the CPU's capabilities, with a
+ * portable scalar fallback.
+ *
+ * Output matches ScalarBank within 1e-4 absolute over a multi-second
+ * render: the only differences are the rational tanh (3.6e-7 error per
+ * call) and FMA rounding on AVX2/AVX-512.
+ *
+ * Sub-block schedule (Engine::Block): a loop can never hear a sample
+ * written less than one delay ago, so over at most getMaxSubBlock()
+ * samples every read comes from before the sub-block. readBlock() then
+ * produces all of its outputs up front, the caller computes the coupling
+ * rows from them, and writeBlock() runs the loop filters and writes the
+ * lines back. Same arithmetic, same one-sample coupling latency as
+ * process().
+ */
+class ResonatorBank : public NodeBank {
+public:
+    static constexpr int MAX_SUB_BLOCK = 64;
+
+    // subBlocks allocates the readBlock() / writeBlock() rows
+    explicit ResonatorBank(bool subBlocks = false) : subBlocks(subBlocks) {}
+
+    void prepare(double sampleRate, int numNodes, const float* lowestFrequencies) override;
+
+    void setFrequency(int node, float freq) override;
+    void setDamping(int node, float damping) override;
+    void setBrightness(int node, float brightness) override;
+    void setInharmonicity(int node, float inharm);
+
+    // Run at 1/divider of the rate the graph runs at (MultiRateBank),
+    // keeping brightness, strike level and the energy meter as they sound
+    // there. prepare() then takes the reduced rate. Call before prepare().
+    void setRateDivider(int divider) { rateDivider = divider; }
+
+    // Eco selects fastmath::tanhEco; Normal and Reference both run the
+    // float-precision rational tanh
+    void setQuality(fastmath::Quality quality) override;
+
+    void excite(int node, const ExcitationTable& table, float velocity) override;
+    void finishStrikes() override;
+    void process(const float* input, const uint8_t* awakeGroups) override;
+    void silence(int node) override;
+
+    const float* getEnergies() const override { return energy.data(); }
+    const float* getOutputs() const override { return output.data(); }
+
+    void reset() override;
+
+    simd::Isa getIsa() const { return isa; }
+
+    // Longest sub-block whose reads all predate it: the shortest delay of
+    // any node, capped at MAX_SUB_BLOCK
+    int getMaxSubBlock() const;
+
+    // Rows are time-major, getBlockStride() lanes each
+    int getBlockStride() const { return numLanes; }
+
+    // Outputs, energies and raw delay reads for numSamples samples;
+    // sleeping groups read as zero. Leaves getOutputs() / getEnergies()
+    // at the last row.
+    void readBlock(int numSamples, const uint8_t* awakeGroups);
+    const float* getOutputBlock() const { return outputBlock.data(); }
+    const float* getEnergyBlock() const { return energyBlock.data(); }
+
+    // Coupling input rows for the sub-block, filled by the caller
+    float* getInputBlock() { return inputBlock.data(); }
+
+    // Loop filters over the rows, then write the lines and advance
+    void writeBlock(int numSamples, const uint8_t* awakeGroups);
+
+    // readBlock() / writeBlock() one group at a time, for callers that
+    // spread the groups over threads: beginBlock(), then readGroup() for
+    // every group, then writeGroup() for the awake ones, then endBlock().
+    // Calls for different groups touch disjoint lanes and may run
+    // concurrently; begin and end may not.
+    void beginBlock(int numSamples);
+    void readGroup(int numSamples, int group, bool awake);
+    void writeGroup(int numSamples, int group);
+    void endBlock(int numSamples);
+
+private:
+    void updateDelay(int node);
+    void deliverStrikes(int numSamples);
+    void cancelStrike(int node);
+    void writeLanes(int numSamples, int first, int count);
+    simd::BankLanes runView(int first, int count) const;
+
+    // fn(first, count) for each run of consecutive awake groups
+    template <typename Fn>
+    void forEachAwakeRun(const uint8_t* awakeGroups, Fn&& fn) const {
+        const int numGroups = numLanes / SLEEP_GROUP;
+        for (int g = 0; g < numGroups;) {
+            if (!awakeGroups[g]) {
+                g++;
+                continue;
+            }
+            int end = g + 1;
+            while (end < numGroups && awakeGroups[end]) {
+                end++;
+            }
+            fn(g * SLEEP_GROUP, (end - g) * SLEEP_GROUP);
+            g = end;
+        }
+    }
+
+    double sampleRate = 44100.0;
+    int rateDivider = 1;
+    int numNodes = 0;
+    int numLanes = 0;
+
+    // Lane state, padded to a multiple of simd::MAX_WIDTH
+    AlignedBuffer<float> lpfState, lpfCoeff;
+    AlignedBuffer<float> apfState, apfCoeff, apfEnabled;
+    AlignedBuffer<float> damping;
+    AlignedBuffer<float> fractionalDelay;
+    AlignedBuffer<int32_t> delayLength;
+    AlignedBuffer<float> energy, output;
+    AlignedBuffer<float> input;
+    AlignedBuffer<float> read0, read1, feedback;
+
+    // Per-lane delay lines carved from one arena
+    AlignedBuffer<float> lines;
+    AlignedBuffer<int32_t> lineOffset, lineMask;
+
+    // Sub-block rows, MAX_SUB_BLOCK x numLanes when subBlocks is set
+    bool subBlocks = false;
+    AlignedBuffer<float> outputBlock, read0Block, energyBlock, inputBlock, feedbackBlock;
+
+    // Control-rate per-node values (not touched by the kernel)
+    AlignedBuffer<float> frequency;
+
+    // Strikes in flight, and the nodes that have one (unordered)
+    std::vector<ExcitationTable::Strike> strikes;
+    std::vector<int> striking;
+
+    int writePos = 0;            // Wraps at the longest line
+    int writeMask = 0;
+
+    // Whole-bank kernel view, offset per run of awake groups
+    simd::BankLanes view {};
+
+    simd::Isa isa = simd::Isa::Scalar;
+    simd::BankKernel kernel = simd::processBankScalar;
+    simd::BankKernel blockKernel = simd::processBankBlockScalar;
+};
+
+} // namespace rgs
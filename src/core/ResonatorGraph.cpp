@@ -1,4 +1,10 @@
 #include "ResonatorGraph.h"
+#include "ModalBank.h"
+#include "MultiRateBank.h"
+#include "ResonatorBank.h"
+#include "ScalarBank.h"
+#include "Trace.h"
+#include "WorkerPool.h"
 #include <cmath>
 #include <algorithm>
 
@@ -23,107 +29,414 @@ static const float INTERVAL_COUPLING[13] = {
 };
 
 ResonatorGraph::ResonatorGraph() {
-    // Initialize coupling matrix to zero
-    for (auto& row : coupling) {
-        row.fill(0.0f);
+    excitation = &ExcitationTable::standard();
+    globalCoupling.reset(0.3f);
+    damping.reset(0.997f);
+    brightness.reset(0.7f);
+    configure(GraphLayout::octave());
+}
+
+void ResonatorGraph::prepare(double sr) {
+    setSampleRate(sr);
+    createBank();
+}
+
+void ResonatorGraph::prepare(double sr, const GraphLayout& newLayout) {
+    setSampleRate(sr);
+    configure(newLayout);
+}
+
+void ResonatorGraph::setSampleRate(double sr) {
+    sampleRate = sr;
+    smoothingSamples = static_cast<int>(SMOOTHING_SECONDS * sampleRate);
+    fadeSamples = static_cast<int>(topologyFadeSeconds * sampleRate);
+    dcCoeff = static_cast<float>(std::exp(-2.0 * 3.14159265358979323846 * DC_BLOCK_HZ / sampleRate));
+
+    // Start from the latest targets rather than gliding into them
+    globalCoupling.reset(globalCoupling.getTarget());
+    damping.reset(damping.getTarget());
+    brightness.reset(brightness.getTarget());
+}
+
+void ResonatorGraph::configure(const GraphLayout& newLayout) {
+    layout = newLayout;
+    layout.numNodes = std::clamp(layout.numNodes, 1, MAX_NODES);
+    layout.stepsPerOctave = layout.foldOctaves ? 12 : std::max(layout.stepsPerOctave, 1);
+    numNodes = layout.numNodes;
+    const auto n = static_cast<size_t>(numNodes);
+
+    resetNoteMapping();
+
+    // Each node rests at its own step above the lowest note
+    frequencies.resize(n);
+    for (int i = 0; i < numNodes; i++) {
+        frequencies[i] = midiToFreq(getNodePitch(i));
+    }
+
+    // Stereo panning: spread nodes across stereo field
+    panLeft.resize(n);
+    panRight.resize(n);
+    mixFromLeft.assign(n, 0.0f);
+    mixFromRight.assign(n, 0.0f);
+    mixToLeft.resize(n);
+    mixToRight.resize(n);
+    for (int i = 0; i < numNodes; i++) {
+        float pan = numNodes > 1 ? static_cast<float>(i) / (numNodes - 1) : 0.5f;  // 0 to 1
+        panLeft[i] = mixToLeft[i] = 1.0f - pan;
+        panRight[i] = mixToRight[i] = pan;
     }
+    nodeMix.reset(1.0f);
+
+    excitations.assign(n, 0.0f);
+    dcInputs.assign(n, 0.0f);
+    dcOutputs.assign(n, 0.0f);
+    previousOutputs.assign(n, 0.0f);
+    previousEnergies.assign(n, 0.0f);
 
-    // Set frequencies for each node (C4 to B4)
-    for (int i = 0; i < NUM_NODES; i++) {
-        float freq = BASE_FREQ * std::pow(2.0f, i / 12.0f);
-        nodes[i].setFrequency(freq);
+    // A fresh bank is silent: everything starts asleep
+    groupAwake.assign(static_cast<size_t>((numNodes + NodeBank::SLEEP_GROUP - 1) / NodeBank::SLEEP_GROUP), 0);
+    loudNodes.assign(n, 0);
+    numAwakeGroups = 0;
+
+    couplingScales.assign(ResonatorBank::MAX_SUB_BLOCK, 0.0f);
+    fadeScales.assign(ResonatorBank::MAX_SUB_BLOCK, 0.0f);
+
+    createBank();
+    fadingTopology = nullptr;
+    if (ownTopology) {
+        // Nothing renders during prepare(), so adopt the new layout's now
+        publishTopology(std::make_unique<CompiledTopology>(layout, currentTopology), profiling::now());
+        topologies.update();
+        switchTopology(topologies.get());
+    } else {
+        buildPartition();
     }
+}
 
-    buildTopology(Topology::Fifths);
+int ResonatorGraph::getNodeNote(int node) const {
+    return static_cast<int>(std::lround(getNodePitch(node)));
 }
 
-void ResonatorGraph::prepare(double sr) {
-    sampleRate = sr;
-    for (auto& node : nodes) {
-        node.prepare(sr);
+float ResonatorGraph::getNodePitch(int node) const {
+    return static_cast<float>(layout.lowestNote) + static_cast<float>(node) * 12.0f / layout.stepsPerOctave;
+}
+
+void ResonatorGraph::setNoteMapping(int midiNote, int node) {
+    if (midiNote >= 0 && midiNote < NUM_MIDI_NOTES) {
+        noteToNode[midiNote] = (node >= 0 && node < numNodes) ? node : -1;
     }
 }
 
-void ResonatorGraph::setTopology(Topology topo) {
-    currentTopology = topo;
-    buildTopology(topo);
+void ResonatorGraph::resetNoteMapping() {
+    for (int note = 0; note < NUM_MIDI_NOTES; note++) {
+        int offset = note - layout.lowestNote;
+        if (layout.foldOctaves) {
+            noteToNode[note] = ((offset % numNodes) + numNodes) % numNodes;
+        } else {
+            // Nearest step; exact on the default 12-step keyboard
+            offset = static_cast<int>(std::lround(offset * layout.stepsPerOctave / 12.0));
+            noteToNode[note] = (offset >= 0 && offset < numNodes) ? offset : -1;
+        }
+    }
 }
 
-void ResonatorGraph::buildTopology(Topology topo) {
-    // Clear existing connections
-    for (auto& row : coupling) {
-        row.fill(0.0f);
+void ResonatorGraph::setNodeMix(const NodeSettings* nodes, int count) {
+    for (int i = 0; i < numNodes; i++) {
+        const NodeSettings node = i < count ? nodes[i] : NodeSettings {};
+        const float spread = numNodes > 1 ? static_cast<float>(i) / (numNodes - 1) : 0.5f;
+        const float pan = node.pan >= 0.0f ? std::min(node.pan, 1.0f) : spread;
+        const float gain = std::max(node.gain, 0.0f);
+        mixFromLeft[i] = panLeft[i];
+        mixFromRight[i] = panRight[i];
+        mixToLeft[i] = (1.0f - pan) * gain;
+        mixToRight[i] = pan * gain;
     }
 
-    switch (topo) {
-        case Topology::Chromatic:
-            // Connect each node to neighbors +-1 semitone
-            for (int i = 0; i < NUM_NODES; i++) {
-                int prev = (i + NUM_NODES - 1) % NUM_NODES;
-                int next = (i + 1) % NUM_NODES;
-                coupling[i][prev] = 0.3f;
-                coupling[i][next] = 0.3f;
-            }
-            break;
+    nodeMix.reset(0.0f);
+    nodeMix.setTarget(1.0f, smoothingSamples);
+    if (!nodeMix.isRamping()) {
+        panLeft = mixToLeft;
+        panRight = mixToRight;
+    }
+}
 
-        case Topology::Fifths:
-            // Circle of fifths: each node connects to +7 and -7 semitones
-            for (int i = 0; i < NUM_NODES; i++) {
-                int fifth = (i + 7) % NUM_NODES;
-                int fourth = (i + 5) % NUM_NODES;  // -7 = +5
-                coupling[i][fifth] = 0.6f;
-                coupling[i][fourth] = 0.6f;
-            }
-            break;
+int ResonatorGraph::getNodeForNote(int midiNote) const {
+    return midiToNode(midiNote);
+}
+
+void ResonatorGraph::setEngine(Engine e) {
+    if (e != engine) {
+        engine = e;
+        createBank();
+    }
+}
+
+void ResonatorGraph::setQuality(fastmath::Quality q) {
+    quality = q;
+    bank->setQuality(q);
+}
+
+void ResonatorGraph::setExcitation(const ExcitationTable* table) {
+    finishStrikes();
+    excitation = table != nullptr ? table : &ExcitationTable::standard();
+}
+
+void ResonatorGraph::finishStrikes() {
+    bank->finishStrikes();
+}
+
+void ResonatorGraph::setWorkerPool(WorkerPool* workers) {
+    // The audio thread spins on tasks running on the workers; that is only
+    // bounded if they cannot be preempted by ordinary threads
+    pool = workers != nullptr && workers->isRealtime() ? workers : nullptr;
+    buildPartition();
+}
+
+void ResonatorGraph::wakeNode(int node) {
+    auto& awake = groupAwake[static_cast<size_t>(node / NodeBank::SLEEP_GROUP)];
+    if (!awake) {
+        awake = 1;
+        numAwakeGroups++;
+    }
+}
+
+void ResonatorGraph::sleepQuietGroups() {
+    const float* energies = bank->getEnergies();
+    const int numGroups = static_cast<int>(groupAwake.size());
 
-        case Topology::Tonnetz:
-            // Neo-Riemannian: triangular lattice with M3, m3, P5
-            for (int i = 0; i < NUM_NODES; i++) {
-                int M3 = (i + 4) % NUM_NODES;   // Major third
-                int m3 = (i + 3) % NUM_NODES;   // Minor third
-                int P5 = (i + 7) % NUM_NODES;   // Perfect fifth
+    for (int g = 0; g < numGroups; g++) {
+        if (!groupAwake[g]) {
+            continue;
+        }
+
+        // Energy tracks the delay-line read peak with a slow decay, so
+        // below SLEEP_ENERGY the whole line has been quiet for a period.
+        // Input counts as none below it too: the DC blocker lets go of a
+        // stopped feed only gradually.
+        const int first = g * NodeBank::SLEEP_GROUP;
+        const int end = std::min(numNodes, first + NodeBank::SLEEP_GROUP);
+        bool quiet = true;
+        for (int i = first; i < end && quiet; i++) {
+            quiet = energies[i] < SLEEP_ENERGY && std::abs(excitations[i]) < SLEEP_ENERGY;
+        }
 
-                coupling[i][M3] = 0.5f;
-                coupling[i][m3] = 0.4f;
-                coupling[i][P5] = 0.7f;
+        if (quiet) {
+            for (int i = first; i < end; i++) {
+                bank->silence(i);
+                excitations[i] = 0.0f;
+                dcInputs[static_cast<size_t>(i)] = 0.0f;
+                dcOutputs[static_cast<size_t>(i)] = 0.0f;
             }
-            break;
+            groupAwake[g] = 0;
+            numAwakeGroups--;
+        }
+    }
+}
+
+void ResonatorGraph::updateTail() {
+    // Each trip round the loop scales the lowest partial by about
+    // `damping`; count the trips down to SLEEP_ENERGY
+    float lowest = *std::min_element(frequencies.begin(), frequencies.end());
+    double periods = std::log(static_cast<double>(SLEEP_ENERGY))
+                   / std::log(static_cast<double>(damping.getTarget()));
+    tailSeconds.store(periods / lowest, std::memory_order_relaxed);
+}
+
+void ResonatorGraph::createBank() {
+    // Size each delay line for the lowest note that can reach the node.
+    // Folded layouts can retune a node to any octave, keyboard layouts
+    // keep each node on its own pitch.
+    lowestFrequencies.resize(static_cast<size_t>(numNodes));
+    for (int i = 0; i < numNodes; i++) {
+        lowestFrequencies[i] = midiToFreq(getNodePitch(i));
+    }
+    for (int note = 0; note < NUM_MIDI_NOTES; note++) {
+        int node = noteToNode[note];
+        if (node >= 0) {
+            lowestFrequencies[node] = std::min(lowestFrequencies[node], midiToFreq(static_cast<float>(note)));
+        }
+    }
 
-        case Topology::Harmonic:
-            // Harmonic series connections
-            // Connect to nodes that are harmonics (octave, fifth, etc.)
-            for (int i = 0; i < NUM_NODES; i++) {
-                // Octave above (if exists in our range, wraps)
-                coupling[i][(i + 12) % NUM_NODES] = 0.8f;
-                // Fifth
-                coupling[i][(i + 7) % NUM_NODES] = 0.6f;
-                // Major third
-                coupling[i][(i + 4) % NUM_NODES] = 0.4f;
+    blockBank = nullptr;
+    if (engine == Engine::Scalar) {
+        bank = std::make_unique<ScalarBank>();
+    } else if (engine == Engine::Modal) {
+        bank = std::make_unique<ModalBank>();
+    } else if (engine == Engine::MultiRate) {
+        // Rates follow the highest note that can reach each node
+        std::vector<float> highestFrequencies(static_cast<size_t>(numNodes));
+        for (int i = 0; i < numNodes; i++) {
+            highestFrequencies[i] = midiToFreq(getNodePitch(i));
+        }
+        for (int note = 0; note < NUM_MIDI_NOTES; note++) {
+            int node = noteToNode[note];
+            if (node >= 0) {
+                highestFrequencies[node] = std::max(highestFrequencies[node], midiToFreq(static_cast<float>(note)));
             }
-            break;
+        }
 
-        case Topology::Custom:
-            // Leave empty, user will set manually
-            break;
+        auto multiRate = std::make_unique<MultiRateBank>();
+        multiRate->planRates(sampleRate, numNodes, highestFrequencies.data(), brightness.getCurrent());
+        bank = std::move(multiRate);
+    } else {
+        auto simdBank = std::make_unique<ResonatorBank>(engine == Engine::Block);
+        if (engine == Engine::Block) {
+            blockBank = simdBank.get();
+        }
+        bank = std::move(simdBank);
+    }
+
+    bank->prepare(sampleRate, numNodes, lowestFrequencies.data());
+    bank->setQuality(quality);
+    for (int i = 0; i < numNodes; i++) {
+        bank->setFrequency(i, frequencies[i]);
+        bank->setDamping(i, damping.getCurrent());
+        bank->setBrightness(i, brightness.getCurrent());
+    }
+
+    std::fill(groupAwake.begin(), groupAwake.end(), 0);
+    std::fill(excitations.begin(), excitations.end(), 0.0f);
+    std::fill(dcInputs.begin(), dcInputs.end(), 0.0f);
+    std::fill(dcOutputs.begin(), dcOutputs.end(), 0.0f);
+    numAwakeGroups = 0;
+    updateTail();
+}
+
+void ResonatorGraph::setTopology(Topology topo) {
+    if (topo != currentTopology) {
+        currentTopology = topo;
+        if (ownTopology) {
+            publishTopology(std::make_unique<CompiledTopology>(layout, topo), profiling::now());
+        }
     }
 }
 
 void ResonatorGraph::setCoupling(int from, int to, float weight) {
-    if (from >= 0 && from < NUM_NODES && to >= 0 && to < NUM_NODES) {
-        coupling[from][to] = std::clamp(weight, 0.0f, 1.0f);
+    if (ownTopology && topologies.getLatest() != nullptr) {
+        const uint64_t start = profiling::now();
+        publishTopology(std::make_unique<CompiledTopology>(*topologies.getLatest(), from, to, weight), start);
+    }
+}
+
+void ResonatorGraph::setTopologyFade(double seconds) {
+    topologyFadeSeconds = std::max(seconds, 0.0);
+}
+
+void ResonatorGraph::setTracer(profiling::Tracer* t, int track, int voice) {
+    tracer = t;
+    traceTrack = track;
+    traceVoice = voice;
+}
+
+void ResonatorGraph::publishTopology(std::unique_ptr<CompiledTopology> built, uint64_t start) {
+    if (tracer != nullptr && tracer->isRecording()) {
+        profiling::TraceRecord record;
+        record.type = profiling::TraceRecord::Type::Topology;
+        record.track = static_cast<uint16_t>(traceTrack);
+        record.thread = static_cast<int16_t>(1 + traceVoice);
+        record.a = built->isEdited() ? -1 : static_cast<int>(built->getTopology());
+        record.b = built->getNumEdges();
+        record.start = start;
+        record.end = profiling::now();
+        tracer->record(record);
+    }
+    topologies.publish(std::move(built));
+}
+
+void ResonatorGraph::useTopology(const CompiledTopology* shared) {
+    ownTopology = false;
+    switchTopology(shared);
+}
+
+void ResonatorGraph::adoptTopology() {
+    // One switch at a time; the one faded from goes back to be freed
+    if (!ownTopology || fadingTopology != nullptr || !topologies.retirePrevious()) {
+        return;
+    }
+    if (topologies.updateKeepingPrevious()) {
+        switchTopology(topologies.get());
+    }
+}
+
+void ResonatorGraph::switchTopology(const CompiledTopology* next) {
+    const CompiledTopology* current = topology.load(std::memory_order_relaxed);
+
+    // Fade only what is sounding, and only between the same nodes
+    fadingTopology = nullptr;
+    if (current != nullptr && current != next && numAwakeGroups > 0 && fadeSamples > 0
+        && current->getNumNodes() == numNodes && next->getNumNodes() == numNodes) {
+        fadingTopology = current;
+        fadePosition = 0;
+    }
+
+    topology.store(next, std::memory_order_release);
+    buildPartition();
+    topologyVersion.fetch_add(1, std::memory_order_relaxed);
+}
+
+float ResonatorGraph::getCouplingGain(const CompiledTopology& edges) const {
+    // The limiter passes small inputs at half gain and a loop peaks at
+    // 1 / (1 - damping), so a node's widest input sum times this, times
+    // that, is COUPLING_LOOP_GAIN. Sums below 1 keep their weights' scale.
+    float inputs = std::max(1.0f, edges.getMaxInputWeight());
+    if (fadingTopology != nullptr) {
+        inputs = std::max(inputs, fadingTopology->getMaxInputWeight());
+    }
+    return COUPLING_LOOP_GAIN * 2.0f * (1.0f - damping.getCurrent()) / inputs;
+}
+
+int ResonatorGraph::getFadeLength(int numSamples) const {
+    return fadingTopology != nullptr ? std::min(numSamples, fadeSamples - fadePosition) : 0;
+}
+
+float ResonatorGraph::getFadeMix(int sample) const {
+    // Share of the new topology in coupling `sample` samples from now
+    return static_cast<float>(fadePosition + sample + 1) / static_cast<float>(fadeSamples);
+}
+
+void ResonatorGraph::buildPartition() {
+    // Until prepare() and useTopology() agree on the nodes
+    const CompiledTopology* edges = topology.load(std::memory_order_relaxed);
+    if (edges == nullptr || edges->getNumNodes() != numNodes) {
+        return;
     }
+
+    // Two parts per thread, so a part that sleeps or stalls leaves others
+    // to claim. A pool that got no workers renders serially.
+    const int threads = pool != nullptr ? pool->getNumThreads() : 1;
+    const int parts = threads > 1 ? 2 * threads : 1;
+    partition.build(numNodes, edges->getEdgeStarts(), edges->getEdgeTargets(), edges->getEdgeWeights(), parts);
 }
 
 void ResonatorGraph::setGlobalCoupling(float amount) {
-    globalCoupling = std::clamp(amount, 0.0f, 1.0f);
+    globalCoupling.setTarget(std::clamp(amount, 0.0f, 1.0f), smoothingSamples);
 }
 
 void ResonatorGraph::noteOn(int midiNote, float velocity) {
     int node = midiToNode(midiNote);
-    if (node >= 0 && node < NUM_NODES) {
-        // Update frequency to match exact MIDI note
-        nodes[node].setFrequency(midiToFreq(midiNote));
-        nodes[node].excite(velocity);
+    if (node >= 0 && node < numNodes) {
+        // Update frequency to match exact MIDI note (a no-op on keyboard
+        // layouts, where every note has its own node, unless a grid puts
+        // no step on it)
+        float freq = midiToFreq(static_cast<float>(midiNote));
+        if (freq != frequencies[node]) {
+            frequencies[node] = freq;
+            bank->setFrequency(node, freq);
+        }
+        bank->excite(node, *excitation, velocity);
+        wakeNode(node);
+
+        if (tracer != nullptr && tracer->isRecording()) {
+            profiling::TraceRecord record;
+            record.type = profiling::TraceRecord::Type::Strike;
+            record.track = static_cast<uint16_t>(traceTrack);
+            record.thread = static_cast<int16_t>(1 + traceVoice);
+            record.a = node;
+            record.b = midiNote;
+            record.velocity = velocity;
+            record.start = record.end = profiling::now();
+            tracer->record(record);
+        }
     }
 }
 
@@ -133,46 +446,234 @@ void ResonatorGraph::noteOff(int midiNote) {
     // Could add damper behavior here
 }
 
+bool ResonatorGraph::post(const GraphCommand& command) {
+    return commands.push(command);
+}
+
+void ResonatorGraph::drainCommands() {
+    GraphCommand command;
+    while (commands.pop(command)) {
+        switch (command.type) {
+            case GraphCommand::Type::NoteOn:
+                noteOn(command.a, command.value);
+                break;
+            case GraphCommand::Type::NoteOff:
+                noteOff(command.a);
+                break;
+            case GraphCommand::Type::Reset:
+                reset();
+                break;
+        }
+    }
+}
+
 void ResonatorGraph::processBlock(float* leftOut, float* rightOut, int numSamples) {
+    phaseTimes.clear();
+    phaseTimer.start();
+
+    adoptTopology();
+    drainCommands();
+    phaseTimer.lap(profiling::Phase::Events);
+    render(leftOut, rightOut, numSamples);
+    updateTail();
+    phaseTimer.lap(profiling::Phase::Other);
+}
+
+void ResonatorGraph::processBlock(float* leftOut, float* rightOut, int numSamples,
+                                  const NoteEvent* events, int numEvents) {
+    phaseTimes.clear();
+    phaseTimer.start();
+
+    adoptTopology();
+    drainCommands();
+    phaseTimer.lap(profiling::Phase::Events);
+
+    // Split the block at event timestamps
+    int pos = 0;
+    for (int e = 0; e < numEvents; e++) {
+        int offset = std::clamp(events[e].sampleOffset, pos, numSamples);
+        if (offset > pos) {
+            render(leftOut + pos, rightOut + pos, offset - pos);
+            pos = offset;
+        }
+        handleEvent(events[e]);
+        phaseTimer.lap(profiling::Phase::Events);
+    }
+
+    if (pos < numSamples) {
+        render(leftOut + pos, rightOut + pos, numSamples - pos);
+    }
+    updateTail();
+    phaseTimer.lap(profiling::Phase::Other);
+}
+
+void ResonatorGraph::handleEvent(const NoteEvent& event) {
+    switch (event.type) {
+        case NoteEvent::Type::NoteOn:
+            noteOn(event.note, event.velocity);
+            break;
+        case NoteEvent::Type::NoteOff:
+            noteOff(event.note);
+            break;
+    }
+}
+
+void ResonatorGraph::render(float* leftOut, float* rightOut, int numSamples) {
+    if (numAwakeGroups == 0) {
+        // Nothing sounding: keep the parameter glides moving and stop
+        std::fill(leftOut, leftOut + numSamples, 0.0f);
+        std::fill(rightOut, rightOut + numSamples, 0.0f);
+        globalCoupling.skip(numSamples);
+        advanceNodeParameters(numSamples);
+        fadingTopology = nullptr;   // Nothing to fade
+        phaseTimer.lap(profiling::Phase::Other);
+        return;
+    }
+
+    // Sub-divide only while per-node parameters are gliding
+    int pos = 0;
+    while (pos < numSamples) {
+        int length = numSamples - pos;
+        if (damping.isRamping() || brightness.isRamping() || nodeMix.isRamping()) {
+            length = std::min(length, CONTROL_BLOCK);
+            advanceNodeParameters(length);
+            phaseTimer.lap(profiling::Phase::Other);
+        }
+        renderSamples(leftOut + pos, rightOut + pos, length);
+        pos += length;
+    }
+
+    sleepQuietGroups();
+    if (numAwakeGroups == 0 || (fadingTopology != nullptr && fadePosition >= fadeSamples)) {
+        fadingTopology = nullptr;
+    }
+    phaseTimer.lap(profiling::Phase::Other);
+}
+
+void ResonatorGraph::advanceNodeParameters(int numSamples) {
+    if (damping.isRamping()) {
+        float d = damping.skip(numSamples);
+        for (int i = 0; i < numNodes; i++) {
+            bank->setDamping(i, d);
+        }
+    }
+    if (brightness.isRamping()) {
+        float b = brightness.skip(numSamples);
+        for (int i = 0; i < numNodes; i++) {
+            bank->setBrightness(i, b);
+        }
+    }
+    if (nodeMix.isRamping()) {
+        float t = nodeMix.skip(numSamples);
+        for (int i = 0; i < numNodes; i++) {
+            panLeft[i] = mixFromLeft[i] + (mixToLeft[i] - mixFromLeft[i]) * t;
+            panRight[i] = mixFromRight[i] + (mixToRight[i] - mixFromRight[i]) * t;
+        }
+        if (!nodeMix.isRamping()) {
+            // Land exactly on the targets
+            panLeft = mixToLeft;
+            panRight = mixToRight;
+        }
+    }
+}
+
+void ResonatorGraph::renderSamples(float* leftOut, float* rightOut, int numSamples) {
+    if (blockBank != nullptr) {
+        if (pool != nullptr && partition.getNumParts() > 1 && numAwakeGroups >= PARALLEL_MIN_GROUPS) {
+            renderPartitioned(leftOut, rightOut, numSamples);
+        } else {
+            renderSubBlocks(leftOut, rightOut, numSamples);
+        }
+        return;
+    }
+
     // Coupling scale: audible but controlled
     // globalCoupling 0.3 = subtle, 0.7 = obvious, 1.0 = dramatic
-    float couplingScale = globalCoupling * 0.08f;
+    const CompiledTopology& edges = *topology.load(std::memory_order_relaxed);
+    const float couplingGain = getCouplingGain(edges);
+    float couplingScale = globalCoupling.getCurrent() * couplingGain;
 
-    for (int s = 0; s < numSamples; s++) {
-        // Calculate sympathetic coupling for this sample
-        std::array<float, NUM_NODES> excitations{};
-        excitations.fill(0.0f);
+    // Stable views into the bank, updated in place by process()
+    const float* energies = bank->getEnergies();
+    const float* outputs = bank->getOutputs();
+    float* excitation = excitations.data();
+
+    // Sleeping groups hold zero state and zero excitation: every loop
+    // below visits awake groups only. Coupling can wake a group mid-loop.
+    const uint8_t* awake = groupAwake.data();
+    const int numGroups = static_cast<int>(groupAwake.size());
+    auto groupEnd = [this](int g) { return std::min(numNodes, (g + 1) * NodeBank::SLEEP_GROUP); };
+
+    // Gather energy from coupled nodes over one topology's edges
+    auto scatter = [&](const CompiledTopology& edges, float scale) {
+        const int* starts = edges.getEdgeStarts();
+        const int* targets = edges.getEdgeTargets();
+        const float* weights = edges.getEdgeWeights();
 
-        // Gather energy from coupled nodes
-        for (int src = 0; src < NUM_NODES; src++) {
-            float srcEnergy = nodes[src].getEnergy();
-            if (srcEnergy < 0.005f) continue;  // Gate: skip quiet nodes
+        for (int g = 0; g < numGroups; g++) {
+            if (!awake[g]) continue;
 
-            float srcOutput = nodes[src].getOutput();
+            for (int src = g * NodeBank::SLEEP_GROUP; src < groupEnd(g); src++) {
+                float srcEnergy = energies[src];
+                if (srcEnergy < 0.005f) continue;  // Gate: skip quiet nodes
 
-            for (int tgt = 0; tgt < NUM_NODES; tgt++) {
-                if (src != tgt && coupling[src][tgt] > 0.0f) {
-                    excitations[tgt] += srcOutput * coupling[src][tgt] * couplingScale;
+                float srcOutput = outputs[src];
+
+                for (int e = starts[src]; e < starts[src + 1]; e++) {
+                    excitation[targets[e]] += srcOutput * weights[e] * scale;
+                    wakeNode(targets[e]);
                 }
             }
         }
+    };
+
+    const int fadeLength = getFadeLength(numSamples);
+
+    for (int s = 0; s < numSamples; s++) {
+        if (globalCoupling.isRamping()) {
+            couplingScale = globalCoupling.next() * couplingGain;
+        }
+
+        // Calculate sympathetic coupling for this sample
+        for (int g = 0; g < numGroups; g++) {
+            if (awake[g]) {
+                std::fill(excitation + g * NodeBank::SLEEP_GROUP, excitation + groupEnd(g), 0.0f);
+            }
+        }
+
+        // While a topology switch fades, both topologies couple
+        if (s < fadeLength) {
+            const float mix = getFadeMix(s);
+            scatter(*fadingTopology, couplingScale * (1.0f - mix));
+            scatter(edges, couplingScale * mix);
+        } else {
+            scatter(edges, couplingScale);
+        }
 
         // Limit per-node excitation to prevent runaway feedback
-        for (int i = 0; i < NUM_NODES; i++) {
-            excitations[i] = std::tanh(excitations[i] * 5.0f) * 0.1f;
+        for (int g = 0; g < numGroups; g++) {
+            if (!awake[g]) continue;
+
+            for (int i = g * NodeBank::SLEEP_GROUP; i < groupEnd(g); i++) {
+                excitation[i] = fastmath::tanh(quality, blockDc(i, excitation[i]) * 5.0f) * 0.1f;
+            }
         }
+        phaseTimer.lap(profiling::Phase::Coupling);
+
+        // Process every awake node with sympathetic excitation
+        bank->process(excitation, awake);
+        phaseTimer.lap(profiling::Phase::Nodes);
 
-        // Process each node with sympathetic excitation
         float left = 0.0f;
         float right = 0.0f;
 
-        for (int i = 0; i < NUM_NODES; i++) {
-            float sample = nodes[i].process(excitations[i]);
+        for (int g = 0; g < numGroups; g++) {
+            if (!awake[g]) continue;
 
-            // Stereo panning: spread nodes across stereo field
-            float pan = static_cast<float>(i) / (NUM_NODES - 1);  // 0 to 1
-            left += sample * (1.0f - pan);
-            right += sample * pan;
+            for (int i = g * NodeBank::SLEEP_GROUP; i < groupEnd(g); i++) {
+                left += outputs[i] * panLeft[i];
+                right += outputs[i] * panRight[i];
+            }
         }
 
         // Normalize and soft limit
@@ -181,53 +682,353 @@ void ResonatorGraph::processBlock(float* leftOut, float* rightOut, int numSample
         right *= gain;
 
         // Soft clip
-        leftOut[s] = std::tanh(left * 2.0f) * 0.8f;
-        rightOut[s] = std::tanh(right * 2.0f) * 0.8f;
+        leftOut[s] = fastmath::tanh(quality, left * 2.0f) * 0.8f;
+        rightOut[s] = fastmath::tanh(quality, right * 2.0f) * 0.8f;
+        phaseTimer.lap(profiling::Phase::Output);
     }
+    fadePosition += fadeLength;
 }
 
-std::array<float, ResonatorGraph::NUM_NODES> ResonatorGraph::getEnergies() const {
-    std::array<float, NUM_NODES> energies;
-    for (int i = 0; i < NUM_NODES; i++) {
-        energies[i] = nodes[i].getEnergy();
+void ResonatorGraph::renderSubBlocks(float* leftOut, float* rightOut, int numSamples) {
+    // Same coupling, limiter and mix as renderSamples, reordered: read a
+    // whole sub-block of outputs, derive every sample's coupling input
+    // from the outputs one sample earlier, then run the loop filters.
+    ResonatorBank& blocks = *blockBank;
+    const int stride = blocks.getBlockStride();
+    const int maxLength = blocks.getMaxSubBlock();
+    const float* outputBlock = blocks.getOutputBlock();
+    const float* energyBlock = blocks.getEnergyBlock();
+    float* inputBlock = blocks.getInputBlock();
+
+    const float* energies = bank->getEnergies();
+    const float* outputs = bank->getOutputs();
+    const CompiledTopology& edges = *topology.load(std::memory_order_relaxed);
+    const float couplingGain = getCouplingGain(edges);
+    float couplingScale = globalCoupling.getCurrent() * couplingGain;
+
+    const uint8_t* awake = groupAwake.data();
+    const int numGroups = static_cast<int>(groupAwake.size());
+    auto groupEnd = [this](int g) { return std::min(numNodes, (g + 1) * NodeBank::SLEEP_GROUP); };
+
+    for (int pos = 0; pos < numSamples;) {
+        const int length = std::min(maxLength, numSamples - pos);
+
+        // Coupling into the first sample reads the previous sub-block's end
+        std::copy_n(outputs, numNodes, previousOutputs.data());
+        std::copy_n(energies, numNodes, previousEnergies.data());
+        blocks.readBlock(length, awake);
+        phaseTimer.lap(profiling::Phase::Nodes);
+
+        // Input rows cover whole groups so padding lanes stay silent
+        auto clearInputs = [&](int g) {
+            for (int k = 0; k < length; k++) {
+                std::fill_n(inputBlock + k * stride + g * NodeBank::SLEEP_GROUP, NodeBank::SLEEP_GROUP, 0.0f);
+            }
+        };
+        for (int g = 0; g < numGroups; g++) {
+            if (awake[g]) {
+                clearInputs(g);
+            }
+        }
+
+        // One topology's edges into sample k's inputs
+        auto scatter = [&](const CompiledTopology& from, int k, float scale) {
+            const int* starts = from.getEdgeStarts();
+            const int* targets = from.getEdgeTargets();
+            const float* weights = from.getEdgeWeights();
+            const float* srcEnergies = k == 0 ? previousEnergies.data() : energyBlock + (k - 1) * stride;
+            const float* srcOutputs = k == 0 ? previousOutputs.data() : outputBlock + (k - 1) * stride;
+            float* excitation = inputBlock + k * stride;
+
+            for (int g = 0; g < numGroups; g++) {
+                if (!awake[g]) continue;
+
+                for (int src = g * NodeBank::SLEEP_GROUP; src < groupEnd(g); src++) {
+                    if (srcEnergies[src] < 0.005f) continue;  // Gate: skip quiet nodes
+
+                    float srcOutput = srcOutputs[src];
+
+                    for (int e = starts[src]; e < starts[src + 1]; e++) {
+                        const int target = targets[e];
+                        const int targetGroup = target / NodeBank::SLEEP_GROUP;
+                        if (!awake[targetGroup]) {
+                            // Read as silence so far: zero state, zero input
+                            wakeNode(target);
+                            clearInputs(targetGroup);
+                        }
+                        excitation[target] += srcOutput * weights[e] * scale;
+                    }
+                }
+            }
+        };
+
+        const int fadeLength = getFadeLength(length);
+        for (int k = 0; k < length; k++) {
+            if (globalCoupling.isRamping()) {
+                couplingScale = globalCoupling.next() * couplingGain;
+            }
+
+            if (k < fadeLength) {
+                const float mix = getFadeMix(k);
+                scatter(*fadingTopology, k, couplingScale * (1.0f - mix));
+                scatter(edges, k, couplingScale * mix);
+            } else {
+                scatter(edges, k, couplingScale);
+            }
+
+            float* excitation = inputBlock + k * stride;
+
+            for (int g = 0; g < numGroups; g++) {
+                if (!awake[g]) continue;
+
+                for (int i = g * NodeBank::SLEEP_GROUP; i < groupEnd(g); i++) {
+                    excitation[i] = fastmath::tanh(quality, blockDc(i, excitation[i]) * 5.0f) * 0.1f;
+                }
+            }
+        }
+
+        fadePosition += fadeLength;
+        phaseTimer.lap(profiling::Phase::Coupling);
+        blocks.writeBlock(length, awake);
+        phaseTimer.lap(profiling::Phase::Nodes);
+        mixSubBlock(leftOut + pos, rightOut + pos, length);
+        phaseTimer.lap(profiling::Phase::Output);
+        keepLastInputs(length);
+        phaseTimer.lap(profiling::Phase::Other);
+
+        pos += length;
     }
-    return energies;
+}
+
+void ResonatorGraph::renderPartitioned(float* leftOut, float* rightOut, int numSamples) {
+    // renderSubBlocks with the coupling turned around: each target sums
+    // its incoming edges, so a part only writes its own groups' rows
+    ResonatorBank& blocks = *blockBank;
+    const int stride = blocks.getBlockStride();
+    const int maxLength = blocks.getMaxSubBlock();
+    const float* outputBlock = blocks.getOutputBlock();
+    const float* energyBlock = blocks.getEnergyBlock();
+    float* inputBlock = blocks.getInputBlock();
+
+    const float* energies = bank->getEnergies();
+    const float* outputs = bank->getOutputs();
+    const CompiledTopology& edges = *topology.load(std::memory_order_relaxed);
+    const float couplingGain = getCouplingGain(edges);
+
+    uint8_t* awake = groupAwake.data();
+    auto groupEnd = [this](int g) { return std::min(numNodes, (g + 1) * NodeBank::SLEEP_GROUP); };
+
+    int length = 0;
+    int fadeLength = 0;
+
+    // Nodes above the coupling gate on some sample of the sub-block;
+    // edges from the rest are skipped without looking at their rows
+    uint8_t* loud = loudNodes.data();
+
+    auto readPart = [&](int part) {
+        const int* groups = partition.getPartGroups(part);
+        for (int p = 0; p < partition.getPartSize(part); p++) {
+            const int g = groups[p];
+            const int first = g * NodeBank::SLEEP_GROUP;
+            std::fill(loud + first, loud + groupEnd(g), uint8_t { 0 });
+            blocks.readGroup(length, g, awake[g] != 0);
+            if (!awake[g]) {
+                continue;
+            }
+
+            for (int k = 0; k < length; k++) {
+                const float* srcEnergies = k == 0 ? previousEnergies.data() : energyBlock + (k - 1) * stride;
+                for (int i = first; i < groupEnd(g); i++) {
+                    loud[i] |= srcEnergies[i] >= 0.005f;
+                }
+            }
+        }
+    };
+
+    auto couplePart = [&](int part) {
+        const int* groups = partition.getPartGroups(part);
+        for (int p = 0; p < partition.getPartSize(part); p++) {
+            const int g = groups[p];
+            const int first = g * NodeBank::SLEEP_GROUP;
+
+            // Same sums as the scatter in renderSubBlocks: zero, then the
+            // sources in ascending order, the faded-from topology's first
+            bool reached = awake[g] != 0;
+            auto gather = [&](const CompiledTopology& from, int i, int count, const float* scales) {
+                const int* starts = from.getInputStarts();
+                const int* sources = from.getInputSources();
+                const float* weights = from.getInputWeights();
+
+                for (int e = starts[i]; e < starts[i + 1]; e++) {
+                    const int src = sources[e];
+                    if (!loud[src]) continue;
+
+                    for (int k = 0; k < count; k++) {
+                        const float* srcEnergies = k == 0 ? previousEnergies.data() : energyBlock + (k - 1) * stride;
+                        if (srcEnergies[src] < 0.005f) continue;  // Gate: skip quiet nodes
+
+                        const float* srcOutputs = k == 0 ? previousOutputs.data() : outputBlock + (k - 1) * stride;
+                        inputBlock[k * stride + i] += srcOutputs[src] * weights[e] * scales[k];
+                        reached = true;
+                    }
+                }
+            };
+
+            for (int i = first; i < groupEnd(g); i++) {
+                for (int k = 0; k < length; k++) {
+                    inputBlock[k * stride + i] = 0.0f;
+                }
+                if (fadeLength > 0) {
+                    gather(*fadingTopology, i, fadeLength, fadeScales.data());
+                }
+                gather(edges, i, length, couplingScales.data());
+            }
+
+            // A sleeping group nothing reached stays asleep; its rows are
+            // never read
+            if (!reached) {
+                continue;
+            }
+            awake[g] = 1;
+
+            for (int k = 0; k < length; k++) {
+                float* excitation = inputBlock + k * stride;
+                for (int i = first; i < groupEnd(g); i++) {
+                    excitation[i] = fastmath::tanh(quality, blockDc(i, excitation[i]) * 5.0f) * 0.1f;
+                }
+                std::fill(excitation + groupEnd(g), excitation + first + NodeBank::SLEEP_GROUP, 0.0f);
+            }
+            blocks.writeGroup(length, g);
+        }
+    };
+
+    const int numParts = partition.getNumParts();
+    for (int pos = 0; pos < numSamples;) {
+        length = std::min(maxLength, numSamples - pos);
+
+        std::copy_n(outputs, numNodes, previousOutputs.data());
+        std::copy_n(energies, numNodes, previousEnergies.data());
+        float couplingScale = globalCoupling.getCurrent() * couplingGain;
+        fadeLength = getFadeLength(length);
+        for (int k = 0; k < length; k++) {
+            if (globalCoupling.isRamping()) {
+                couplingScale = globalCoupling.next() * couplingGain;
+            }
+            couplingScales[k] = couplingScale;
+            if (k < fadeLength) {
+                const float mix = getFadeMix(k);
+                fadeScales[k] = couplingScale * (1.0f - mix);
+                couplingScales[k] = couplingScale * mix;
+            }
+        }
+        fadePosition += fadeLength;
+
+        // Every part's reads must land before any part gathers from them
+        // and overwrites its lines. The gather tasks run their groups'
+        // loop filters too, so those count as coupling here.
+        blocks.beginBlock(length);
+        pool->run(numParts, readPart);
+        phaseTimer.lap(profiling::Phase::Nodes);
+        pool->run(numParts, couplePart);
+        phaseTimer.lap(profiling::Phase::Coupling);
+        blocks.endBlock(length);
+
+        numAwakeGroups = static_cast<int>(std::count_if(groupAwake.begin(), groupAwake.end(),
+                                                        [](uint8_t a) { return a != 0; }));
+        phaseTimer.lap(profiling::Phase::Other);
+        mixSubBlock(leftOut + pos, rightOut + pos, length);
+        phaseTimer.lap(profiling::Phase::Output);
+        keepLastInputs(length);
+        phaseTimer.lap(profiling::Phase::Other);
+
+        pos += length;
+    }
+}
+
+void ResonatorGraph::mixSubBlock(float* leftOut, float* rightOut, int numSamples) {
+    const float* outputBlock = blockBank->getOutputBlock();
+    const int stride = blockBank->getBlockStride();
+    const uint8_t* awake = groupAwake.data();
+    const int numGroups = static_cast<int>(groupAwake.size());
+    auto groupEnd = [this](int g) { return std::min(numNodes, (g + 1) * NodeBank::SLEEP_GROUP); };
+
+    for (int k = 0; k < numSamples; k++) {
+        const float* row = outputBlock + k * stride;
+        float left = 0.0f;
+        float right = 0.0f;
+
+        for (int g = 0; g < numGroups; g++) {
+            if (!awake[g]) continue;
+
+            for (int i = g * NodeBank::SLEEP_GROUP; i < groupEnd(g); i++) {
+                left += row[i] * panLeft[i];
+                right += row[i] * panRight[i];
+            }
+        }
+
+        float gain = 0.15f;
+        left *= gain;
+        right *= gain;
+
+        leftOut[k] = fastmath::tanh(quality, left * 2.0f) * 0.8f;
+        rightOut[k] = fastmath::tanh(quality, right * 2.0f) * 0.8f;
+    }
+}
+
+void ResonatorGraph::keepLastInputs(int numSamples) {
+    // sleepQuietGroups looks at the last sample's input
+    const float* lastInputs = blockBank->getInputBlock() + (numSamples - 1) * blockBank->getBlockStride();
+    const int numGroups = static_cast<int>(groupAwake.size());
+    for (int g = 0; g < numGroups; g++) {
+        if (groupAwake[g]) {
+            const int first = g * NodeBank::SLEEP_GROUP;
+            std::copy(lastInputs + first, lastInputs + std::min(numNodes, first + NodeBank::SLEEP_GROUP),
+                      excitations.data() + first);
+        }
+    }
+}
+
+const float* ResonatorGraph::getEnergies() const {
+    return bank->getEnergies();
 }
 
 float ResonatorGraph::getCoupling(int from, int to) const {
-    if (from >= 0 && from < NUM_NODES && to >= 0 && to < NUM_NODES) {
-        return coupling[from][to];
+    const CompiledTopology& edges = getCompiledTopology();
+    if (from >= 0 && from < edges.getNumNodes() && to >= 0 && to < edges.getNumNodes()) {
+        return edges.getWeight(from, to);
     }
     return 0.0f;
 }
 
 void ResonatorGraph::setDamping(float d) {
-    damping = std::clamp(d, 0.9f, 0.9999f);
-    for (auto& node : nodes) {
-        node.setDamping(damping);
-    }
+    damping.setTarget(std::clamp(d, 0.9f, 0.9999f), smoothingSamples);
 }
 
 void ResonatorGraph::setBrightness(float b) {
-    brightness = std::clamp(b, 0.0f, 1.0f);
-    for (auto& node : nodes) {
-        node.setBrightness(brightness);
-    }
+    brightness.setTarget(std::clamp(b, 0.0f, 1.0f), smoothingSamples);
 }
 
 void ResonatorGraph::reset() {
-    for (auto& node : nodes) {
-        node.reset();
-    }
+    bank->reset();
+    std::fill(groupAwake.begin(), groupAwake.end(), 0);
+    std::fill(excitations.begin(), excitations.end(), 0.0f);
+    std::fill(dcInputs.begin(), dcInputs.end(), 0.0f);
+    std::fill(dcOutputs.begin(), dcOutputs.end(), 0.0f);
+    numAwakeGroups = 0;
+    fadingTopology = nullptr;
 }
 
-float ResonatorGraph::midiToFreq(int midiNote) const {
-    return 440.0f * std::pow(2.0f, (midiNote - 69) / 12.0f);
+float ResonatorGraph::midiToFreq(float pitch) const {
+    // Tuning does not follow the quality setting
+    return 440.0f * fastmath::pow2((pitch - 69.0f) / 12.0f);
 }
 
 int ResonatorGraph::midiToNode(int midiNote) const {
-    // Map MIDI note to node index (0-11)
-    return midiNote % NUM_NODES;
+    // Map MIDI note to node index (-1: not mapped)
+    if (midiNote < 0 || midiNote >= NUM_MIDI_NOTES) {
+        return -1;
+    }
+    return noteToNode[midiNote];
 }
 
 } // namespace rgs
@@ -1,20 +1,50 @@
 #pragma once
 
-#include "Resonator.h"
-#include <vector>
+#include "CompiledTopology.h"
+#include "GraphCommand.h"
+#include "GraphPartition.h"
+#include "NodeBank.h"
+#include "NoteEvent.h"
+#include "ObjectExchange.h"
+#include "Profiler.h"
+#include "Ramp.h"
+#include "SpscQueue.h"
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace rgs::profiling {
+class Tracer;
+}
 
 namespace rgs {
 
+class ResonatorBank;
+class WorkerPool;
+
 /**
- * Graph topology types
+ * Node processing engines
  */
-enum class Topology {
-    Chromatic,   // Each node connects to +-1 semitone
-    Fifths,      // Circle of fifths connections
-    Tonnetz,     // Neo-Riemannian triangular lattice
-    Harmonic,    // Harmonic series from each node
-    Custom       // User-defined
+enum class Engine {
+    Scalar,      // One Resonator object per node (reference path)
+    Simd,        // ResonatorBank: structure-of-arrays, SIMD across nodes
+    Block,       // ResonatorBank advanced a sub-block at a time (opt-in)
+    MultiRate,   // MultiRateBank: low nodes at 1/2 or 1/4 rate (opt-in)
+    Modal        // ModalBank: damped sinusoids per node, no delay lines (opt-in)
+};
+
+/**
+ * How one node sounds in a graph's stereo mix
+ */
+struct NodeSettings {
+    float gain = 1.0f;    // 0 mutes the node; it still couples
+    float pan = -1.0f;    // 0 left - 1 right; negative spreads nodes by pitch
+
+    bool operator==(const NodeSettings& other) const { return gain == other.gain && pan == other.pan; }
+    bool operator!=(const NodeSettings& other) const { return !(*this == other); }
 };
 
 /**
@@ -22,21 +52,151 @@ enum class Topology {
  *
  * Energy flows between resonators based on the graph topology.
  * When you pluck one string, others resonate sympathetically.
+ *
+ * The node count is chosen at prepare() time; all storage is allocated
+ * there so the audio thread never allocates.
+ *
+ * Threading: processBlock and the direct setters belong to the audio
+ * thread. Other threads talk to a running graph through post().
+ * Coupling is the exception: setTopology() and setCoupling() compile a
+ * new CompiledTopology on their own (non-audio) thread, and the audio
+ * thread switches to it at the start of a block by swapping a pointer.
+ * A sounding graph crossfades from the old coupling to the new over
+ * TOPOLOGY_FADE_SECONDS (setTopologyFade), so an edit never clicks.
+ *
+ * Damping, brightness and global coupling glide to new values over
+ * SMOOTHING_SECONDS: coupling per sample, the per-node values every
+ * CONTROL_BLOCK samples while they move. prepare() snaps them.
+ *
+ * Coupling input goes through a one-pole DC blocker per node. A loop's
+ * gain at DC is 1 / (1 - damping), so without it coupled nodes feed DC
+ * round the graph and settle at a constant offset instead of decaying.
+ * A loop peaks nearly as high at each partial, and partials shared by
+ * two nodes (C4's third, G4's second) close a loop through the coupling.
+ * The coupling gain scales with 1 - damping and the topology's largest
+ * input weight so that loop stays at COUPLING_LOOP_GAIN or below at full
+ * coupling: sympathetic ringing builds and dies away rather than
+ * sustaining itself.
+ *
+ * Sleep: once every node of a NodeBank::SLEEP_GROUP has decayed below
+ * SLEEP_ENERGY with no coupling input, the group is zeroed and skipped.
+ * A strike or coupling from an awake node wakes it. With every group
+ * asleep, processBlock only clears the output.
+ *
+ * Engine::Block renders in sub-blocks no longer than the shortest loop
+ * delay (ResonatorBank::getMaxSubBlock, at most 64 samples): outputs for
+ * the whole sub-block come first, then coupling for every sample, then
+ * the loop filters. Coupling still reaches a node one sample after its
+ * source sounds, as in the per-sample engines, so the output matches
+ * Engine::Simd to rounding. High notes shorten the sub-block (C8 at
+ * 48 kHz allows 10 samples), so it pays off on low and mid layouts.
+ *
+ * Given a WorkerPool, Engine::Block spreads each sub-block over its
+ * threads by GraphPartition parts: every part reads its groups, then,
+ * after all have, gathers coupling into its groups over the incoming
+ * edges and runs their loop filters. Cross-part edges read the other
+ * parts' output rows between the two phases, so nothing is delayed and
+ * the output is identical to the serial path. Fewer than
+ * PARALLEL_MIN_GROUPS awake groups, or a single part, render serially.
  */
 class ResonatorGraph {
 public:
-    static constexpr int NUM_NODES = 12;  // One octave for now
-    static constexpr float BASE_FREQ = 261.63f;  // C4
+    static constexpr int MAX_NODES = 512;
+    static constexpr int NUM_MIDI_NOTES = 128;
+    static constexpr int CONTROL_BLOCK = 32;
+    static constexpr double SMOOTHING_SECONDS = 0.02;
+    static constexpr double TOPOLOGY_FADE_SECONDS = 0.02;
+    static constexpr float SLEEP_ENERGY = 1e-5f;   // -100 dB
+    static constexpr int PARALLEL_MIN_GROUPS = 4;
+    static constexpr double DC_BLOCK_HZ = 20.0;     // Coupling input highpass
+    static constexpr float COUPLING_LOOP_GAIN = 0.9f;   // At coupling 1.0
 
     ResonatorGraph();
 
+    // Keep the current layout
     void prepare(double sampleRate);
+    void prepare(double sampleRate, const GraphLayout& newLayout);
+
+    const GraphLayout& getLayout() const { return layout; }
+    int getNumNodes() const { return numNodes; }
+
+    // MIDI note a node is tuned to when it is not playing; grid layouts
+    // fall between notes, getNodePitch() has the fraction
+    int getNodeNote(int node) const;
+    float getNodePitch(int node) const;
+
+    // Note -> node map. The layout sets a default, which
+    // resetNoteMapping() restores; any note can be remapped (node -1
+    // ignores the note). Audio thread, or any thread while nothing
+    // renders. Delay lines are sized for the map at prepare(); a note
+    // remapped below its node's range sounds at the lowest pitch the line
+    // holds until the next prepare(sampleRate).
+    void setNoteMapping(int midiNote, int node);
+    void resetNoteMapping();
+    int getNodeForNote(int midiNote) const;
+
+    // Level and position of each node in the output; nodes from count on
+    // take the defaults. Glides over SMOOTHING_SECONDS. Realtime safe.
+    void setNodeMix(const NodeSettings* nodes, int count);
+
+    // Select the node engine. Allocates: call before prepare(), not while
+    // the audio thread is running.
+    void setEngine(Engine e);
+    Engine getEngine() const { return engine; }
+
+    // Threads for Engine::Block (nullptr: the audio thread alone). A pool
+    // whose workers are not realtime (WorkerPool::isRealtime()) is
+    // ignored and the graph renders serially. The pool must outlive the
+    // graph or the next call. Not for the audio thread.
+    void setWorkerPool(WorkerPool* workers);
+    const GraphPartition& getPartition() const { return partition; }
+
+    // Record strikes and coupling rebuilds while tracer is recording, on
+    // the given track and voice (see Trace.h). nullptr stops. The tracer
+    // must outlive the graph or the next call. Not for the audio thread.
+    void setTracer(profiling::Tracer* tracer, int track, int voice);
+
+    // Accuracy of every tanh in the audio path (loop clamp, coupling
+    // limiter, output soft clip). Realtime safe.
+    void setQuality(fastmath::Quality q);
+    fastmath::Quality getQuality() const { return quality; }
+
+    // Shapes note-ons strike with; nullptr selects
+    // ExcitationTable::standard(). The table is not copied: strikes read
+    // it over the following loop period, until finishStrikes() or the
+    // next setExcitation(). Realtime safe.
+    void setExcitation(const ExcitationTable* table);
+    void finishStrikes();
+    const ExcitationTable& getExcitation() const { return *excitation; }
 
-    // Topology
+    // Topology. Both compile a new CompiledTopology, which the audio
+    // thread picks up at the start of the next processBlock: allocates,
+    // call from one non-audio thread. setTopology rebuilds only if topo
+    // changes; setCoupling copies the newest topology with one edge set.
+    // Neither applies once useTopology() has shared one.
     void setTopology(Topology topo);
     void setCoupling(int from, int to, float weight);
+
+    // Render coupling from a topology owned elsewhere and shared between
+    // graphs (VoiceManager) instead of the graph's own. Realtime safe. A
+    // sounding graph fades from the one it was rendering, so the caller
+    // keeps both alive until isTopologyFading() is false. Its node count
+    // must match the layout from the next prepare() on.
+    void useTopology(const CompiledTopology* shared);
+    bool isTopologyFading() const { return fadingTopology != nullptr; }
+
+    // Crossfade length for topology switches; 0 switches at the block
+    // boundary. Takes effect at the next prepare(). Not for the audio
+    // thread.
+    void setTopologyFade(double seconds);
+
     void setGlobalCoupling(float amount);  // 0-1 master coupling
 
+    // Queue a command from a non-audio thread; applied at the start of
+    // the next processBlock. Wait-free, single producer. Returns false if
+    // the queue is full.
+    bool post(const GraphCommand& command);
+
     // Inject energy into a specific node (MIDI note)
     void noteOn(int midiNote, float velocity);
     void noteOff(int midiNote);
@@ -44,9 +204,52 @@ public:
     // Process audio block
     void processBlock(float* leftOut, float* rightOut, int numSamples);
 
-    // Visualization data
-    std::array<float, NUM_NODES> getEnergies() const;
+    // Process audio block, applying each event on its exact sample.
+    // Events must be sorted by sampleOffset; offsets outside the block
+    // are clamped to it.
+    void processBlock(float* leftOut, float* rightOut, int numSamples,
+                      const NoteEvent* events, int numEvents);
+
+    // Time spent per phase in the last processBlock (see Profiler.h).
+    // All zero unless built with RGS_PROFILING.
+    const profiling::PhaseTimes& getPhaseTimes() const { return phaseTimes; }
+
+    // True when every node is asleep and processBlock does no work
+    bool isAsleep() const { return numAwakeGroups == 0; }
+    int getNumAwakeGroups() const { return numAwakeGroups; }
+
+    // Nodes the engines process: every node of an awake group
+    int getNumAwakeNodes() const { return std::min(numAwakeGroups * NodeBank::SLEEP_GROUP, numNodes); }
+
+    // Time for the current sound to decay to SLEEP_ENERGY, from the
+    // lowest tuned node and the damping. Safe from any thread.
+    double getTailSeconds() const { return tailSeconds.load(std::memory_order_relaxed); }
+
+    // Visualization data, getNumNodes() entries
+    const float* getEnergies() const;
+    // getCoupling reads the topology being rendered: safe from the audio
+    // thread and from the thread that sets topologies, which is the only
+    // one that frees them
     float getCoupling(int from, int to) const;
+    int getNumEdges() const { return getCompiledTopology().getNumEdges(); }
+    const CompiledTopology& getCompiledTopology() const { return *topology.load(std::memory_order_acquire); }
+
+    // Changes whenever the edges or the layout do, so views can cache what
+    // they draw of them. Safe from any thread.
+    uint32_t getTopologyVersion() const { return topologyVersion.load(std::memory_order_relaxed); }
+    float getGlobalCoupling() const { return globalCoupling.getCurrent(); }
+
+    // Visit every compiled edge as fn(from, to, weight)
+    template <typename Fn>
+    void forEachEdge(Fn&& fn) const {
+        const CompiledTopology& edges = getCompiledTopology();
+        const int* starts = edges.getEdgeStarts();
+        for (int src = 0; src < edges.getNumNodes(); src++) {
+            for (int e = starts[src]; e < starts[src + 1]; e++) {
+                fn(src, edges.getEdgeTargets()[e], edges.getEdgeWeights()[e]);
+            }
+        }
+    }
 
     // Parameters
     void setDamping(float d);
@@ -55,20 +258,115 @@ public:
     void reset();
 
 private:
-    void buildTopology(Topology topo);
-    float midiToFreq(int midiNote) const;
+    void setSampleRate(double sr);
+    void configure(const GraphLayout& newLayout);
+    void render(float* leftOut, float* rightOut, int numSamples);
+    void renderSamples(float* leftOut, float* rightOut, int numSamples);
+    void renderSubBlocks(float* leftOut, float* rightOut, int numSamples);
+    void renderPartitioned(float* leftOut, float* rightOut, int numSamples);
+    void mixSubBlock(float* leftOut, float* rightOut, int numSamples);
+    void keepLastInputs(int numSamples);
+
+    // Node i's coupling input through its DC blocker
+    float blockDc(int i, float x) {
+        const float y = x - dcInputs[static_cast<size_t>(i)] + dcCoeff * dcOutputs[static_cast<size_t>(i)];
+        dcInputs[static_cast<size_t>(i)] = x;
+        dcOutputs[static_cast<size_t>(i)] = y;
+        return y;
+    }
+
+    void advanceNodeParameters(int numSamples);
+    void wakeNode(int node);
+    void sleepQuietGroups();
+    void updateTail();
+    void handleEvent(const NoteEvent& event);
+    void drainCommands();
+    void publishTopology(std::unique_ptr<CompiledTopology> built, uint64_t start);
+    void adoptTopology();
+    void switchTopology(const CompiledTopology* next);
+    float getCouplingGain(const CompiledTopology& edges) const;
+    int getFadeLength(int numSamples) const;
+    float getFadeMix(int sample) const;
+    void buildPartition();
+    void createBank();
+    float midiToFreq(float pitch) const;
     int midiToNode(int midiNote) const;
 
     double sampleRate = 44100.0;
 
-    std::array<Resonator, NUM_NODES> nodes;
-    std::array<std::array<float, NUM_NODES>, NUM_NODES> coupling{};
+    GraphLayout layout;
+    int numNodes = 0;
+    std::array<int, NUM_MIDI_NOTES> noteToNode{};
+
+    Engine engine = Engine::Simd;
+    fastmath::Quality quality = fastmath::Quality::Normal;
+    const ExcitationTable* excitation = nullptr;
+    std::unique_ptr<NodeBank> bank;
+    ResonatorBank* blockBank = nullptr;   // bank, when engine is Block
+    std::vector<float> frequencies;
+    std::vector<float> lowestFrequencies;   // Sizes each delay line
+    std::vector<float> panLeft;    // Node gain included
+    std::vector<float> panRight;
+
+    // setNodeMix glides panLeft / panRight between these
+    std::vector<float> mixFromLeft;
+    std::vector<float> mixFromRight;
+    std::vector<float> mixToLeft;
+    std::vector<float> mixToRight;
+    Ramp nodeMix;
+    std::vector<float> excitations;   // Per-sample scratch, zero while asleep
+
+    // DC blocker state per node (last input, last output), zero while asleep
+    std::vector<float> dcInputs;
+    std::vector<float> dcOutputs;
+    float dcCoeff = 0.997f;
+
+    // Engine::Block: outputs and energies from before the sub-block
+    std::vector<float> previousOutputs;
+    std::vector<float> previousEnergies;
+
+    // Parallel Engine::Block: parts of the graph and per-sample coupling
+    WorkerPool* pool = nullptr;
+    GraphPartition partition;
+    std::vector<float> couplingScales;
+    std::vector<float> fadeScales;   // The faded-from topology's, while fading
+    std::vector<uint8_t> loudNodes;
+
+    // One flag per NodeBank::SLEEP_GROUP nodes
+    std::vector<uint8_t> groupAwake;
+    int numAwakeGroups = 0;
+    std::atomic<double> tailSeconds { 0.0 };
+    std::atomic<uint32_t> topologyVersion { 0 };
+
+    // Coupling being rendered, and while a switch fades the one it
+    // replaced. Both come from topologies, or from whoever called
+    // useTopology(). Atomic so views can read the edges.
+    std::atomic<const CompiledTopology*> topology { nullptr };
+    const CompiledTopology* fadingTopology = nullptr;
+    int fadePosition = 0;     // Samples faded so far
+    int fadeSamples = 0;
+    double topologyFadeSeconds = TOPOLOGY_FADE_SECONDS;
+
+    // Built by setTopology() / setCoupling() and prepare()
+    ObjectExchange<CompiledTopology> topologies;
+    bool ownTopology = true;
+
+    // Smoothed parameters, targets set by the public setters
+    Ramp globalCoupling;
+    Ramp damping;
+    Ramp brightness;
+    int smoothingSamples = 0;
+
+    Topology currentTopology = Topology::Fifths;   // setTopology() thread
+
+    SpscQueue<GraphCommand> commands { 1024 };
 
-    float globalCoupling = 0.3f;
-    float damping = 0.997f;
-    float brightness = 0.7f;
+    profiling::PhaseTimes phaseTimes;
+    profiling::PhaseTimer phaseTimer { phaseTimes };
 
-    Topology currentTopology = Topology::Fifths;
+    profiling::Tracer* tracer = nullptr;
+    int traceTrack = 0;
+    int traceVoice = 0;
 };
 
 } // namespace rgs
@@ -0,0 +1,84 @@
+#include "ScalarBank.h"
+#include <algorithm>
+
+namespace rgs {
+
+void ScalarBank::prepare(double sampleRate, int numNodes, const float* lowestFrequencies) {
+    nodes.resize(static_cast<size_t>(numNodes));
+    energies.assign(static_cast<size_t>(numNodes), 0.0f);
+    outputs.assign(static_cast<size_t>(numNodes), 0.0f);
+
+    // Power-of-two sizes of at least a cache line keep every line aligned
+    size_t total = 0;
+    for (int i = 0; i < numNodes; i++) {
+        total += static_cast<size_t>(Resonator::delaySizeFor(sampleRate, lowestFrequencies[i]));
+    }
+    delayArena.allocate(total);
+
+    size_t offset = 0;
+    for (int i = 0; i < numNodes; i++) {
+        int size = Resonator::delaySizeFor(sampleRate, lowestFrequencies[i]);
+        nodes[static_cast<size_t>(i)].prepare(sampleRate, delayArena.data() + offset, size);
+        offset += static_cast<size_t>(size);
+    }
+}
+
+void ScalarBank::setFrequency(int node, float freq) {
+    nodes[static_cast<size_t>(node)].setFrequency(freq);
+}
+
+void ScalarBank::setDamping(int node, float damping) {
+    nodes[static_cast<size_t>(node)].setDamping(damping);
+}
+
+void ScalarBank::setBrightness(int node, float brightness) {
+    nodes[static_cast<size_t>(node)].setBrightness(brightness);
+}
+
+void ScalarBank::setQuality(fastmath::Quality quality) {
+    for (auto& node : nodes) {
+        node.setQuality(quality);
+    }
+}
+
+void ScalarBank::excite(int node, const ExcitationTable& table, float velocity) {
+    auto& resonator = nodes[static_cast<size_t>(node)];
+    resonator.excite(table, velocity);
+    energies[static_cast<size_t>(node)] = resonator.getEnergy();
+}
+
+void ScalarBank::finishStrikes() {
+    for (auto& node : nodes) {
+        node.finishStrike();
+    }
+}
+
+void ScalarBank::process(const float* input, const uint8_t* awakeGroups) {
+    const auto numNodes = nodes.size();
+    for (size_t first = 0, g = 0; first < numNodes; first += SLEEP_GROUP, g++) {
+        if (!awakeGroups[g]) {
+            continue;
+        }
+        const size_t end = std::min(numNodes, first + SLEEP_GROUP);
+        for (size_t i = first; i < end; i++) {
+            outputs[i] = nodes[i].process(input[i]);
+            energies[i] = nodes[i].getEnergy();
+        }
+    }
+}
+
+void ScalarBank::silence(int node) {
+    nodes[static_cast<size_t>(node)].reset();
+    energies[static_cast<size_t>(node)] = 0.0f;
+    outputs[static_cast<size_t>(node)] = 0.0f;
+}
+
+void ScalarBank::reset() {
+    for (auto& node : nodes) {
+        node.reset();
+    }
+    std::fill(energies.begin(), energies.end(), 0.0f);
+    std::fill(outputs.begin(), outputs.end(), 0.0f);
+}
+
+} // namespace rgs
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "AlignedBuffer.h"
+#include "NodeBank.h"
+#include "Resonator.h"
+#include <vector>
+
+namespace rgs {
+
+/**
+ * Reference bank: one Resonator object per node
+ *
+ * This is the original per-node processing path. It is kept as the
+ * numerical reference that the SIMD bank is validated against.
+ */
+class ScalarBank : public NodeBank {
+public:
+    void prepare(double sampleRate, int numNodes, const float* lowestFrequencies) override;
+
+    void setFrequency(int node, float freq) override;
+    void setDamping(int node, float damping) override;
+    void setBrightness(int node, float brightness) override;
+    void setQuality(fastmath::Quality quality) override;
+
+    void excite(int node, const ExcitationTable& table, float velocity) override;
+    void finishStrikes() override;
+    void process(const float* input, const uint8_t* awakeGroups) override;
+    void silence(int node) override;
+
+    const float* getEnergies() const override { return energies.data(); }
+    const float* getOutputs() const override { return outputs.data(); }
+
+    void reset() override;
+
+private:
+    std::vector<Resonator> nodes;
+    AlignedBuffer<float> delayArena;   // Every node's line, back to back
+    std::vector<float> energies;
+    std::vector<float> outputs;
+};
+
+} // namespace rgs
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace rgs {
+
+/**
+ * Wait-free single-producer / single-consumer ring buffer
+ *
+ * One thread pushes, one other thread pops; neither ever blocks or
+ * allocates after construction. push() fails instead of overwriting when
+ * the ring is full. Used to hand commands from the message thread to the
+ * audio thread.
+ */
+template <typename T>
+class SpscQueue {
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscQueue(size_t minCapacity) {
+        size_t capacity = 2;
+        while (capacity < minCapacity) {
+            capacity <<= 1;
+        }
+        slots.resize(capacity);
+        mask = capacity - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer thread only
+    bool push(const T& item) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) > mask) {
+            return false;  // Full
+        }
+        slots[t & mask] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only
+    bool pop(T& item) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            return false;  // Empty
+        }
+        item = slots[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+private:
+    std::vector<T> slots;
+    size_t mask = 0;
+
+    // Separate cache lines so producer and consumer don't false-share
+    alignas(64) std::atomic<size_t> head { 0 };   // Next slot to pop
+    alignas(64) std::atomic<size_t> tail { 0 };   // Next slot to push
+};
+
+} // namespace rgs
@@ -0,0 +1,376 @@
+#include "SynthState.h"
+#include "VoiceManager.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace rgs {
+
+namespace {
+
+constexpr char MAGIC[4] = { 'R', 'G', 'S', 'S' };
+
+// Tags as they appear in the blob, first character lowest
+constexpr uint32_t tag(const char (&name)[5]) {
+    return static_cast<uint32_t>(static_cast<uint8_t>(name[0]))
+         | static_cast<uint32_t>(static_cast<uint8_t>(name[1])) << 8
+         | static_cast<uint32_t>(static_cast<uint8_t>(name[2])) << 16
+         | static_cast<uint32_t>(static_cast<uint8_t>(name[3])) << 24;
+}
+
+constexpr uint32_t PARAMETERS = tag("PARM");
+constexpr uint32_t EDGES = tag("EDGE");
+constexpr uint32_t NOTE_MAP = tag("NMAP");
+constexpr uint32_t NODES = tag("NODE");
+
+class Writer {
+public:
+    explicit Writer(std::vector<uint8_t>& out) : out(out) {}
+
+    void u8(uint32_t value) { out.push_back(static_cast<uint8_t>(value)); }
+    void u16(uint32_t value) { u8(value); u8(value >> 8); }
+    void u32(uint32_t value) { u16(value); u16(value >> 16); }
+
+    void f32(float value) {
+        uint32_t bits = 0;
+        std::memcpy(&bits, &value, sizeof bits);
+        u32(bits);
+    }
+
+    // Chunks get their size once written
+    size_t beginChunk(uint32_t name) {
+        u32(name);
+        u32(0);
+        return out.size();
+    }
+
+    void endChunk(size_t start) { patch(start - 4, static_cast<uint32_t>(out.size() - start)); }
+
+    void patch(size_t at, uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            out[at + static_cast<size_t>(i)] = static_cast<uint8_t>(value >> (8 * i));
+        }
+    }
+
+private:
+    std::vector<uint8_t>& out;
+};
+
+// Bounds-checked reads from a byte range; every read fails past the end
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t size) : pos(data), end(data + size) {}
+
+    size_t remaining() const { return static_cast<size_t>(end - pos); }
+
+    bool u8(uint32_t& value) {
+        if (remaining() < 1) {
+            return false;
+        }
+        value = *pos++;
+        return true;
+    }
+
+    bool u16(uint32_t& value) {
+        uint32_t low = 0;
+        uint32_t high = 0;
+        if (!u8(low) || !u8(high)) {
+            return false;
+        }
+        value = low | high << 8;
+        return true;
+    }
+
+    bool u32(uint32_t& value) {
+        uint32_t low = 0;
+        uint32_t high = 0;
+        if (remaining() < 4 || !u16(low) || !u16(high)) {
+            return false;
+        }
+        value = low | high << 16;
+        return true;
+    }
+
+    bool f32(float& value) {
+        uint32_t bits = 0;
+        if (!u32(bits)) {
+            return false;
+        }
+        std::memcpy(&value, &bits, sizeof value);
+        return std::isfinite(value);
+    }
+
+    // A float field, clamped; a field the chunk ends before keeps value
+    bool number(float low, float high, float& value) {
+        float read = 0.0f;
+        if (remaining() == 0) {
+            return true;
+        }
+        if (!f32(read)) {
+            return false;
+        }
+        value = std::clamp(read, low, high);
+        return true;
+    }
+
+    // A u8 choice, no more than last; a field the chunk ends before
+    // keeps value
+    bool choice(uint32_t last, uint32_t& value) {
+        uint32_t read = 0;
+        if (remaining() == 0) {
+            return true;
+        }
+        if (!u8(read) || read > last) {
+            return false;
+        }
+        value = read;
+        return true;
+    }
+
+    // The next size bytes as a reader of their own
+    bool sub(size_t size, Reader& chunk) {
+        if (remaining() < size) {
+            return false;
+        }
+        chunk = Reader(pos, size);
+        pos += size;
+        return true;
+    }
+
+private:
+    const uint8_t* pos;
+    const uint8_t* end;
+};
+
+bool readParameters(Reader& in, SynthState& state) {
+    // Each field the chunk ends before keeps the state's default
+    auto topology = static_cast<uint32_t>(state.topology);
+    auto exciter = static_cast<uint32_t>(state.exciter.type);
+    auto quality = static_cast<uint32_t>(state.quality);
+    auto voices = static_cast<uint32_t>(state.voices);
+    if (!in.number(0.9f, 0.9999f, state.damping)
+        || !in.number(0.0f, 1.0f, state.brightness)
+        || !in.number(0.0f, 1.0f, state.coupling)
+        || !in.choice(static_cast<uint32_t>(Topology::Harmonic), topology)
+        || !in.choice(static_cast<uint32_t>(Exciter::Type::Strike), exciter)
+        || !in.choice(static_cast<uint32_t>(fastmath::Quality::Reference), quality)
+        || !in.choice(UINT8_MAX, voices)) {
+        return false;
+    }
+    state.topology = static_cast<Topology>(topology);
+    state.exciter.type = static_cast<Exciter::Type>(exciter);
+    state.quality = static_cast<fastmath::Quality>(quality);
+    state.voices = std::clamp(static_cast<int>(voices), 1, VoiceManager::MAX_VOICES);
+
+    if (!in.number(0.0f, 1.0f, state.exciter.hardness) || !in.number(0.1f, 0.9f, state.exciter.position)) {
+        return false;
+    }
+
+    // The layout's values only make sense together: all or none
+    if (in.remaining() == 0) {
+        return true;
+    }
+    uint32_t numNodes = 0;
+    uint32_t lowestNote = 0;
+    uint32_t fold = 0;
+    uint32_t steps = 0;
+    if (!in.u16(numNodes) || !in.u8(lowestNote) || !in.u8(fold) || !in.u8(steps)
+        || numNodes < 1 || numNodes > ResonatorGraph::MAX_NODES || lowestNote >= ResonatorGraph::NUM_MIDI_NOTES
+        || fold > 1 || steps < 1) {
+        return false;
+    }
+    state.layout = { static_cast<int>(numNodes), static_cast<int>(lowestNote), fold != 0, static_cast<int>(steps) };
+    return true;
+}
+
+bool readEdges(Reader& in, SynthPatch& patch) {
+    uint32_t count = 0;
+    if (!in.u32(count) || count > SynthPatch::MAX_EDGES) {
+        return false;
+    }
+    patch.edges.clear();
+    for (uint32_t e = 0; e < count; e++) {
+        uint32_t from = 0;
+        uint32_t to = 0;
+        float weight = 0.0f;
+        if (!in.u16(from) || !in.u16(to) || !in.f32(weight)) {
+            return false;
+        }
+        patch.edges.push_back({ static_cast<int>(from), static_cast<int>(to), std::clamp(weight, 0.0f, 1.0f) });
+    }
+    return true;
+}
+
+bool readNoteMap(Reader& in, SynthPatch& patch) {
+    for (auto& node : patch.noteMap) {
+        uint32_t bits = 0;
+        if (!in.u16(bits)) {
+            return false;
+        }
+        const auto value = static_cast<int16_t>(bits);
+        node = value >= 0 && value < ResonatorGraph::MAX_NODES ? value : -1;
+    }
+    patch.customNoteMap = true;
+    return true;
+}
+
+bool readNodes(Reader& in, SynthPatch& patch) {
+    uint32_t count = 0;
+    if (!in.u16(count) || count > ResonatorGraph::MAX_NODES) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        auto& node = patch.nodes[i];
+        if (!in.f32(node.gain) || !in.f32(node.pan)) {
+            return false;
+        }
+        node.gain = std::clamp(node.gain, 0.0f, 4.0f);
+        node.pan = std::min(node.pan, 1.0f);
+    }
+    patch.numNodes = static_cast<int>(count);
+    return true;
+}
+
+} // namespace
+
+SynthPatch::SynthPatch() {
+    edges.reserve(MAX_EDGES);
+    noteMap.fill(-1);
+}
+
+void SynthPatch::reset() {
+    edges.clear();
+    customNoteMap = false;
+    noteMap.fill(-1);
+    numNodes = 0;
+    nodes.fill(NodeSettings {});
+}
+
+bool SynthPatch::operator==(const SynthPatch& other) const {
+    return edges == other.edges && customNoteMap == other.customNoteMap
+        && (!customNoteMap || noteMap == other.noteMap)
+        && numNodes == other.numNodes
+        && std::equal(nodes.begin(), nodes.begin() + numNodes, other.nodes.begin());
+}
+
+void SynthState::reset() {
+    damping = 0.997f;
+    brightness = 0.7f;
+    coupling = 0.3f;
+    topology = Topology::Fifths;
+    exciter = {};
+    voices = 8;
+    quality = fastmath::Quality::Normal;
+    layout = GraphLayout::octave();
+    patch.reset();
+}
+
+void SynthState::write(std::vector<uint8_t>& out) const {
+    out.clear();
+    out.reserve(HEADER_SIZE + 64 + patch.edges.size() * 8 + sizeof patch.noteMap
+                + static_cast<size_t>(patch.numNodes) * 8);
+    Writer put(out);
+
+    for (char c : MAGIC) {
+        put.u8(static_cast<uint8_t>(c));
+    }
+    put.u16(VERSION);
+    put.u16(0);
+    put.u32(0);   // Payload size, patched below
+
+    size_t chunk = put.beginChunk(PARAMETERS);
+    put.f32(damping);
+    put.f32(brightness);
+    put.f32(coupling);
+    put.u8(static_cast<uint32_t>(topology));
+    put.u8(static_cast<uint32_t>(exciter.type));
+    put.u8(static_cast<uint32_t>(quality));
+    put.u8(static_cast<uint32_t>(voices));
+    put.f32(exciter.hardness);
+    put.f32(exciter.position);
+    put.u16(static_cast<uint32_t>(layout.numNodes));
+    put.u8(static_cast<uint32_t>(layout.lowestNote));
+    put.u8(layout.foldOctaves ? 1 : 0);
+    put.u8(static_cast<uint32_t>(layout.stepsPerOctave));
+    put.endChunk(chunk);
+
+    if (!patch.edges.empty()) {
+        const size_t count = std::min(patch.edges.size(), static_cast<size_t>(SynthPatch::MAX_EDGES));
+        chunk = put.beginChunk(EDGES);
+        put.u32(static_cast<uint32_t>(count));
+        for (size_t e = 0; e < count; e++) {
+            put.u16(static_cast<uint32_t>(patch.edges[e].from));
+            put.u16(static_cast<uint32_t>(patch.edges[e].to));
+            put.f32(patch.edges[e].weight);
+        }
+        put.endChunk(chunk);
+    }
+
+    if (patch.customNoteMap) {
+        chunk = put.beginChunk(NOTE_MAP);
+        for (int16_t node : patch.noteMap) {
+            put.u16(static_cast<uint16_t>(node));
+        }
+        put.endChunk(chunk);
+    }
+
+    if (patch.numNodes > 0) {
+        chunk = put.beginChunk(NODES);
+        put.u16(static_cast<uint32_t>(patch.numNodes));
+        for (int i = 0; i < patch.numNodes; i++) {
+            put.f32(patch.nodes[static_cast<size_t>(i)].gain);
+            put.f32(patch.nodes[static_cast<size_t>(i)].pan);
+        }
+        put.endChunk(chunk);
+    }
+
+    put.patch(8, static_cast<uint32_t>(out.size() - HEADER_SIZE));
+}
+
+bool SynthState::isState(const void* data, size_t size) {
+    return data != nullptr && size >= HEADER_SIZE && std::memcmp(data, MAGIC, 4) == 0;
+}
+
+bool SynthState::read(const void* data, size_t size) {
+    if (!isState(data, size)) {
+        return false;
+    }
+
+    Reader in(static_cast<const uint8_t*>(data) + 4, size - 4);
+    uint32_t version = 0;
+    uint32_t flags = 0;
+    uint32_t payload = 0;
+    Reader body(nullptr, 0);
+    if (!in.u16(version) || !in.u16(flags) || !in.u32(payload)
+        || version < 1 || version > VERSION || !in.sub(payload, body)) {
+        return false;
+    }
+
+    reset();
+    patch.edges.reserve(SynthPatch::MAX_EDGES);   // A no-op unless this state was copied
+    while (body.remaining() > 0) {
+        uint32_t name = 0;
+        uint32_t chunkSize = 0;
+        Reader chunk(nullptr, 0);
+        if (!body.u32(name) || !body.u32(chunkSize) || !body.sub(chunkSize, chunk)) {
+            return false;
+        }
+
+        bool ok = true;
+        if (name == PARAMETERS) {
+            ok = readParameters(chunk, *this);
+        } else if (name == EDGES) {
+            ok = readEdges(chunk, patch);
+        } else if (name == NOTE_MAP) {
+            ok = readNoteMap(chunk, patch);
+        } else if (name == NODES) {
+            ok = readNodes(chunk, patch);
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace rgs
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "CompiledTopology.h"
+#include "ExcitationTable.h"
+#include "FastMath.h"
+#include "ResonatorGraph.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rgs {
+
+/**
+ * What a synth state holds beyond the plugin's parameters
+ *
+ * Coupling edits over the topology's own edges, a note map and the mix
+ * of each node. Node numbers refer to the state's layout; anything past
+ * the nodes a layout has is ignored.
+ */
+struct SynthPatch {
+    static constexpr int MAX_EDGES = 4096;
+
+    std::vector<CouplingEdge> edges;   // Applied in order, at most MAX_EDGES
+    bool customNoteMap = false;        // Otherwise the layout's own map
+    std::array<int16_t, ResonatorGraph::NUM_MIDI_NOTES> noteMap {};   // Node per note, -1 ignores
+    int numNodes = 0;                  // Entries of nodes in use; the rest default
+    std::array<NodeSettings, ResonatorGraph::MAX_NODES> nodes {};
+
+    SynthPatch();
+
+    // Back to no edits, the layout's map and default nodes. Keeps the
+    // storage.
+    void reset();
+
+    bool operator==(const SynthPatch& other) const;
+    bool operator!=(const SynthPatch& other) const { return !(*this == other); }
+};
+
+/**
+ * Everything that makes a sound: the plugin's parameters plus a patch
+ *
+ * write() and read() use a compact little-endian binary blob:
+ *
+ *     "RGSS"  u16 version  u16 flags (0)  u32 payload bytes
+ *     then chunks: 4-character tag, u32 size, data
+ *
+ *     PARM  damping, brightness, coupling (f32), topology, exciter,
+ *           quality, voices (u8), hardness, position (f32), layout
+ *           nodes (u16), lowest note, fold, steps per octave (u8)
+ *     EDGE  u32 count, then count x (u16 from, u16 to, f32 weight)
+ *     NMAP  128 x i16 node per MIDI note (only with a custom note map)
+ *     NODE  u16 count, then count x (f32 gain, f32 pan)
+ *
+ * The topology is one of the plugin's four choices; a custom graph is
+ * one of them plus EDGE edits (an edge of weight 0 removes one).
+ *
+ * Readers skip chunks they do not know and stop at the end of a chunk
+ * they do, so later versions can add chunks and append fields. A chunk
+ * may end after any field, and the fields it leaves out keep their
+ * defaults; PARM's four layout values count as one field. VERSION
+ * changes only when a field's meaning does, and newer versions are
+ * rejected.
+ *
+ * read() fills the state in place without allocating (edges keep their
+ * MAX_EDGES capacity), so a state kept around for it parses any number
+ * of blobs without heap churn.
+ */
+struct SynthState {
+    static constexpr uint16_t VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 12;
+
+    float damping = 0.997f;
+    float brightness = 0.7f;
+    float coupling = 0.3f;
+    Topology topology = Topology::Fifths;
+    ExciterSettings exciter;
+    int voices = 8;
+    fastmath::Quality quality = fastmath::Quality::Normal;
+    GraphLayout layout = GraphLayout::octave();
+
+    SynthPatch patch;
+
+    // Defaults everywhere, keeping the storage
+    void reset();
+
+    // Replace out with the blob
+    void write(std::vector<uint8_t>& out) const;
+
+    // Replace this state with a blob from write(). False if the blob is
+    // not a state, is newer than VERSION or is malformed, leaving this
+    // state half-read. Values out of range are clamped.
+    bool read(const void* data, size_t size);
+
+    // Whether data starts like a blob from write()
+    static bool isState(const void* data, size_t size);
+};
+
+} // namespace rgs
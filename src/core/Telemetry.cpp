@@ -0,0 +1,148 @@
+#include "Telemetry.h"
+#include "ResonatorGraph.h"
+#include <algorithm>
+#include <cmath>
+
+namespace rgs {
+
+namespace {
+
+// Peak-hold: hold for 0.5 s, then fall by 20 dB per second
+constexpr double PEAK_HOLD_SECONDS = 0.5;
+constexpr double PEAK_FALL_PER_SECOND = 0.1;
+
+// Flows below this are not worth drawing
+constexpr float MIN_FLOW = 1e-4f;
+
+float blockRms(const float* samples, int numSamples) {
+    if (numSamples <= 0) {
+        return 0.0f;
+    }
+    float sum = 0.0f;
+    for (int i = 0; i < numSamples; i++) {
+        sum += samples[i] * samples[i];
+    }
+    return std::sqrt(sum / static_cast<float>(numSamples));
+}
+
+} // namespace
+
+TelemetryChannel::TelemetryChannel() {
+    for (auto& slot : slots) {
+        slot.energy = std::make_unique<std::atomic<float>[]>(MAX_NODES);
+        slot.peak = std::make_unique<std::atomic<float>[]>(MAX_NODES);
+        slot.flowEdge = std::make_unique<std::atomic<uint32_t>[]>(MAX_FLOWS);
+        slot.flowAmount = std::make_unique<std::atomic<float>[]>(MAX_FLOWS);
+    }
+    peakHold.assign(MAX_NODES, 0.0f);
+    holdRemaining.assign(MAX_NODES, 0);
+}
+
+void TelemetryChannel::prepare(double sr) {
+    sampleRate = sr;
+    std::fill(peakHold.begin(), peakHold.end(), 0.0f);
+    std::fill(holdRemaining.begin(), holdRemaining.end(), 0);
+}
+
+void TelemetryChannel::publish(const ResonatorGraph& graph, const float* left, const float* right,
+                               int numSamples) {
+    publish(graph, graph.getEnergies(), left, right, numSamples);
+}
+
+void TelemetryChannel::publish(const ResonatorGraph& graph, const float* energies,
+                               const float* left, const float* right, int numSamples) {
+    // Write into the slot after the newest one; readers are on `latest`
+    const int index = (latest.load(std::memory_order_relaxed) + 1) % NUM_SLOTS;
+    Slot& slot = slots[index];
+
+    const uint32_t seq = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const int numNodes = std::min(graph.getNumNodes(), MAX_NODES);
+    const int holdSamples = static_cast<int>(PEAK_HOLD_SECONDS * sampleRate);
+    const auto fall = static_cast<float>(std::pow(PEAK_FALL_PER_SECOND, numSamples / sampleRate));
+
+    for (int i = 0; i < numNodes; i++) {
+        float energy = energies[i];
+        if (energy >= peakHold[i]) {
+            peakHold[i] = energy;
+            holdRemaining[i] = holdSamples;
+        } else if (holdRemaining[i] > 0) {
+            holdRemaining[i] -= numSamples;
+        } else {
+            peakHold[i] = std::max(energy, peakHold[i] * fall);
+        }
+
+        slot.energy[i].store(energy, std::memory_order_relaxed);
+        slot.peak[i].store(peakHold[i], std::memory_order_relaxed);
+    }
+
+    int numFlows = 0;
+    const float coupling = graph.getGlobalCoupling();
+    graph.forEachEdge([&](int from, int to, float weight) {
+        float amount = energies[from] * weight * coupling;
+        if (amount > MIN_FLOW && numFlows < MAX_FLOWS) {
+            slot.flowEdge[numFlows].store(static_cast<uint32_t>(from) << 16 | static_cast<uint32_t>(to),
+                                          std::memory_order_relaxed);
+            slot.flowAmount[numFlows].store(amount, std::memory_order_relaxed);
+            numFlows++;
+        }
+    });
+
+    slot.frameNumber.store(++frameCounter, std::memory_order_relaxed);
+    slot.numNodes.store(numNodes, std::memory_order_relaxed);
+    slot.numFlows.store(numFlows, std::memory_order_relaxed);
+    slot.rmsLeft.store(blockRms(left, numSamples), std::memory_order_relaxed);
+    slot.rmsRight.store(blockRms(right, numSamples), std::memory_order_relaxed);
+
+    slot.sequence.store(seq + 2, std::memory_order_release);
+    latest.store(index, std::memory_order_release);
+}
+
+bool TelemetryChannel::read(TelemetryFrame& frame) const {
+    frame.energy.reserve(MAX_NODES);
+    frame.peak.reserve(MAX_NODES);
+    frame.flows.reserve(MAX_FLOWS);
+
+    for (;;) {
+        const int index = latest.load(std::memory_order_acquire);
+        if (index < 0) {
+            return false;
+        }
+
+        const Slot& slot = slots[index];
+        const uint32_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before & 1u) {
+            continue;  // Being rewritten, `latest` has moved on
+        }
+
+        frame.frameNumber = slot.frameNumber.load(std::memory_order_relaxed);
+        frame.numNodes = slot.numNodes.load(std::memory_order_relaxed);
+        frame.outputRmsLeft = slot.rmsLeft.load(std::memory_order_relaxed);
+        frame.outputRmsRight = slot.rmsRight.load(std::memory_order_relaxed);
+
+        const auto numNodes = static_cast<size_t>(frame.numNodes);
+        frame.energy.resize(numNodes);
+        frame.peak.resize(numNodes);
+        for (size_t i = 0; i < numNodes; i++) {
+            frame.energy[i] = slot.energy[i].load(std::memory_order_relaxed);
+            frame.peak[i] = slot.peak[i].load(std::memory_order_relaxed);
+        }
+
+        const auto numFlows = static_cast<size_t>(slot.numFlows.load(std::memory_order_relaxed));
+        frame.flows.resize(numFlows);
+        for (size_t i = 0; i < numFlows; i++) {
+            uint32_t edge = slot.flowEdge[i].load(std::memory_order_relaxed);
+            frame.flows[i] = { static_cast<int>(edge >> 16), static_cast<int>(edge & 0xffffu),
+                               slot.flowAmount[i].load(std::memory_order_relaxed) };
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+}
+
+} // namespace rgs
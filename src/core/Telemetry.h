@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace rgs {
+
+class ResonatorGraph;
+
+/**
+ * One block's worth of engine state, as seen by observers
+ */
+struct TelemetryFrame {
+    uint64_t frameNumber = 0;       // Increments once per published block
+    int numNodes = 0;
+    float outputRmsLeft = 0.0f;
+    float outputRmsRight = 0.0f;
+
+    std::vector<float> energy;      // numNodes entries
+    std::vector<float> peak;        // Peak-hold of energy, numNodes entries
+
+    // Edges currently carrying energy, estimated as
+    // source energy x weight x global coupling
+    struct Flow {
+        int from;
+        int to;
+        float amount;
+    };
+    std::vector<Flow> flows;
+};
+
+/**
+ * Wait-free channel publishing a TelemetryFrame from the audio thread
+ *
+ * The audio thread calls publish() once per block; any number of other
+ * threads call read() whenever they like. Frames live in a small ring of
+ * seqlock-protected slots: the writer never waits, and a reader retries
+ * only if the slot it is copying gets reused mid-copy, so it always sees
+ * a complete frame.
+ */
+class TelemetryChannel {
+public:
+    static constexpr int MAX_NODES = 512;
+    static constexpr int MAX_FLOWS = 2048;
+
+    TelemetryChannel();
+
+    // Sets the peak-hold timing. Not for the audio thread.
+    void prepare(double sampleRate);
+
+    // Audio thread: capture the graph after rendering this block
+    void publish(const ResonatorGraph& graph, const float* left, const float* right, int numSamples);
+
+    // As above with energies from elsewhere (e.g. merged across voices);
+    // graph supplies the node count and edges
+    void publish(const ResonatorGraph& graph, const float* energies,
+                 const float* left, const float* right, int numSamples);
+
+    // Any thread: copy the newest complete frame. Returns false until the
+    // first frame is published. Reuses frame's storage once it is sized.
+    bool read(TelemetryFrame& frame) const;
+
+private:
+    static constexpr int NUM_SLOTS = 3;
+
+    // Relaxed atomics compile to plain loads/stores; they only make the
+    // concurrent copy well-defined
+    struct Slot {
+        std::atomic<uint32_t> sequence { 0 };   // Odd while being written
+        std::atomic<uint64_t> frameNumber { 0 };
+        std::atomic<int> numNodes { 0 };
+        std::atomic<int> numFlows { 0 };
+        std::atomic<float> rmsLeft { 0.0f };
+        std::atomic<float> rmsRight { 0.0f };
+        std::unique_ptr<std::atomic<float>[]> energy;
+        std::unique_ptr<std::atomic<float>[]> peak;
+        std::unique_ptr<std::atomic<uint32_t>[]> flowEdge;   // from << 16 | to
+        std::unique_ptr<std::atomic<float>[]> flowAmount;
+    };
+
+    Slot slots[NUM_SLOTS];
+    std::atomic<int> latest { -1 };
+
+    // Writer-side peak hold
+    std::vector<float> peakHold;
+    std::vector<int> holdRemaining;
+    double sampleRate = 44100.0;
+    uint64_t frameCounter = 0;
+};
+
+} // namespace rgs
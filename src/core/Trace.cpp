@@ -0,0 +1,265 @@
+#include "Trace.h"
+
+namespace rgs::profiling {
+
+namespace {
+
+const char* getTypeName(TraceRecord::Type type) {
+    switch (type) {
+        case TraceRecord::Type::Callback: return "processBlock";
+        case TraceRecord::Type::Block:    return "voices";
+        case TraceRecord::Type::Voice:    return "voice";
+        case TraceRecord::Type::NoteOn:   return "noteOn";
+        case TraceRecord::Type::NoteOff:  return "noteOff";
+        case TraceRecord::Type::Strike:   return "strike";
+        case TraceRecord::Type::Topology: return "topology";
+    }
+    return "?";
+}
+
+// text as the inside of a JSON string: quotes, backslashes and control
+// characters escaped (track names are file paths, Windows ones included)
+std::string escapeJson(const std::string& text) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (const char c : text) {
+        switch (c) {
+            case '"':  escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char code[8];
+                    std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned>(static_cast<unsigned char>(c)));
+                    escaped += code;
+                } else {
+                    escaped += c;
+                }
+                break;
+        }
+    }
+    return escaped;
+}
+
+} // namespace
+
+Tracer::Tracer(size_t minCapacity) {
+    size_t capacity = 2;
+    while (capacity < minCapacity) {
+        capacity <<= 1;
+    }
+    slots = std::make_unique<Slot[]>(capacity);
+    mask = capacity - 1;
+    for (size_t i = 0; i < capacity; i++) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+Tracer::~Tracer() {
+    stop();
+}
+
+void Tracer::record(const TraceRecord& record) {
+    // Claim the next position whose slot the reader has handed back
+    uint64_t pos = writePos.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = slots[pos & mask];
+        const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        const auto lag = static_cast<int64_t>(sequence - pos);
+        if (lag == 0) {
+            if (writePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.record = record;
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return;
+            }
+        } else if (lag < 0) {
+            dropped.fetch_add(1, std::memory_order_relaxed);   // Full
+            return;
+        } else {
+            pos = writePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool Tracer::pop(TraceRecord& record) {
+    Slot& slot = slots[readPos & mask];
+    if (slot.sequence.load(std::memory_order_acquire) != readPos + 1) {
+        return false;   // Empty, or the next record is still being written
+    }
+    record = slot.record;
+    slot.sequence.store(readPos + mask + 1, std::memory_order_release);
+    readPos++;
+    return true;
+}
+
+void Tracer::setTrack(int track, const std::string& name, double sampleRate) {
+    if (track < 0 || track > UINT16_MAX) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(trackMutex);
+    if (tracks.size() <= static_cast<size_t>(track)) {
+        tracks.resize(static_cast<size_t>(track) + 1);
+    }
+    tracks[static_cast<size_t>(track)] = { name, sampleRate };
+}
+
+bool Tracer::start(const std::string& path, std::string& error) {
+    std::lock_guard<std::mutex> lock(control);
+    if (file != nullptr) {
+        error = "a trace is already running";
+        return false;
+    }
+    file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        error = "cannot write " + path;
+        return false;
+    }
+
+    // Leftovers from producers that raced the last stop()
+    TraceRecord stale;
+    while (pop(stale)) {
+    }
+
+    microsPerTick = 1e6 / getTicksPerSecond();
+    origin = now();
+    firstEvent = true;
+    named.clear();
+    dropped.store(0, std::memory_order_relaxed);
+    std::fputs("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n", file);
+
+    stopRequested = false;
+    recording.store(true, std::memory_order_relaxed);
+    flushThread = std::thread([this] { flushLoop(); });
+    return true;
+}
+
+void Tracer::stop() {
+    std::lock_guard<std::mutex> lock(control);
+    if (file == nullptr) {
+        return;
+    }
+
+    recording.store(false, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> wakeLock(wakeMutex);
+        stopRequested = true;
+    }
+    flushWake.notify_one();
+    flushThread.join();
+    flush();
+
+    std::fprintf(file, "%s{\"name\": \"dropped records\", \"ph\": \"M\", \"pid\": 0, \"args\": { \"count\": %llu }}\n]}\n",
+                 firstEvent ? "" : ",\n", static_cast<unsigned long long>(getDropped()));
+    std::fclose(file);
+    file = nullptr;
+}
+
+void Tracer::flushLoop() {
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    while (!stopRequested) {
+        lock.unlock();
+        flush();
+        lock.lock();
+        flushWake.wait_for(lock, FLUSH_INTERVAL, [this] { return stopRequested; });
+    }
+}
+
+void Tracer::flush() {
+    TraceRecord record;
+    while (pop(record)) {
+        // Timed before start(): a producer that saw the last trace running
+        if (record.start >= origin) {
+            write(record);
+        }
+    }
+    std::fflush(file);
+}
+
+void Tracer::writeNames(const TraceRecord& record) {
+    const auto track = static_cast<size_t>(record.track);
+    const auto thread = static_cast<size_t>(record.thread);
+    if (named.size() <= track) {
+        named.resize(track + 1);
+    }
+    auto& threads = named[track];
+    if (threads.empty()) {
+        std::string name = "engine " + std::to_string(track);
+        {
+            std::lock_guard<std::mutex> lock(trackMutex);
+            if (track < tracks.size() && !tracks[track].name.empty()) {
+                name = tracks[track].name;
+            }
+        }
+        std::fprintf(file, "%s{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %zu, \"args\": { \"name\": \"%s\" }}",
+                     firstEvent ? "" : ",\n", track, escapeJson(name).c_str());
+        firstEvent = false;
+    }
+    if (threads.size() <= thread) {
+        threads.resize(thread + 1, false);
+    }
+    if (!threads[thread]) {
+        const std::string name = thread == 0 ? "block" : "voice " + std::to_string(thread - 1);
+        std::fprintf(file, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %zu, \"tid\": %zu, \"args\": { \"name\": \"%s\" }}",
+                     track, thread, escapeJson(name).c_str());
+        threads[thread] = true;
+    }
+}
+
+void Tracer::write(const TraceRecord& record) {
+    writeNames(record);
+
+    const double ts = static_cast<double>(record.start - origin) * microsPerTick;
+    const double dur = static_cast<double>(record.end - record.start) * microsPerTick;
+    std::fprintf(file, ",\n{\"name\": \"%s\", \"cat\": \"audio\", \"pid\": %d, \"tid\": %d, \"ts\": %.3f, ",
+                 getTypeName(record.type), record.track, record.thread, ts);
+
+    switch (record.type) {
+        case TraceRecord::Type::Callback:
+        case TraceRecord::Type::Block: {
+            double sampleRate = 0.0;
+            {
+                std::lock_guard<std::mutex> lock(trackMutex);
+                if (record.track < tracks.size()) {
+                    sampleRate = tracks[record.track].sampleRate;
+                }
+            }
+            // Load against the block's own duration; a block that took
+            // longer than its audio is drawn red
+            const double load = sampleRate > 0.0 && record.a > 0 ? dur * 1e-4 * sampleRate / record.a : 0.0;
+            std::fprintf(file, "\"ph\": \"X\", \"dur\": %.3f, %s\"args\": { \"samples\": %d, \"events\": %d, "
+                               "\"voices\": %d, \"awakeNodes\": %d, \"loadPercent\": %.1f",
+                         dur, load > 100.0 ? "\"cname\": \"terrible\", " : "",
+                         record.a, record.b, record.c, record.d, load);
+            if constexpr (ENABLED) {
+                for (int p = 0; p < NUM_PHASES - 1; p++) {
+                    std::fprintf(file, ", \"%sUs\": %.3f", getPhaseName(static_cast<Phase>(p)),
+                                 record.phases[static_cast<size_t>(p)] * microsPerTick);
+                }
+            }
+            std::fputs(" }}", file);
+            break;
+        }
+        case TraceRecord::Type::Voice:
+            std::fprintf(file, "\"ph\": \"X\", \"dur\": %.3f, \"args\": { \"awakeNodes\": %d, \"events\": %d }}",
+                         dur, record.a, record.b);
+            break;
+        case TraceRecord::Type::NoteOn:
+        case TraceRecord::Type::NoteOff:
+            std::fprintf(file, "\"ph\": \"i\", \"s\": \"t\", \"args\": { \"note\": %d, \"offset\": %d, "
+                               "\"voice\": %d, \"velocity\": %.3f }}",
+                         record.a, record.b, record.c, record.velocity);
+            break;
+        case TraceRecord::Type::Strike:
+            std::fprintf(file, "\"ph\": \"i\", \"s\": \"t\", \"args\": { \"node\": %d, \"note\": %d, \"velocity\": %.3f }}",
+                         record.a, record.b, record.velocity);
+            break;
+        case TraceRecord::Type::Topology:
+            std::fprintf(file, "\"ph\": \"X\", \"dur\": %.3f, \"args\": { \"topology\": %d, \"edges\": %d }}",
+                         dur, record.a, record.b);
+            break;
+    }
+}
+
+} // namespace rgs::profiling
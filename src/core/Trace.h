@@ -0,0 +1,149 @@
+#pragma once
+
+#include "Profiler.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rgs::profiling {
+
+/**
+ * One traced event: a fixed-size record, copied into the ring as is
+ *
+ * Fields a-d mean different things by type:
+ *   Callback, Block   a samples, b events, c active voices, d awake nodes
+ *   Voice             a awake nodes, b events
+ *   NoteOn, NoteOff   a note, b sample offset, c voice (-1: dropped)
+ *   Strike            a node, b note
+ *   Topology          a topology (-1: one edge edited), b edges
+ */
+struct TraceRecord {
+    enum class Type : uint8_t {
+        Callback,   // The host's whole block (plugin, bench)
+        Block,      // VoiceManager::processBlock
+        Voice,      // One voice's graph rendering its block
+        NoteOn,
+        NoteOff,
+        Strike,     // A node excited
+        Topology    // Coupling rebuilt
+    };
+
+    Type type = Type::Block;
+    uint16_t track = 0;     // Engine instance: a process in the viewer
+    int16_t thread = 0;     // 0: the block; 1 + voice for a voice's work
+    int32_t a = 0;
+    int32_t b = 0;
+    int32_t c = 0;
+    int32_t d = 0;
+    float velocity = 0.0f;  // NoteOn, Strike
+    uint64_t start = 0;     // now() ticks
+    uint64_t end = 0;       // Equal to start for instant events
+
+    // Callback, Block: ticks per Phase (zero without RGS_PROFILING)
+    std::array<uint32_t, NUM_PHASES> phases {};
+
+    void setPhases(const PhaseTimes& times) {
+        for (size_t i = 0; i < phases.size(); i++) {
+            phases[i] = static_cast<uint32_t>(std::min<uint64_t>(times.ticks[i], UINT32_MAX));
+        }
+    }
+};
+
+/**
+ * Timeline trace of the audio engine, written as Chrome trace JSON
+ *
+ * Any thread, audio and workers included, calls record(), which copies
+ * the record into a preallocated ring: a bounded multi-producer queue
+ * with one sequence number per slot. It never blocks or allocates; when
+ * the ring is full the record is dropped and counted. A background
+ * thread drains the ring every FLUSH_INTERVAL and writes the records to
+ * the file, which chrome://tracing and ui.perfetto.dev open directly.
+ *
+ * Tracing is off until start(). Producers check isRecording() first, so
+ * a tracer that is not recording costs one relaxed load per event.
+ * Each track (an engine instance) is a process in the viewer, with the
+ * block on one thread and each voice on its own.
+ */
+class Tracer {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 16;            // Records
+    static constexpr auto FLUSH_INTERVAL = std::chrono::milliseconds(50);
+
+    // Capacity is rounded up to a power of two
+    explicit Tracer(size_t minCapacity = DEFAULT_CAPACITY);
+    ~Tracer();
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    // Open path and start recording. False with a reason in error if the
+    // file cannot be written or a trace is already running. Not for the
+    // audio thread.
+    bool start(const std::string& path, std::string& error);
+
+    // Stop recording, write what is left and close the file. Not for the
+    // audio thread.
+    void stop();
+
+    bool isRecording() const { return recording.load(std::memory_order_relaxed); }
+
+    // Any thread. Drops the record if the ring is full.
+    void record(const TraceRecord& record);
+
+    // Name a track and give its sample rate, which turns block times into
+    // DSP load. Not for the audio thread.
+    void setTrack(int track, const std::string& name, double sampleRate);
+
+    // Records lost to a full ring since start()
+    uint64_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence { 0 };   // position + 1 once written
+        TraceRecord record;
+    };
+
+    struct Track {
+        std::string name;
+        double sampleRate = 0.0;
+    };
+
+    bool pop(TraceRecord& record);
+    void flushLoop();
+    void flush();
+    void write(const TraceRecord& record);
+    void writeNames(const TraceRecord& record);
+
+    std::unique_ptr<Slot[]> slots;
+    uint64_t mask = 0;
+    alignas(64) std::atomic<uint64_t> writePos { 0 };
+    alignas(64) uint64_t readPos = 0;   // Flush side
+    std::atomic<uint64_t> dropped { 0 };
+    std::atomic<bool> recording { false };
+
+    // start() / stop() and the flush thread
+    std::mutex control;
+    std::thread flushThread;
+    std::mutex wakeMutex;
+    std::condition_variable flushWake;
+    bool stopRequested = false;
+
+    // Flush side
+    std::mutex trackMutex;
+    std::vector<Track> tracks;
+    std::vector<std::vector<bool>> named;   // Per track, per thread
+    FILE* file = nullptr;
+    bool firstEvent = true;
+    uint64_t origin = 0;
+    double microsPerTick = 0.0;
+};
+
+} // namespace rgs::profiling
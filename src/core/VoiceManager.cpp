@@ -0,0 +1,659 @@
+#include "VoiceManager.h"
+#include "Trace.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <cmath>
+
+namespace rgs {
+
+VoiceManager::VoiceManager() {
+    // One voice so there is always a graph to describe the layout
+    prepare(44100.0, GraphLayout::octave(), 512, 1);
+}
+
+void VoiceManager::prepare(double sampleRate, const GraphLayout& layout, int blockSize, int numVoices) {
+    numVoices = std::clamp(numVoices, 1, MAX_VOICES);
+    maxBlockSize = std::max(1, blockSize);
+    stealFadeSamples = std::max(1, static_cast<int>(std::lround(STEAL_FADE_SECONDS * sampleRate)));
+
+    // Nothing renders during prepare(), so adopt a pending table and
+    // patch now
+    excitation.update();
+
+    voices.resize(static_cast<size_t>(numVoices));
+    for (auto& voice : voices) {
+        if (voice.graph == nullptr) {
+            voice.graph = std::make_unique<ResonatorGraph>();
+        }
+
+        auto& graph = *voice.graph;
+        graph.setEngine(engine);
+        graph.setQuality(quality);
+        graph.setTopologyFade(topologyFade);
+        graph.setGlobalCoupling(globalCoupling);
+        graph.setDamping(damping);
+        graph.setBrightness(brightness);
+        graph.setExcitation(excitation.get());
+        graph.setTracer(tracer, traceTrack, static_cast<int>(&voice - voices.data()));
+        graph.prepare(sampleRate, layout);
+        if (hasPatch) {
+            applyPatch(graph, patch);
+            if (patch.customNoteMap) {
+                graph.prepare(sampleRate);   // Size the delay lines for the map
+            }
+        }
+
+        const auto numNodes = static_cast<size_t>(graph.getNumNodes());
+        voice.active = false;
+        voice.lastStrike = 0;
+        voice.nodeNote.assign(numNodes, -1);
+        voice.nodeStrike.assign(numNodes, 0);
+        voice.events.clear();
+        voice.events.reserve(MAX_EVENTS_PER_VOICE);
+        voice.fade.reset(0.0f);
+        voice.left.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+        voice.right.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+    }
+
+    // One topology for the layout the voices settled on, adopted at once:
+    // the fresh banks are silent, so nothing fades
+    topologies.retirePrevious();
+    publishTopology(std::make_unique<TopologyUpdate>(voices[0].graph->getLayout(), topology,
+                                                     patch.edges.data(), static_cast<int>(patch.edges.size())),
+                    profiling::now());
+    topologies.update();
+    for (auto& voice : voices) {
+        voice.graph->useTopology(&topologies.get()->topology);
+    }
+
+    maxActiveVoices = std::min(maxActiveVoices, numVoices);
+    strikeCounter = 0;
+    blockStartStrike = 0;
+
+    chunkEvents.reserve(MAX_EVENTS_PER_VOICE);
+    energies.assign(static_cast<size_t>(voices[0].graph->getNumNodes()), 0.0f);
+}
+
+int VoiceManager::getNumActiveVoices() const {
+    return static_cast<int>(std::count_if(voices.begin(), voices.end(),
+        [](const Voice& v) { return v.active; }));
+}
+
+void VoiceManager::setMaxActiveVoices(int count) {
+    maxActiveVoices = std::clamp(count, 1, getNumVoices());
+}
+
+void VoiceManager::setTracer(profiling::Tracer* t, int track) {
+    tracer = t;
+    traceTrack = track;
+    for (int v = 0; v < getNumVoices(); v++) {
+        voices[static_cast<size_t>(v)].graph->setTracer(t, track, v);
+    }
+}
+
+void VoiceManager::setWorkerPool(WorkerPool* workers) {
+    // As ResonatorGraph::setWorkerPool: the audio thread waits on workers
+    pool = workers != nullptr && workers->isRealtime() ? workers : nullptr;
+}
+
+void VoiceManager::setEngine(Engine e) {
+    engine = e;
+    for (auto& voice : voices) {
+        voice.graph->setEngine(e);
+    }
+}
+
+void VoiceManager::setQuality(fastmath::Quality q) {
+    quality = q;
+    for (auto& voice : voices) {
+        voice.graph->setQuality(q);
+    }
+}
+
+void VoiceManager::setTopology(Topology topo) {
+    if (topo != topology) {
+        topology = topo;
+        publishTopology(std::make_unique<TopologyUpdate>(voices[0].graph->getLayout(), topo, patch.edges.data(),
+                                                         static_cast<int>(patch.edges.size())),
+                        profiling::now());
+    }
+}
+
+void VoiceManager::setCoupling(int from, int to, float weight) {
+    if (topologies.getLatest() == nullptr) {
+        return;
+    }
+    const uint64_t start = profiling::now();
+
+    // Remembered for the next topology; a repeated edge replaces its weight
+    auto edge = std::find_if(patch.edges.begin(), patch.edges.end(),
+                             [&](const CouplingEdge& e) { return e.from == from && e.to == to; });
+    if (edge != patch.edges.end()) {
+        edge->weight = weight;
+    } else if (patch.edges.size() < SynthPatch::MAX_EDGES) {
+        patch.edges.push_back({ from, to, weight });
+    }
+    publishTopology(std::make_unique<TopologyUpdate>(topologies.getLatest()->topology, from, to, weight), start);
+}
+
+void VoiceManager::setPatch(Topology topo, const SynthPatch& newPatch) {
+    const uint64_t start = profiling::now();
+    topology = topo;
+    patch = newPatch;
+    hasPatch = true;
+    auto update = std::make_unique<TopologyUpdate>(voices[0].graph->getLayout(), topo, patch.edges.data(),
+                                                   static_cast<int>(patch.edges.size()));
+    update->patch = std::make_unique<SynthPatch>(newPatch);
+    publishTopology(std::move(update), start);
+}
+
+void VoiceManager::applyPatch(ResonatorGraph& graph, const SynthPatch& p) const {
+    if (p.customNoteMap) {
+        for (int note = 0; note < ResonatorGraph::NUM_MIDI_NOTES; note++) {
+            graph.setNoteMapping(note, p.noteMap[static_cast<size_t>(note)]);
+        }
+    } else {
+        graph.resetNoteMapping();
+    }
+    graph.setNodeMix(p.nodes.data(), p.numNodes);
+}
+
+void VoiceManager::setTopologyFade(double seconds) {
+    topologyFade = seconds;
+    for (auto& voice : voices) {
+        voice.graph->setTopologyFade(seconds);
+    }
+}
+
+void VoiceManager::publishTopology(std::unique_ptr<TopologyUpdate> built, uint64_t start) {
+    // Publishing frees an update never adopted, so the new one carries
+    // its patch on. If the audio thread adopts it meanwhile, the patch
+    // applies twice, which changes nothing.
+    const TopologyUpdate* latest = topologies.getLatest();
+    if (built->patch == nullptr && latest != nullptr && latest->patch != nullptr && topologies.hasPending()) {
+        built->patch = std::make_unique<SynthPatch>(*latest->patch);
+    }
+    if (tracer != nullptr && tracer->isRecording()) {
+        profiling::TraceRecord record;
+        record.type = profiling::TraceRecord::Type::Topology;
+        record.track = static_cast<uint16_t>(traceTrack);
+        record.a = built->topology.isEdited() ? -1 : static_cast<int>(built->topology.getTopology());
+        record.b = built->topology.getNumEdges();
+        record.start = start;
+        record.end = profiling::now();
+        tracer->record(record);
+    }
+    topologies.publish(std::move(built));
+}
+
+void VoiceManager::adoptTopology() {
+    // The topology voices fade from goes back to be freed once none of
+    // them reads it; only then can the next one start
+    if (topologies.getPrevious() != nullptr) {
+        for (const auto& voice : voices) {
+            if (voice.graph->isTopologyFading()) {
+                return;
+            }
+        }
+        if (!topologies.retirePrevious()) {
+            return;
+        }
+    }
+    if (topologies.updateKeepingPrevious()) {
+        const TopologyUpdate& update = *topologies.get();
+        for (auto& voice : voices) {
+            voice.graph->useTopology(&update.topology);
+            if (update.patch != nullptr) {
+                applyPatch(*voice.graph, *update.patch);
+            }
+        }
+    }
+}
+
+void VoiceManager::setGlobalCoupling(float amount) {
+    globalCoupling = amount;
+    for (auto& voice : voices) {
+        voice.graph->setGlobalCoupling(amount);
+    }
+}
+
+void VoiceManager::setDamping(float d) {
+    damping = d;
+    for (auto& voice : voices) {
+        voice.graph->setDamping(d);
+    }
+}
+
+void VoiceManager::setBrightness(float b) {
+    brightness = b;
+    for (auto& voice : voices) {
+        voice.graph->setBrightness(b);
+    }
+}
+
+void VoiceManager::setExciter(const ExciterSettings& settings) {
+    if (settings == exciterSettings) {
+        return;
+    }
+    exciterSettings = settings;
+    excitation.publish(std::make_unique<ExcitationTable>(settings));
+}
+
+bool VoiceManager::post(const GraphCommand& command) {
+    return commands.push(command);
+}
+
+void VoiceManager::drainCommands() {
+    GraphCommand command;
+    while (commands.pop(command)) {
+        switch (command.type) {
+            case GraphCommand::Type::NoteOn:
+                dispatch(NoteEvent::noteOn(0, command.a, command.value));
+                break;
+            case GraphCommand::Type::NoteOff:
+                dispatch(NoteEvent::noteOff(0, command.a));
+                break;
+            case GraphCommand::Type::Reset:
+                reset();
+                break;
+        }
+    }
+}
+
+void VoiceManager::noteOn(int midiNote, float velocity) {
+    dispatch(NoteEvent::noteOn(0, midiNote, velocity));
+}
+
+void VoiceManager::noteOff(int midiNote) {
+    dispatch(NoteEvent::noteOff(0, midiNote));
+}
+
+bool VoiceManager::nodeAccepts(const Voice& voice, int node, int midiNote) const {
+    if (voice.nodeNote[static_cast<size_t>(node)] == midiNote) {
+        return true;  // Re-striking the same string
+    }
+
+    // Quiet, and not already claimed by a note earlier in this block
+    return voice.graph->getEnergies()[node] < QUIET_NODE
+        && voice.nodeStrike[static_cast<size_t>(node)] <= blockStartStrike;
+}
+
+float VoiceManager::voiceLevel(const Voice& voice) const {
+    // A fading voice's sound is already on its way out
+    float level = 0.0f;
+    if (!voice.fade.isRamping()) {
+        const float* e = voice.graph->getEnergies();
+        level = *std::max_element(e, e + voice.graph->getNumNodes());
+    }
+
+    // Queued strikes have not reached the energies yet
+    for (const auto& event : voice.events) {
+        if (event.type == NoteEvent::Type::NoteOn) {
+            level = std::max(level, event.velocity);
+        }
+    }
+    return level;
+}
+
+bool VoiceManager::isReleasing(const Voice& voice) const {
+    return voice.fade.isRamping() && voice.events.empty();
+}
+
+int VoiceManager::countHeldVoices() const {
+    // Voices fading out with nothing to play next are on their way to idle
+    return static_cast<int>(std::count_if(voices.begin(), voices.end(),
+        [this](const Voice& v) { return v.active && !isReleasing(v); }));
+}
+
+int VoiceManager::quietestVoice(bool releasing) const {
+    // Voices struck earlier in this block go last, whatever their level
+    int best = -1;
+    bool bestStruck = false;
+    float quietest = 0.0f;
+    for (int v = 0; v < getNumVoices(); v++) {
+        const auto& voice = voices[static_cast<size_t>(v)];
+        if (!voice.active || (!releasing && isReleasing(voice))) {
+            continue;
+        }
+        const bool struck = voice.lastStrike > blockStartStrike;
+        const float level = voiceLevel(voice);
+        if (best < 0 || (struck != bestStruck ? !struck : level < quietest)) {
+            best = v;
+            bestStruck = struck;
+            quietest = level;
+        }
+    }
+    return best;
+}
+
+int VoiceManager::allocateVoice(int node, int midiNote) {
+    int best = -1;
+
+    // Voices fading out are only reused by stealing, below
+    for (int v = 0; v < getNumVoices(); v++) {
+        const auto& voice = voices[static_cast<size_t>(v)];
+        if (!voice.active || isReleasing(voice)) {
+            continue;
+        }
+        if (nodeAccepts(voice, node, midiNote)
+            && (best < 0 || voice.lastStrike > voices[static_cast<size_t>(best)].lastStrike)) {
+            best = v;
+        }
+    }
+    if (best >= 0) {
+        return best;
+    }
+
+    if (countHeldVoices() < maxActiveVoices) {
+        for (int v = 0; v < getNumVoices(); v++) {
+            if (!voices[static_cast<size_t>(v)].active) {
+                return v;
+            }
+        }
+    }
+
+    // Steal the quietest sounding voice; one already fading out costs
+    // nothing, and its level is 0
+    best = quietestVoice(true);
+    steal(voices[static_cast<size_t>(best)]);
+    return best;
+}
+
+void VoiceManager::dispatch(const NoteEvent& event) {
+    int node = voices[0].graph->getNodeForNote(event.note);
+    if (node < 0) {
+        return;
+    }
+
+    profiling::TraceRecord record;
+    if (tracing) {
+        record.track = static_cast<uint16_t>(traceTrack);
+        record.a = event.note;
+        record.b = event.sampleOffset;
+        record.c = -1;
+        record.start = record.end = profiling::now();
+    }
+
+    if (event.type == NoteEvent::Type::NoteOff) {
+        // Reaches every voice holding the note (a no-op in the graph
+        // today, kept for dampers)
+        for (auto& voice : voices) {
+            if (voice.active && voice.nodeNote[static_cast<size_t>(node)] == event.note
+                && voice.events.size() < voice.events.capacity()) {
+                voice.events.push_back(event);
+            }
+        }
+        if (tracing) {
+            record.type = profiling::TraceRecord::Type::NoteOff;
+            tracer->record(record);
+        }
+        return;
+    }
+
+    const int v = allocateVoice(node, event.note);
+    auto& voice = voices[static_cast<size_t>(v)];
+    if (tracing) {
+        record.type = profiling::TraceRecord::Type::NoteOn;
+        record.c = voice.events.size() < voice.events.capacity() ? v : -1;
+        record.velocity = event.velocity;
+        tracer->record(record);
+    }
+    if (voice.events.size() == voice.events.capacity()) {
+        return;
+    }
+
+    voice.active = true;
+    voice.lastStrike = ++strikeCounter;
+    voice.nodeNote[static_cast<size_t>(node)] = event.note;
+    voice.nodeStrike[static_cast<size_t>(node)] = strikeCounter;
+    voice.events.push_back(event);
+}
+
+void VoiceManager::steal(Voice& voice) {
+    // Nothing has sounded yet: clearing it cannot click
+    if (voice.graph->isAsleep() && !voice.fade.isRamping()) {
+        silence(voice);
+        return;
+    }
+
+    // Fade out what it plays; whatever is queued next strikes after that
+    voice.events.clear();
+    std::fill(voice.nodeNote.begin(), voice.nodeNote.end(), -1);
+    if (!voice.fade.isRamping()) {
+        voice.fade.reset(1.0f);
+        voice.fade.setTarget(0.0f, stealFadeSamples);
+    }
+}
+
+void VoiceManager::silence(Voice& voice) {
+    voice.graph->reset();
+    voice.active = false;
+    voice.events.clear();
+    voice.fade.reset(0.0f);
+    std::fill(voice.nodeNote.begin(), voice.nodeNote.end(), -1);
+}
+
+void VoiceManager::enforceCap() {
+    while (countHeldVoices() > maxActiveVoices) {
+        steal(voices[static_cast<size_t>(quietestVoice(false))]);
+    }
+}
+
+void VoiceManager::processBlock(float* leftOut, float* rightOut, int numSamples,
+                                const NoteEvent* events, int numEvents) {
+    phaseTimes.clear();
+    phaseTimer.start();
+
+    tracing = tracer != nullptr && tracer->isRecording();
+    const uint64_t start = tracing ? profiling::now() : 0;
+    blockVoices = 0;
+    blockNodes = 0;
+
+    if (numSamples <= maxBlockSize) {
+        renderBlock(leftOut, rightOut, numSamples, events, numEvents);
+    } else {
+        renderPieces(leftOut, rightOut, numSamples, events, numEvents);
+    }
+
+    if (tracing) {
+        profiling::TraceRecord record;
+        record.type = profiling::TraceRecord::Type::Block;
+        record.track = static_cast<uint16_t>(traceTrack);
+        record.a = numSamples;
+        record.b = numEvents;
+        record.c = blockVoices;
+        record.d = blockNodes;
+        record.start = start;
+        record.end = profiling::now();
+        record.setPhases(phaseTimes);
+        tracer->record(record);
+    }
+}
+
+void VoiceManager::renderPieces(float* leftOut, float* rightOut, int numSamples,
+                                const NoteEvent* events, int numEvents) {
+    // Longer than prepared for: split, rebasing event offsets per piece
+    int e = 0;
+    for (int pos = 0; pos < numSamples; pos += maxBlockSize) {
+        int length = std::min(maxBlockSize, numSamples - pos);
+        chunkEvents.clear();
+        while (e < numEvents && events[e].sampleOffset < pos + length) {
+            NoteEvent event = events[e++];
+            event.sampleOffset = std::max(0, event.sampleOffset - pos);
+            if (chunkEvents.size() < chunkEvents.capacity()) {
+                chunkEvents.push_back(event);
+            }
+        }
+        renderBlock(leftOut + pos, rightOut + pos, length,
+                    chunkEvents.data(), static_cast<int>(chunkEvents.size()));
+    }
+}
+
+void VoiceManager::renderBlock(float* leftOut, float* rightOut, int numSamples,
+                               const NoteEvent* events, int numEvents) {
+    blockStartStrike = strikeCounter;
+
+    // Strikes in flight read the current table, which update() hands
+    // back to be freed
+    if (excitation.hasPending()) {
+        for (auto& voice : voices) {
+            voice.graph->finishStrikes();
+        }
+        if (excitation.update()) {
+            for (auto& voice : voices) {
+                voice.graph->setExcitation(excitation.get());
+            }
+        }
+    }
+    adoptTopology();
+
+    enforceCap();
+    drainCommands();
+    for (int e = 0; e < numEvents; e++) {
+        dispatch(events[e]);
+    }
+    phaseTimer.lap(profiling::Phase::Events);
+
+    std::fill(leftOut, leftOut + numSamples, 0.0f);
+    std::fill(rightOut, rightOut + numSamples, 0.0f);
+    std::fill(energies.begin(), energies.end(), 0.0f);
+    phaseTimer.lap(profiling::Phase::Output);
+
+    // The voices time themselves, on whichever thread renders them
+    renderVoices(numSamples);
+    phaseTimer.skip();
+
+    // Summed in voice order whichever thread rendered what
+    const int numNodes = static_cast<int>(energies.size());
+    for (auto& voice : voices) {
+        if (!voice.active) {
+            continue;  // Idle voices cost nothing
+        }
+        phaseTimes.add(voice.graph->getPhaseTimes());
+
+        for (int s = 0; s < numSamples; s++) {
+            leftOut[s] += voice.left[static_cast<size_t>(s)];
+            rightOut[s] += voice.right[static_cast<size_t>(s)];
+        }
+
+        const float* e = voice.graph->getEnergies();
+        for (int i = 0; i < numNodes; i++) {
+            energies[static_cast<size_t>(i)] = std::max(energies[static_cast<size_t>(i)], e[i]);
+        }
+
+        // Fully decayed and zeroed by the graph, with no note waiting on a
+        // steal fade: stop processing
+        if (voice.graph->isAsleep() && voice.events.empty()) {
+            voice.active = false;
+        }
+    }
+    phaseTimer.lap(profiling::Phase::Output);
+}
+
+void VoiceManager::renderVoices(int numSamples) {
+    int numActive = 0;
+    for (int v = 0; v < getNumVoices(); v++) {
+        if (voices[static_cast<size_t>(v)].active) {
+            renderOrder[static_cast<size_t>(numActive++)] = v;
+        }
+    }
+
+    // Awake nodes as rendering starts, the block's busiest moment
+    int numNodes = 0;
+    for (int t = 0; t < numActive; t++) {
+        numNodes += voices[static_cast<size_t>(renderOrder[static_cast<size_t>(t)])].graph->getNumAwakeNodes();
+    }
+    blockVoices = std::max(blockVoices, numActive);
+    blockNodes = std::max(blockNodes, numNodes);
+
+    auto render = [&](int task) {
+        const int v = renderOrder[static_cast<size_t>(task)];
+        auto& voice = voices[static_cast<size_t>(v)];
+        const uint64_t start = tracing ? profiling::now() : 0;
+        const int numEvents = static_cast<int>(voice.events.size());
+        renderVoice(voice, numSamples);
+        if (tracing) {
+            profiling::TraceRecord record;
+            record.type = profiling::TraceRecord::Type::Voice;
+            record.track = static_cast<uint16_t>(traceTrack);
+            record.thread = static_cast<int16_t>(1 + v);
+            record.a = voice.graph->getNumAwakeNodes();
+            record.b = numEvents;
+            record.start = start;
+            record.end = profiling::now();
+            tracer->record(record);
+        }
+    };
+
+    if (pool == nullptr || numActive < 2) {
+        for (int t = 0; t < numActive; t++) {
+            render(t);
+        }
+        return;
+    }
+
+    // Busiest first, so no thread picks up a long voice last. Insertion
+    // sort: stable, and std::stable_sort may allocate.
+    auto load = [this](int v) { return voices[static_cast<size_t>(v)].graph->getNumAwakeGroups(); };
+    for (int i = 1; i < numActive; i++) {
+        const int v = renderOrder[static_cast<size_t>(i)];
+        int j = i;
+        for (; j > 0 && load(renderOrder[static_cast<size_t>(j - 1)]) < load(v); j--) {
+            renderOrder[static_cast<size_t>(j)] = renderOrder[static_cast<size_t>(j - 1)];
+        }
+        renderOrder[static_cast<size_t>(j)] = v;
+    }
+    pool->run(numActive, render);
+}
+
+void VoiceManager::renderVoice(Voice& voice, int numSamples) {
+    auto& graph = *voice.graph;
+    float* left = voice.left.data();
+    float* right = voice.right.data();
+
+    // A stolen voice plays out its fade first; its graph is cleared when
+    // the fade ends and queued notes strike from there
+    int start = 0;
+    if (voice.fade.isRamping()) {
+        start = std::min(numSamples, voice.fade.getStepsLeft());
+        graph.processBlock(left, right, start);
+        for (int s = 0; s < start; s++) {
+            const float gain = voice.fade.next();
+            left[s] *= gain;
+            right[s] *= gain;
+        }
+        if (!voice.fade.isRamping()) {
+            graph.reset();
+        }
+        if (start == numSamples) {
+            for (auto& event : voice.events) {
+                event.sampleOffset = 0;   // Held for the next block
+            }
+            return;
+        }
+        for (auto& event : voice.events) {
+            event.sampleOffset = std::max(0, event.sampleOffset - start);
+        }
+    }
+
+    graph.processBlock(left + start, right + start, numSamples - start,
+                       voice.events.data(), static_cast<int>(voice.events.size()));
+    voice.events.clear();
+}
+
+double VoiceManager::getTailSeconds() const {
+    double tail = 0.0;
+    for (const auto& voice : voices) {
+        tail = std::max(tail, voice.graph->getTailSeconds());
+    }
+    return tail;
+}
+
+void VoiceManager::reset() {
+    for (auto& voice : voices) {
+        silence(voice);
+    }
+    std::fill(energies.begin(), energies.end(), 0.0f);
+}
+
+} // namespace rgs
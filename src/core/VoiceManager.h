@@ -0,0 +1,247 @@
+#pragma once
+
+#include "GraphCommand.h"
+#include "NoteEvent.h"
+#include "ObjectExchange.h"
+#include "Ramp.h"
+#include "ResonatorGraph.h"
+#include "SpscQueue.h"
+#include "SynthState.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace rgs {
+
+class WorkerPool;
+
+/**
+ * Polyphony: a pool of ResonatorGraph voices
+ *
+ * Notes share a voice whenever they can, so chords still couple inside
+ * one graph. A note moves to another voice only when its node in every
+ * sounding voice is still ringing at a different pitch (re-striking C5
+ * while C4 rings on a folded octave), which would otherwise retune the
+ * string mid-ring.
+ *
+ * Allocation order for a note-on:
+ * 1. the most recently struck active voice whose node is free or
+ *    already at this pitch
+ * 2. an idle voice, while fewer than the active-voice cap are sounding
+ * 3. steal the quietest active voice
+ *
+ * A voice's level for stealing is its loudest node, or the velocity of a
+ * strike still queued for it if that is louder. Voices struck earlier in
+ * the same block are stolen only when every voice was, so a burst of
+ * notes does not steal its own. A stolen voice drops its queued notes and
+ * fades out over STEAL_FADE_SECONDS before its graph is cleared; the new
+ * note strikes when the fade ends. A voice that is already silent is
+ * cleared at once.
+ *
+ * A voice goes idle once its graph is fully asleep, with no note queued
+ * behind a steal fade, and is not processed at all: a note frees its
+ * voice within ResonatorGraph::getTailSeconds() (rgs_bench --decay
+ * --voices N checks it). Every voice is allocated in prepare().
+ *
+ * Given a WorkerPool, active voices render in parallel, one task each,
+ * busiest first. Each voice renders into its own buffers and they are
+ * summed in voice order afterwards, so the output is the same as
+ * rendering them one after another.
+ */
+class VoiceManager {
+public:
+    static constexpr int MAX_VOICES = 16;
+    static constexpr int MAX_EVENTS_PER_VOICE = 4096;
+
+    // A node quieter than this can take a new pitch
+    static constexpr float QUIET_NODE = 0.005f;
+
+    // Fade-out of a stolen voice, and so the delay of the note stealing it
+    static constexpr double STEAL_FADE_SECONDS = 0.005;
+
+    VoiceManager();
+
+    // Allocate every voice and scratch buffer. Not for the audio thread.
+    void prepare(double sampleRate, const GraphLayout& layout, int maxBlockSize,
+                 int numVoices = MAX_VOICES);
+
+    int getNumVoices() const { return static_cast<int>(voices.size()); }
+    int getNumActiveVoices() const;
+
+    // Hard CPU cap: at most this many voices are processed, plus voices
+    // fading out after a steal. Lowering it fades out the quietest voices
+    // at the next block.
+    void setMaxActiveVoices(int count);
+    int getMaxActiveVoices() const { return maxActiveVoices; }
+
+    // Threads to render voices on (nullptr: the audio thread alone). Each
+    // voice's graph stays on one thread. A pool whose workers are not
+    // realtime (WorkerPool::isRealtime()) is ignored and voices render
+    // one after another. The pool must outlive this or the next call.
+    // Not for the audio thread.
+    void setWorkerPool(WorkerPool* workers);
+
+    // Trace blocks, note dispatch and every voice's work on this track
+    // while tracer is recording (see Trace.h). nullptr stops. The tracer
+    // must outlive this or the next call. Not for the audio thread.
+    void setTracer(profiling::Tracer* tracer, int track);
+
+    // Voices share layout and topology; voice 0 describes them
+    const ResonatorGraph& getVoice(int index) const { return *voices[static_cast<size_t>(index)].graph; }
+    ResonatorGraph& getVoice(int index) { return *voices[static_cast<size_t>(index)].graph; }
+
+    // Forwarded to every voice. setEngine allocates.
+    void setEngine(Engine e);
+    void setQuality(fastmath::Quality q);
+    void setGlobalCoupling(float amount);
+    void setDamping(float d);
+    void setBrightness(float b);
+
+    // Build excitation tables for these settings and hand them to the
+    // voices, which switch at the start of the next block. Allocates and
+    // renders every shape: call from one non-audio thread. A no-op when
+    // the settings have not changed.
+    void setExciter(const ExciterSettings& settings);
+
+    // Compile one topology for every voice to share, as
+    // ResonatorGraph::setTopology() and setCoupling(). Voices switch at
+    // the start of the next block, sounding ones over the crossfade.
+    // Allocates: call from one non-audio thread, the same as
+    // setExciter's.
+    // Coupling edits made here are kept across topology changes.
+    void setTopology(Topology topo);
+    void setCoupling(int from, int to, float weight);
+
+    // Switch to a topology and patch together: one topology build with
+    // the patch's coupling edits, published with its note map and node
+    // mix so every voice takes all of them at the same block boundary
+    // (the coupling crossfades, the mix glides). Same thread as
+    // setTopology(). A custom note map reaches the delay lines at the
+    // next prepare().
+    void setPatch(Topology topo, const SynthPatch& patch);
+
+    // Forwarded to every voice; takes effect at the next prepare()
+    void setTopologyFade(double seconds);
+
+    // Queue a command from a non-audio thread, as ResonatorGraph::post().
+    // Notes are allocated to voices; reset applies to all.
+    bool post(const GraphCommand& command);
+
+    void noteOn(int midiNote, float velocity);
+    void noteOff(int midiNote);
+
+    // Events must be sorted by sampleOffset. Blocks longer than the
+    // prepared maximum are processed in pieces.
+    void processBlock(float* leftOut, float* rightOut, int numSamples,
+                      const NoteEvent* events, int numEvents);
+
+    // Time spent per phase in the last processBlock, this class's own
+    // plus every rendered voice's (see Profiler.h)
+    const profiling::PhaseTimes& getPhaseTimes() const { return phaseTimes; }
+
+    // Loudest energy of each node across active voices
+    const float* getEnergies() const { return energies.data(); }
+
+    // Longest tail of any voice. Safe from any thread.
+    double getTailSeconds() const;
+
+    void reset();
+
+private:
+    struct Voice {
+        std::unique_ptr<ResonatorGraph> graph;
+        bool active = false;
+        uint64_t lastStrike = 0;
+        std::vector<int> nodeNote;          // Pitch each node was last struck at
+        std::vector<uint64_t> nodeStrike;   // When, in strike counts
+        std::vector<NoteEvent> events;      // Events not yet rendered
+        Ramp fade;                          // Output gain while stolen
+        std::vector<float> left;            // This block's output
+        std::vector<float> right;
+    };
+
+    void renderBlock(float* leftOut, float* rightOut, int numSamples,
+                     const NoteEvent* events, int numEvents);
+    void renderPieces(float* leftOut, float* rightOut, int numSamples,
+                      const NoteEvent* events, int numEvents);
+    void renderVoices(int numSamples);
+    void renderVoice(Voice& voice, int numSamples);
+    struct TopologyUpdate;
+    void adoptTopology();
+    void applyPatch(ResonatorGraph& graph, const SynthPatch& patch) const;
+    void publishTopology(std::unique_ptr<TopologyUpdate> built, uint64_t start);
+    void drainCommands();
+    void dispatch(const NoteEvent& event);
+    int allocateVoice(int node, int midiNote);
+    bool nodeAccepts(const Voice& voice, int node, int midiNote) const;
+    float voiceLevel(const Voice& voice) const;
+    bool isReleasing(const Voice& voice) const;
+    int countHeldVoices() const;
+    int quietestVoice(bool releasing) const;   // releasing: fading ones too
+    void steal(Voice& voice);
+    void silence(Voice& voice);
+    void enforceCap();
+
+    std::vector<Voice> voices;
+    int maxActiveVoices = MAX_VOICES;
+
+    // Settings every voice shares, replayed onto voices created in prepare()
+    Engine engine = Engine::Simd;
+    fastmath::Quality quality = fastmath::Quality::Normal;
+    double topologyFade = ResonatorGraph::TOPOLOGY_FADE_SECONDS;
+    float globalCoupling = 0.3f;
+    float damping = 0.997f;
+    float brightness = 0.7f;
+
+    // Shared by every voice; exciterSettings belongs to the setExciter() thread
+    ObjectExchange<ExcitationTable> excitation;
+    ExciterSettings exciterSettings;
+
+    // A topology every voice shares, and the note map and node mix that
+    // switch with it (setPatch()), in one object so voices never render
+    // one without the other
+    struct TopologyUpdate {
+        template <typename... Args>
+        explicit TopologyUpdate(Args&&... args) : topology(std::forward<Args>(args)...) {}
+
+        CompiledTopology topology;
+        std::unique_ptr<SynthPatch> patch;   // nullptr: keep the current ones
+    };
+
+    // Kept while any voice fades from the previous topology; topology
+    // belongs to the setTopology() thread
+    ObjectExchange<TopologyUpdate> topologies;
+    Topology topology = Topology::Fifths;
+
+    // The last setPatch() with its coupling edits since, on the
+    // setTopology() thread; hasPatch once there was one
+    SynthPatch patch;
+    bool hasPatch = false;
+
+    int maxBlockSize = 0;
+    int stealFadeSamples = 1;
+
+    uint64_t strikeCounter = 0;
+    uint64_t blockStartStrike = 0;
+
+    WorkerPool* pool = nullptr;
+    std::array<int, MAX_VOICES> renderOrder {};   // Active voices, busiest first
+
+    std::vector<NoteEvent> chunkEvents;
+    std::vector<float> energies;
+
+    SpscQueue<GraphCommand> commands { 1024 };
+
+    profiling::PhaseTimes phaseTimes;
+    profiling::PhaseTimer phaseTimer { phaseTimes };
+
+    profiling::Tracer* tracer = nullptr;
+    int traceTrack = 0;
+    bool tracing = false;   // tracer->isRecording(), once per block
+    int blockVoices = 0;    // Most voices rendered by one renderBlock
+    int blockNodes = 0;
+};
+
+} // namespace rgs
@@ -0,0 +1,166 @@
+#include "WorkerPool.h"
+#include "Denormals.h"
+#include <algorithm>
+#include <chrono>
+
+#if defined(__linux__) || defined(__APPLE__)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+#endif
+
+namespace rgs {
+
+namespace {
+
+// Short pause inside spin loops
+void relax() {
+#if defined(__SSE2__) || defined(_M_X64)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Realtime round-robin at a middle priority. False when the OS refuses
+// (no privilege) or has no such call here: the thread keeps its normal
+// priority.
+bool requestRealtime(std::thread& thread) {
+#if defined(__linux__) || defined(__APPLE__)
+    sched_param param {};
+    const int lowest = sched_get_priority_min(SCHED_RR);
+    param.sched_priority = lowest + (sched_get_priority_max(SCHED_RR) - lowest) / 2;
+    return pthread_setschedparam(thread.native_handle(), SCHED_RR, &param) == 0;
+#else
+    (void) thread;
+    return false;
+#endif
+}
+
+// Spins between yields: enough to catch a task finishing on another core
+constexpr int SPINS_PER_YIELD = 64;
+
+} // namespace
+
+WorkerPool::WorkerPool(int numThreads) {
+    // hardware_concurrency() is 0 when unknown
+    const int hardware = static_cast<int>(std::thread::hardware_concurrency());
+    const int limit = hardware > 0 ? std::min(hardware, MAX_THREADS) : MAX_THREADS;
+    const int numWorkers = std::clamp(numThreads, 1, limit) - 1;
+    workers.reserve(static_cast<size_t>(numWorkers));
+    for (int i = 0; i < numWorkers; i++) {
+        workers.emplace_back([this] { workerLoop(); });
+        realtime = requestRealtime(workers.back()) && realtime;
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        running.store(false, std::memory_order_release);
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void WorkerPool::run(int numTasks, void (*task)(void*, int), void* context) {
+    if (numTasks <= 0) {
+        return;
+    }
+    if (workers.empty() || numTasks == 1) {
+        for (int t = 0; t < numTasks; t++) {
+            task(context, t);
+        }
+        return;
+    }
+
+    // The claim word is CLOSED from the last job, so a worker still
+    // reading the old job's fields cannot claim from this one
+    const uint32_t next = generation.load(std::memory_order_relaxed) + 1;
+    jobTask = task;
+    jobContext = context;
+    jobTasks.store(numTasks, std::memory_order_relaxed);
+    finished.store(0, std::memory_order_relaxed);
+    claim.store(static_cast<uint64_t>(next) << 32, std::memory_order_release);
+    generation.store(next, std::memory_order_release);
+    if (sleepers.load(std::memory_order_acquire) > 0) {
+        wake.notify_all();
+    }
+
+    claimAndRun(next);
+
+    // Only tasks already running elsewhere are left
+    for (int spins = 1; finished.load(std::memory_order_acquire) < numTasks; spins++) {
+        relax();
+        if (spins % SPINS_PER_YIELD == 0) {
+            std::this_thread::yield();
+        }
+    }
+    claim.store((static_cast<uint64_t>(next) << 32) | CLOSED, std::memory_order_release);
+}
+
+void WorkerPool::claimAndRun(uint32_t gen) {
+    uint64_t current = claim.load(std::memory_order_acquire);
+    for (;;) {
+        // Another job, or this one has no tasks left
+        if (static_cast<uint32_t>(current >> 32) != gen) {
+            return;
+        }
+        const auto index = static_cast<uint32_t>(current);
+        if (index >= static_cast<uint32_t>(jobTasks.load(std::memory_order_relaxed))) {
+            return;
+        }
+        if (!claim.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel,
+                                         std::memory_order_acquire)) {
+            continue;
+        }
+
+        jobTask(jobContext, static_cast<int>(index));
+        finished.fetch_add(1, std::memory_order_acq_rel);
+        current = claim.load(std::memory_order_acquire);
+    }
+}
+
+void WorkerPool::workerLoop() {
+    ScopedFlushDenormals noDenormals;
+    using Clock = std::chrono::steady_clock;
+
+    uint32_t seen = generation.load(std::memory_order_acquire);
+    auto idleSince = Clock::now();
+
+    while (running.load(std::memory_order_acquire)) {
+        const uint32_t gen = generation.load(std::memory_order_acquire);
+        if (gen != seen) {
+            seen = gen;
+            claimAndRun(gen);
+            idleSince = Clock::now();
+            continue;
+        }
+
+        if (std::chrono::duration<double>(Clock::now() - idleSince).count() < IDLE_SPIN) {
+            for (int i = 0; i < SPINS_PER_YIELD; i++) {
+                relax();
+            }
+            std::this_thread::yield();
+            continue;
+        }
+
+        // A job published between the check and the wait is only picked
+        // up at the timeout; the caller does that share itself meanwhile
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepers.fetch_add(1, std::memory_order_acq_rel);
+        wake.wait_for(lock, std::chrono::milliseconds(1), [&] {
+            return !running.load(std::memory_order_acquire)
+                || generation.load(std::memory_order_acquire) != seen;
+        });
+        sleepers.fetch_sub(1, std::memory_order_acq_rel);
+        idleSince = Clock::now();
+    }
+}
+
+} // namespace rgs
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rgs {
+
+/**
+ * Fixed pool of worker threads that help the audio thread through a job
+ *
+ * run() splits a job into numbered tasks that the workers and the calling
+ * thread claim one at a time from a shared counter. The caller claims
+ * too, so it never waits on a worker that has not picked the job up: a
+ * worker that is asleep, descheduled or slow to wake just leaves its
+ * share to the caller. The caller only waits for tasks already running
+ * on another thread, spinning (never sleeping) until they finish.
+ *
+ * Workers spin for IDLE_SPIN after each job, so the next one in the same
+ * block finds them awake, then sleep until woken. They ask for realtime
+ * scheduling and flush denormals like the audio thread
+ * (ScopedFlushDenormals).
+ *
+ * Limitation: the caller's wait for a running task is only bounded if
+ * the worker running it cannot be preempted by ordinary threads. A
+ * normal-priority worker descheduled mid-task stalls the caller for as
+ * long as the OS keeps it off the CPU, and a realtime caller's yield
+ * never hands the CPU to it. Realtime scheduling needs the privilege on
+ * Linux and macOS (RLIMIT_RTPRIO, or root) and is not requested
+ * elsewhere; isRealtime() says whether every worker got it, and
+ * ResonatorGraph and VoiceManager ignore a pool that did not.
+ *
+ * One thread calls run() at a time. run() never allocates or locks.
+ */
+class WorkerPool {
+public:
+    static constexpr int MAX_THREADS = 16;   // Workers + the calling thread
+    static constexpr double IDLE_SPIN = 200e-6;   // Seconds
+
+    // numThreads counts the calling thread: numThreads - 1 workers, at
+    // most one thread per hardware thread (more only take turns with the
+    // caller, which then waits on descheduled tasks)
+    explicit WorkerPool(int numThreads);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    int getNumThreads() const { return static_cast<int>(workers.size()) + 1; }
+
+    // Every worker runs with realtime scheduling (see the class comment)
+    bool isRealtime() const { return realtime; }
+
+    // fn(task) for every task in [0, numTasks), spread over the pool;
+    // returns once all have finished
+    template <typename Fn>
+    void run(int numTasks, Fn& fn) {
+        run(numTasks, [](void* context, int task) { (*static_cast<Fn*>(context))(task); }, &fn);
+    }
+
+    void run(int numTasks, void (*task)(void*, int), void* context);
+
+private:
+    // Claim word: job generation in the high half, next task in the low
+    static constexpr uint64_t CLOSED = 0xffffffffu;
+
+    void workerLoop();
+    void claimAndRun(uint32_t generation);
+
+    std::vector<std::thread> workers;
+    bool realtime = true;
+
+    // The current job, written before its generation is published.
+    // Workers read the task only after claiming from it; the count may be
+    // read stale, and the claim then fails.
+    void (*jobTask)(void*, int) = nullptr;
+    void* jobContext = nullptr;
+    std::atomic<int> jobTasks { 0 };
+
+    std::atomic<uint32_t> generation { 0 };
+    std::atomic<uint64_t> claim { CLOSED };
+    std::atomic<int> finished { 0 };
+    std::atomic<bool> running { true };
+
+    // Sleeping workers wait here; run() notifies without taking the lock
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<int> sleepers { 0 };
+};
+
+} // namespace rgs
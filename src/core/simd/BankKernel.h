@@ -0,0 +1,199 @@
+#pragma once
+
+#include "../FastMath.h"
+#include <cstddef>
+#include <cstdint>
+
+// Included by the per-ISA kernel translation units, which are compiled
+// with different target flags. Keep this header free of standard library
+// calls (and use only the vector forms from FastMath.h) so no inline
+// function gets emitted with wider instructions than the rest of the
+// program expects.
+
+namespace rgs::simd {
+
+/**
+ * Structure-of-arrays view of a ResonatorBank, one entry per lane
+ *
+ * All lane arrays are 64-byte aligned and padded to a multiple of
+ * MAX_WIDTH lanes. Padding lanes hold zero state and a valid delay.
+ *
+ * Each lane's delay line is a power-of-two slice of one arena. Lanes
+ * share writePos, a counter wrapping at the longest line; a lane's own
+ * position is writePos & lineMask[i], which stays consistent because
+ * every line length divides the longest one.
+ */
+struct BankLanes {
+    // Loop filters
+    float* lpfState;
+    const float* lpfCoeff;
+    float* apfState;
+    const float* apfCoeff;
+    const float* apfEnabled;    // 1 when the allpass is active, else 0
+    const float* damping;
+
+    // Delay line read
+    const float* fractionalDelay;
+    const int32_t* delayLength;
+
+    // Outputs
+    float* energy;
+    float* output;
+
+    // Coupling input for this sample
+    const float* input;
+
+    // Scratch for the gather / scatter around the vector section
+    float* read0;
+    float* read1;
+    float* feedback;
+
+    // Delay lines: lane i owns lines[lineOffset[i], lineOffset[i] + lineMask[i]]
+    float* lines;
+    const int32_t* lineOffset;
+    const int32_t* lineMask;    // Line length - 1, lengths are powers of two
+    int writePos;               // Shared by all lanes, advanced by the caller
+
+    int numLanes;
+    bool ecoTanh;               // fastmath::tanhEco for Quality::Eco
+    float energyDecay;          // Energy meter decay per sample
+
+    // Sub-block schedule (processBankBlock): numSamples time-major rows,
+    // blockStride lanes apart
+    const float* blockOutput;
+    const float* blockRead0;
+    const float* blockInput;
+    float* blockFeedback;
+    int blockStride;
+    int numSamples;
+};
+
+using BankKernel = void (*)(BankLanes&);
+
+void processBankScalar(BankLanes& lanes);
+void processBankSse2(BankLanes& lanes);
+void processBankAvx2(BankLanes& lanes);
+void processBankAvx512(BankLanes& lanes);
+
+void processBankBlockScalar(BankLanes& lanes);
+void processBankBlockSse2(BankLanes& lanes);
+void processBankBlockAvx2(BankLanes& lanes);
+void processBankBlockAvx512(BankLanes& lanes);
+
+/**
+ * Loop filters, damping, coupling input and soft clamp for lanes
+ * [i, i + WIDTH) given the interpolated sample and the raw read at the
+ * delay. Returns the value to write back into the delay line.
+ */
+template <class V, bool Eco>
+inline typename V::Vec loopFeedback(BankLanes& b, int i, typename V::Vec sample,
+                                    typename V::Vec s0, typename V::Vec input) {
+    const auto one = V::set1(1.0f);
+
+    // One-pole lowpass for frequency-dependent damping
+    const auto c = V::load(b.lpfCoeff + i);
+    auto lpf = V::add(V::mul(c, sample), V::mul(V::sub(one, c), V::load(b.lpfState + i)));
+    V::store(b.lpfState + i, lpf);
+
+    // Allpass for inharmonicity, blended in only on lanes that use it
+    const auto apfActive = V::greater(V::load(b.apfEnabled + i), V::zero());
+    const auto apfState = V::load(b.apfState + i);
+    const auto apfOut = V::add(V::mul(V::load(b.apfCoeff + i), V::sub(lpf, apfState)), s0);
+    V::store(b.apfState + i, V::select(apfActive, apfOut, apfState));
+    const auto filtered = V::select(apfActive, apfOut, lpf);
+
+    // Damping, sympathetic input, NaN guard, soft clamp
+    auto feedback = V::add(V::mul(filtered, V::load(b.damping + i)), input);
+    feedback = V::select(V::notNan(feedback), feedback, V::zero());
+    if constexpr (Eco) {
+        return fastmath::tanhEco<V>(feedback);
+    } else {
+        return fastmath::tanh<V>(feedback);
+    }
+}
+
+/**
+ * One Karplus-Strong step for every lane
+ *
+ * Same arithmetic as Resonator::process, reorganised as
+ * gather -> vector filter section -> scatter. V supplies the vector type
+ * and its operations for one instruction set.
+ */
+template <class V, bool Eco>
+inline void processBankWith(BankLanes& b) {
+    const int w = b.writePos;
+
+    // Gather: lanes read at different delays, so this stays scalar
+    for (int i = 0; i < b.numLanes; i++) {
+        const float* line = b.lines + b.lineOffset[i];
+        const int mask = b.lineMask[i];
+        const int readPos = (w - b.delayLength[i]) & mask;
+        b.read0[i] = line[readPos];
+        b.read1[i] = line[(readPos - 1) & mask];
+    }
+
+    const auto one = V::set1(1.0f);
+    const auto energyDecay = V::set1(b.energyDecay);
+
+    for (int i = 0; i < b.numLanes; i += V::WIDTH) {
+        const auto s0 = V::load(b.read0 + i);
+        const auto s1 = V::load(b.read1 + i);
+        const auto frac = V::load(b.fractionalDelay + i);
+
+        // Linear interpolation for the fractional delay
+        const auto sample = V::add(V::mul(s0, V::sub(one, frac)), V::mul(s1, frac));
+
+        V::store(b.feedback + i, loopFeedback<V, Eco>(b, i, sample, s0, V::load(b.input + i)));
+
+        // Energy: exponential decay with peak tracking
+        const auto energy = V::max(V::mul(V::load(b.energy + i), energyDecay), V::abs(sample));
+        V::store(b.energy + i, energy);
+        V::store(b.output + i, sample);
+    }
+
+    // Scatter: every lane writes at the shared write position
+    for (int i = 0; i < b.numLanes; i++) {
+        b.lines[b.lineOffset[i] + (w & b.lineMask[i])] = b.feedback[i];
+    }
+}
+
+/**
+ * numSamples loop-filter steps for every lane, on samples read ahead
+ *
+ * The caller has already read each row's output and raw sample from the
+ * delay lines (ResonatorBank::readBlock), so this touches no line memory:
+ * feedback rows go to blockFeedback for the caller to write back.
+ */
+template <class V, bool Eco>
+inline void processBankBlockWith(BankLanes& b) {
+    for (int k = 0; k < b.numSamples; k++) {
+        const int row = k * b.blockStride;
+        for (int i = 0; i < b.numLanes; i += V::WIDTH) {
+            const auto feedback = loopFeedback<V, Eco>(b, i, V::load(b.blockOutput + row + i),
+                                                  V::load(b.blockRead0 + row + i),
+                                                  V::load(b.blockInput + row + i));
+            V::store(b.blockFeedback + row + i, feedback);
+        }
+    }
+}
+
+// The tanh tier is fixed for a whole call
+template <class V>
+inline void processBank(BankLanes& b) {
+    if (b.ecoTanh) {
+        processBankWith<V, true>(b);
+    } else {
+        processBankWith<V, false>(b);
+    }
+}
+
+template <class V>
+inline void processBankBlock(BankLanes& b) {
+    if (b.ecoTanh) {
+        processBankBlockWith<V, true>(b);
+    } else {
+        processBankBlockWith<V, false>(b);
+    }
+}
+
+} // namespace rgs::simd
@@ -0,0 +1,64 @@
+#include "BankKernel.h"
+#include "CpuFeatures.h"
+#include "HalfBandKernel.h"
+#include "ModalKernel.h"
+
+#if RGS_SIMD_X86
+
+#include <immintrin.h>
+
+// Compiled with AVX2 + FMA enabled; only called after detectIsa() agrees
+
+namespace rgs::simd {
+
+namespace {
+
+struct Avx2Ops {
+    using Vec = __m256;
+    using Mask = __m256;
+    static constexpr int WIDTH = 8;
+
+    static Vec load(const float* p) { return _mm256_load_ps(p); }
+    static void store(float* p, Vec v) { _mm256_store_ps(p, v); }
+    static Vec set1(float x) { return _mm256_set1_ps(x); }
+    static Vec zero() { return _mm256_setzero_ps(); }
+
+    static Vec add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+    static Vec sub(Vec a, Vec b) { return _mm256_sub_ps(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+    static Vec div(Vec a, Vec b) { return _mm256_div_ps(a, b); }
+    static Vec madd(Vec a, Vec b, Vec c) { return _mm256_fmadd_ps(a, b, c); }
+    static Vec min(Vec a, Vec b) { return _mm256_min_ps(a, b); }
+    static Vec max(Vec a, Vec b) { return _mm256_max_ps(a, b); }
+    static Vec abs(Vec a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+
+    static Mask greater(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static Mask notNan(Vec a) { return _mm256_cmp_ps(a, a, _CMP_ORD_Q); }
+    static Vec select(Mask m, Vec a, Vec b) { return _mm256_blendv_ps(b, a, m); }
+};
+
+} // namespace
+
+void processBankAvx2(BankLanes& lanes) {
+    processBank<Avx2Ops>(lanes);
+}
+
+void processBankBlockAvx2(BankLanes& lanes) {
+    processBankBlock<Avx2Ops>(lanes);
+}
+
+void processModalAvx2(ModalLanes& lanes) {
+    processModal<Avx2Ops>(lanes);
+}
+
+void decimateAvx2(HalfBandLanes& lanes) {
+    decimateWith<Avx2Ops>(lanes);
+}
+
+void interpolateAvx2(HalfBandLanes& lanes) {
+    interpolateWith<Avx2Ops>(lanes);
+}
+
+} // namespace rgs::simd
+
+#endif
@@ -0,0 +1,64 @@
+#include "BankKernel.h"
+#include "CpuFeatures.h"
+#include "HalfBandKernel.h"
+#include "ModalKernel.h"
+
+#if RGS_SIMD_X86
+
+#include <immintrin.h>
+
+// Compiled with AVX-512F enabled; only called after detectIsa() agrees
+
+namespace rgs::simd {
+
+namespace {
+
+struct Avx512Ops {
+    using Vec = __m512;
+    using Mask = __mmask16;
+    static constexpr int WIDTH = 16;
+
+    static Vec load(const float* p) { return _mm512_load_ps(p); }
+    static void store(float* p, Vec v) { _mm512_store_ps(p, v); }
+    static Vec set1(float x) { return _mm512_set1_ps(x); }
+    static Vec zero() { return _mm512_setzero_ps(); }
+
+    static Vec add(Vec a, Vec b) { return _mm512_add_ps(a, b); }
+    static Vec sub(Vec a, Vec b) { return _mm512_sub_ps(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm512_mul_ps(a, b); }
+    static Vec div(Vec a, Vec b) { return _mm512_div_ps(a, b); }
+    static Vec madd(Vec a, Vec b, Vec c) { return _mm512_fmadd_ps(a, b, c); }
+    static Vec min(Vec a, Vec b) { return _mm512_min_ps(a, b); }
+    static Vec max(Vec a, Vec b) { return _mm512_max_ps(a, b); }
+    static Vec abs(Vec a) { return _mm512_abs_ps(a); }
+
+    static Mask greater(Vec a, Vec b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+    static Mask notNan(Vec a) { return _mm512_cmp_ps_mask(a, a, _CMP_ORD_Q); }
+    static Vec select(Mask m, Vec a, Vec b) { return _mm512_mask_blend_ps(m, b, a); }
+};
+
+} // namespace
+
+void processBankAvx512(BankLanes& lanes) {
+    processBank<Avx512Ops>(lanes);
+}
+
+void processBankBlockAvx512(BankLanes& lanes) {
+    processBankBlock<Avx512Ops>(lanes);
+}
+
+void processModalAvx512(ModalLanes& lanes) {
+    processModal<Avx512Ops>(lanes);
+}
+
+void decimateAvx512(HalfBandLanes& lanes) {
+    decimateWith<Avx512Ops>(lanes);
+}
+
+void interpolateAvx512(HalfBandLanes& lanes) {
+    interpolateWith<Avx512Ops>(lanes);
+}
+
+} // namespace rgs::simd
+
+#endif
@@ -0,0 +1,64 @@
+#include "BankKernel.h"
+#include "CpuFeatures.h"
+#include "HalfBandKernel.h"
+#include "ModalKernel.h"
+
+#if RGS_SIMD_X86
+
+#include <emmintrin.h>
+
+namespace rgs::simd {
+
+namespace {
+
+struct Sse2Ops {
+    using Vec = __m128;
+    using Mask = __m128;
+    static constexpr int WIDTH = 4;
+
+    static Vec load(const float* p) { return _mm_load_ps(p); }
+    static void store(float* p, Vec v) { _mm_store_ps(p, v); }
+    static Vec set1(float x) { return _mm_set1_ps(x); }
+    static Vec zero() { return _mm_setzero_ps(); }
+
+    static Vec add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+    static Vec sub(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+    static Vec div(Vec a, Vec b) { return _mm_div_ps(a, b); }
+    static Vec madd(Vec a, Vec b, Vec c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static Vec min(Vec a, Vec b) { return _mm_min_ps(a, b); }
+    static Vec max(Vec a, Vec b) { return _mm_max_ps(a, b); }
+    static Vec abs(Vec a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+
+    static Mask greater(Vec a, Vec b) { return _mm_cmpgt_ps(a, b); }
+    static Mask notNan(Vec a) { return _mm_cmpord_ps(a, a); }
+    static Vec select(Mask m, Vec a, Vec b) {
+        return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+    }
+};
+
+} // namespace
+
+void processBankSse2(BankLanes& lanes) {
+    processBank<Sse2Ops>(lanes);
+}
+
+void processBankBlockSse2(BankLanes& lanes) {
+    processBankBlock<Sse2Ops>(lanes);
+}
+
+void processModalSse2(ModalLanes& lanes) {
+    processModal<Sse2Ops>(lanes);
+}
+
+void decimateSse2(HalfBandLanes& lanes) {
+    decimateWith<Sse2Ops>(lanes);
+}
+
+void interpolateSse2(HalfBandLanes& lanes) {
+    interpolateWith<Sse2Ops>(lanes);
+}
+
+} // namespace rgs::simd
+
+#endif
@@ -0,0 +1,90 @@
+#include "CpuFeatures.h"
+#include <algorithm>
+#include <atomic>
+
+#if RGS_SIMD_X86 && defined(_MSC_VER)
+    #include <intrin.h>
+    #include <immintrin.h>
+#endif
+
+namespace rgs::simd {
+
+namespace {
+
+std::atomic<Isa> isaLimit { Isa::Avx512 };
+
+#if RGS_SIMD_X86 && defined(_MSC_VER)
+Isa queryCpu() {
+    int info[4] = {};
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    if (!osxsave || maxLeaf < 7) {
+        return Isa::Sse2;
+    }
+
+    // The OS must save the wider register state on context switches
+    const unsigned long long xcr0 = _xgetbv(0);
+    const bool ymmEnabled = (xcr0 & 0x6) == 0x6;
+    const bool zmmEnabled = (xcr0 & 0xe6) == 0xe6;
+
+    __cpuidex(info, 7, 0);
+    const bool avx2 = (info[1] & (1 << 5)) != 0;
+    const bool avx512f = (info[1] & (1 << 16)) != 0;
+
+    if (avx512f && zmmEnabled) return Isa::Avx512;
+    if (avx2 && fma && ymmEnabled) return Isa::Avx2;
+    return Isa::Sse2;
+}
+#elif RGS_SIMD_X86
+Isa queryCpu() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return Isa::Avx512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return Isa::Avx2;
+    return Isa::Sse2;
+}
+#else
+Isa queryCpu() {
+    return Isa::Scalar;
+}
+#endif
+
+} // namespace
+
+Isa detectIsa() {
+    static const Isa detected = queryCpu();
+    return detected;
+}
+
+Isa getActiveIsa() {
+    return std::min(detectIsa(), isaLimit.load(std::memory_order_relaxed));
+}
+
+void setIsaLimit(Isa limit) {
+    isaLimit.store(limit, std::memory_order_relaxed);
+}
+
+const char* getIsaName(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::Sse2:   return "sse2";
+        case Isa::Avx2:   return "avx2";
+        case Isa::Avx512: return "avx512";
+    }
+    return "unknown";
+}
+
+int getIsaWidth(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return 1;
+        case Isa::Sse2:   return 4;
+        case Isa::Avx2:   return 8;
+        case Isa::Avx512: return 16;
+    }
+    return 1;
+}
+
+} // namespace rgs::simd
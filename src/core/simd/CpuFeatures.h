@@ -0,0 +1,40 @@
+#pragma once
+
+// Per-ISA kernels are only built for x86-64 (see CMakeLists.txt); other
+// targets use the portable scalar kernels, which the compiler vectorises.
+#if defined(RGS_X86_KERNELS) && (defined(__x86_64__) || defined(_M_X64))
+    #define RGS_SIMD_X86 1
+#else
+    #define RGS_SIMD_X86 0
+#endif
+
+namespace rgs::simd {
+
+/**
+ * Instruction sets with a dedicated kernel, in increasing order
+ */
+enum class Isa {
+    Scalar,
+    Sse2,    // 4 lanes
+    Avx2,    // 8 lanes (AVX2 + FMA)
+    Avx512   // 16 lanes (AVX-512F)
+};
+
+// Widest instruction set supported by both this build and this CPU
+Isa detectIsa();
+
+// detectIsa() capped by setIsaLimit(), used when picking kernels
+Isa getActiveIsa();
+
+// Cap the kernels picked from now on (benchmarks compare paths with this)
+void setIsaLimit(Isa limit);
+
+const char* getIsaName(Isa isa);
+
+// Number of float lanes processed per instruction
+int getIsaWidth(Isa isa);
+
+// Lane count every SIMD bank is padded to, enough for the widest kernel
+constexpr int MAX_WIDTH = 16;
+
+} // namespace rgs::simd
@@ -0,0 +1,104 @@
+#pragma once
+
+// Included by the per-ISA kernel translation units, under the same rules
+// as BankKernel.h: no standard library calls.
+
+namespace rgs::simd {
+
+constexpr int HALF_BAND_STAGES = 4;
+constexpr int HALF_BAND_STATE_ROWS = 2 + HALF_BAND_STAGES;   // x0, x1, y0 ... y3
+
+// Allpass coefficients, alternating between the two paths (elliptic
+// half-band, transition band 0.21-0.29 of the higher rate)
+constexpr float HALF_BAND_COEFFS[HALF_BAND_STAGES] = {
+    0.0919947238f, 0.3171081174f, 0.5844608270f, 0.8541800687f
+};
+
+/**
+ * Structure-of-arrays view of a half-band filter, one entry per lane
+ *
+ * states holds HALF_BAND_STATE_ROWS rows, stateStride floats apart. A
+ * section after the first of its path takes the previous output of the
+ * one before it as its delayed input, so only the first two keep an x.
+ */
+struct HalfBandLanes {
+    float* states;
+    int stateStride;
+
+    // Decimator: two input rows in, out0 out. Interpolator: in0 in,
+    // out0 and out1 out.
+    const float* in0;
+    const float* in1;
+    float* out0;
+    float* out1;
+
+    int numLanes;
+};
+
+using HalfBandKernel = void (*)(HalfBandLanes&);
+
+void decimateScalar(HalfBandLanes& lanes);
+void decimateSse2(HalfBandLanes& lanes);
+void decimateAvx2(HalfBandLanes& lanes);
+void decimateAvx512(HalfBandLanes& lanes);
+
+void interpolateScalar(HalfBandLanes& lanes);
+void interpolateSse2(HalfBandLanes& lanes);
+void interpolateAvx2(HalfBandLanes& lanes);
+void interpolateAvx512(HalfBandLanes& lanes);
+
+/**
+ * One lower-rate sample of lanes [i, i + WIDTH) through both allpass
+ * paths: a through the even sections, b through the odd ones. Each
+ * section is (c + z^-1) / (1 + c z^-1).
+ */
+template <class V>
+inline void halfBandStep(HalfBandLanes& h, int i, typename V::Vec& a, typename V::Vec& b) {
+    float* x0 = h.states + i;
+    float* x1 = x0 + h.stateStride;
+    float* y0 = x1 + h.stateStride;
+    float* y1 = y0 + h.stateStride;
+    float* y2 = y1 + h.stateStride;
+    float* y3 = y2 + h.stateStride;
+
+    const auto prev0 = V::load(y0);
+    const auto prev1 = V::load(y1);
+    const auto t0 = V::madd(V::sub(a, prev0), V::set1(HALF_BAND_COEFFS[0]), V::load(x0));
+    const auto t1 = V::madd(V::sub(b, prev1), V::set1(HALF_BAND_COEFFS[1]), V::load(x1));
+    const auto t2 = V::madd(V::sub(t0, V::load(y2)), V::set1(HALF_BAND_COEFFS[2]), prev0);
+    const auto t3 = V::madd(V::sub(t1, V::load(y3)), V::set1(HALF_BAND_COEFFS[3]), prev1);
+    V::store(x0, a);
+    V::store(x1, b);
+    V::store(y0, t0);
+    V::store(y1, t1);
+    V::store(y2, t2);
+    V::store(y3, t3);
+    a = t2;
+    b = t3;
+}
+
+// Average of the two paths, the later input row through the even one
+template <class V>
+inline void decimateWith(HalfBandLanes& h) {
+    const auto half = V::set1(0.5f);
+    for (int i = 0; i < h.numLanes; i += V::WIDTH) {
+        auto a = V::load(h.in1 + i);
+        auto b = V::load(h.in0 + i);
+        halfBandStep<V>(h, i, a, b);
+        V::store(h.out0 + i, V::mul(half, V::add(a, b)));
+    }
+}
+
+// The same input through both paths, one output row each
+template <class V>
+inline void interpolateWith(HalfBandLanes& h) {
+    for (int i = 0; i < h.numLanes; i += V::WIDTH) {
+        auto a = V::load(h.in0 + i);
+        auto b = a;
+        halfBandStep<V>(h, i, a, b);
+        V::store(h.out0 + i, a);
+        V::store(h.out1 + i, b);
+    }
+}
+
+} // namespace rgs::simd
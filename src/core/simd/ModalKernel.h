@@ -0,0 +1,123 @@
+#pragma once
+
+#include "../FastMath.h"
+#include "CpuFeatures.h"
+
+// Included by the per-ISA kernel translation units, under the same rules
+// as BankKernel.h: no standard library calls.
+
+namespace rgs::simd {
+
+constexpr int MODAL_MODES = 8;
+
+// Per-mode values, in this order within a tile row group
+enum ModeField { MODE_Y1, MODE_Y2, MODE_A1, MODE_A2, MODE_GAIN, MODE_FIELDS };
+
+// Every field of every mode of MAX_WIDTH consecutive lanes
+constexpr int MODAL_TILE = MODE_FIELDS * MODAL_MODES * MAX_WIDTH;
+
+// Where lane's field of mode lives: a vector of up to MAX_WIDTH lanes
+// from a multiple of its width is contiguous, and so is everything one
+// kernel step touches
+constexpr int modeIndex(int lane, int mode, int field) {
+    return lane / MAX_WIDTH * MODAL_TILE + (mode * MODE_FIELDS + field) * MAX_WIDTH + lane % MAX_WIDTH;
+}
+
+/**
+ * Structure-of-arrays view of a ModalBank, one entry per lane
+ *
+ * Each lane is a node of MODAL_MODES two-pole resonators,
+ *
+ *     y[n] = a1 y[n-1] + a2 y[n-2] + gain (x[n] - a1 / 2 x[n-1])
+ *
+ * whose impulse response r^n cos(n w) starts at its peak. Mode state and
+ * coefficients share one array of tiles (see modeIndex()). Same
+ * alignment and padding as BankLanes; padding lanes and unused modes
+ * have zero coefficients and stay silent.
+ */
+struct ModalLanes {
+    float* modes;
+
+    // Drive for this sample (coupling plus strike)
+    const float* input;
+
+    // What the soft clamp took off each lane's last sample, and the
+    // last sample's drive
+    float* clipped;
+    float* lastDrive;
+
+    // Outputs
+    float* energy;
+    float* output;
+
+    int numLanes;
+    bool ecoTanh;               // fastmath::tanhEco for Quality::Eco
+    float energyDecay;          // Energy meter decay per sample
+};
+
+using ModalKernel = void (*)(ModalLanes&);
+
+void processModalScalar(ModalLanes& lanes);
+void processModalSse2(ModalLanes& lanes);
+void processModalAvx2(ModalLanes& lanes);
+void processModalAvx512(ModalLanes& lanes);
+
+/**
+ * One sample of every mode of every lane
+ *
+ * The node sounds the sum of its modes through the same soft clamp as
+ * the Karplus-Strong loop, and the part the clamp takes off is driven
+ * back into the modes on the next sample, so loud nodes lose level the
+ * way the loop does. A mode that turns NaN is zeroed.
+ */
+template <class V, bool Eco>
+inline void processModalWith(ModalLanes& b) {
+    const auto energyDecay = V::set1(b.energyDecay);
+
+    const auto minusHalf = V::set1(-0.5f);
+
+    for (int i = 0; i < b.numLanes; i += V::WIDTH) {
+        const auto x = V::sub(V::load(b.input + i), V::load(b.clipped + i));
+        const auto lastHalf = V::mul(V::load(b.lastDrive + i), minusHalf);   // -x[n-1] / 2
+        V::store(b.lastDrive + i, x);
+        auto sum = V::zero();
+
+        float* tile = b.modes + modeIndex(i, 0, 0);
+        for (int m = 0; m < MODAL_MODES; m++) {
+            float* row = tile + m * MODE_FIELDS * MAX_WIDTH;
+            const auto y1 = V::load(row + MODE_Y1 * MAX_WIDTH);
+            const auto a1 = V::load(row + MODE_A1 * MAX_WIDTH);
+            const auto drive = V::mul(V::load(row + MODE_GAIN * MAX_WIDTH), V::madd(a1, lastHalf, x));
+            auto y = V::madd(a1, y1, V::madd(V::load(row + MODE_A2 * MAX_WIDTH), V::load(row + MODE_Y2 * MAX_WIDTH), drive));
+            y = V::select(V::notNan(y), y, V::zero());
+            V::store(row + MODE_Y2 * MAX_WIDTH, y1);
+            V::store(row + MODE_Y1 * MAX_WIDTH, y);
+            sum = V::add(sum, y);
+        }
+
+        typename V::Vec sample;
+        if constexpr (Eco) {
+            sample = fastmath::tanhEco<V>(sum);
+        } else {
+            sample = fastmath::tanh<V>(sum);
+        }
+
+        // Energy: exponential decay with peak tracking, as the KS kernel
+        const auto energy = V::max(V::mul(V::load(b.energy + i), energyDecay), V::abs(sample));
+        V::store(b.energy + i, energy);
+        V::store(b.output + i, sample);
+        V::store(b.clipped + i, V::sub(sum, sample));
+    }
+}
+
+// The tanh tier is fixed for a whole call
+template <class V>
+inline void processModal(ModalLanes& b) {
+    if (b.ecoTanh) {
+        processModalWith<V, true>(b);
+    } else {
+        processModalWith<V, false>(b);
+    }
+}
+
+} // namespace rgs::simd
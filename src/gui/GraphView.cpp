@@ -1,14 +1,21 @@
 #include "GraphView.h"
+#include <algorithm>
 #include <cmath>
 
 namespace rgs {
 
-GraphView::GraphView(ResonatorGraph& g) : graph(g) {
+GraphView::GraphView(const ResonatorGraph& g, const TelemetryChannel& t) : graph(g), telemetry(t) {
     setOpaque(false);
+    startTimerHz(ACTIVE_HZ);
+}
+
+GraphView::~GraphView() {
+    stopTimer();
 }
 
 void GraphView::resized() {
     calculateNodePositions();
+    staticLayer = {};
 }
 
 void GraphView::calculateNodePositions() {
@@ -16,11 +23,16 @@ void GraphView::calculateNodePositions() {
     float centerX = bounds.getCentreX();
     float centerY = bounds.getCentreY();
     float radius = std::min(bounds.getWidth(), bounds.getHeight()) * 0.4f;
+    int numNodes = graph.getNumNodes();
 
-    for (int i = 0; i < ResonatorGraph::NUM_NODES; i++) {
-        // Arrange in circle, starting from top (C at 12 o'clock)
+    // Keep neighbouring nodes from overlapping on large graphs
+    nodeRadius = std::min(25.0f, radius * juce::MathConstants<float>::pi / numNodes * 0.8f);
+
+    nodePositions.resize(static_cast<size_t>(numNodes));
+    for (int i = 0; i < numNodes; i++) {
+        // Arrange in circle, starting from top (lowest node at 12 o'clock)
         float angle = -juce::MathConstants<float>::halfPi +
-                      (static_cast<float>(i) / ResonatorGraph::NUM_NODES) *
+                      (static_cast<float>(i) / numNodes) *
                       juce::MathConstants<float>::twoPi;
 
         nodePositions[i] = {
@@ -30,32 +42,109 @@ void GraphView::calculateNodePositions() {
     }
 }
 
-void GraphView::paint(juce::Graphics& g) {
-    auto bounds = getLocalBounds().toFloat();
+void GraphView::timerCallback() {
+    const int numNodes = graph.getNumNodes();
+    const auto n = static_cast<size_t>(numNodes);
+
+    // New layout or edges: the static layer is stale, redraw everything
+    if (drawnEnergy.size() != n || graph.getTopologyVersion() != staticVersion) {
+        if (nodePositions.size() != n) {
+            calculateNodePositions();
+        }
+        drawnEnergy.assign(n, 0.0f);
+        drawnPeak.assign(n, 0.0f);
+        drawnFlows.clear();
+        quietTicks = 0;
+        repaint();
+    }
+
+    // Latest complete block. Nothing lights up until the audio thread
+    // has published one for the current layout.
+    if (!telemetry.read(frame) || frame.numNodes != numNodes) {
+        frame.numNodes = 0;
+        frame.flows.clear();
+    }
+
+    bool changed = false;
+    for (size_t i = 0; i < n; i++) {
+        const float energy = static_cast<int>(i) < frame.numNodes ? frame.energy[i] : 0.0f;
+        const float peak = static_cast<int>(i) < frame.numNodes ? frame.peak[i] : 0.0f;
+        if (std::abs(energy - drawnEnergy[i]) > REDRAW_THRESHOLD || std::abs(peak - drawnPeak[i]) > REDRAW_THRESHOLD) {
+            const float level = std::max({ energy, peak, drawnEnergy[i], drawnPeak[i] });
+            repaint(getNodeArea(static_cast<int>(i), level));
+            drawnEnergy[i] = energy;
+            drawnPeak[i] = peak;
+            changed = true;
+        }
+    }
+
+    // Flows are drawn at amount x 6, so compare on that scale
+    bool flowsChanged = frame.flows.size() != drawnFlows.size();
+    for (size_t f = 0; !flowsChanged && f < drawnFlows.size(); f++) {
+        const auto& a = frame.flows[f];
+        const auto& b = drawnFlows[f];
+        flowsChanged = a.from != b.from || a.to != b.to
+                    || std::abs(a.amount - b.amount) * 6.0f > REDRAW_THRESHOLD;
+    }
+    if (flowsChanged) {
+        repaint(getFlowArea(drawnFlows).getUnion(getFlowArea(frame.flows)));
+        drawnFlows = frame.flows;
+        changed = true;
+    }
+
+    // Slow down while nothing moves; the first change speeds back up
+    quietTicks = changed ? 0 : quietTicks + 1;
+    const int hz = quietTicks < IDLE_TICKS ? ACTIVE_HZ : IDLE_HZ;
+    if (getTimerInterval() != 1000 / hz) {
+        startTimerHz(hz);
+    }
+}
+
+juce::Rectangle<int> GraphView::getNodeArea(int node, float level) const {
+    // Glow and peak ring reach level x 30 beyond the body, plus the stroke
+    const float reach = nodeRadius + level * 30.0f + 2.0f;
+    const auto pos = nodePositions[static_cast<size_t>(node)];
+    return juce::Rectangle<float>(pos.x - reach, pos.y - reach, reach * 2, reach * 2).getSmallestIntegerContainer();
+}
+
+juce::Rectangle<int> GraphView::getFlowArea(const std::vector<TelemetryFrame::Flow>& flows) const {
+    juce::Rectangle<float> area;
+    for (const auto& flow : flows) {
+        const auto line = juce::Rectangle<float>(nodePositions[static_cast<size_t>(flow.from)],
+                                                 nodePositions[static_cast<size_t>(flow.to)]).expanded(3.0f);
+        area = area.isEmpty() ? line : area.getUnion(line);
+    }
+    return area.getSmallestIntegerContainer();
+}
+
+void GraphView::updateStaticLayer(float scale) {
+    const uint32_t version = graph.getTopologyVersion();
+    if (staticLayer.isValid() && scale == staticScale && version == staticVersion) {
+        return;
+    }
+    staticVersion = version;
+    staticScale = scale;
+
+    staticLayer = juce::Image(juce::Image::ARGB,
+                              std::max(1, juce::roundToInt(getWidth() * scale)),
+                              std::max(1, juce::roundToInt(getHeight() * scale)), true);
+    juce::Graphics g(staticLayer);
+    g.addTransform(juce::AffineTransform::scale(scale));
 
     // Background
     g.setColour(juce::Colour(0xff1e293b));
-    g.fillRoundedRectangle(bounds, 10.0f);
+    g.fillRoundedRectangle(getLocalBounds().toFloat(), 10.0f);
 
-    // Get current energies
-    auto energies = graph.getEnergies();
-
-    // Draw connections first (behind nodes)
-    for (int i = 0; i < ResonatorGraph::NUM_NODES; i++) {
-        for (int j = i + 1; j < ResonatorGraph::NUM_NODES; j++) {
-            float coupling = graph.getCoupling(i, j);
+    // Connections, behind the nodes
+    int numNodes = graph.getNumNodes();
+    for (int i = 0; i < numNodes; i++) {
+        for (int j = i + 1; j < numNodes; j++) {
+            float coupling = std::max(graph.getCoupling(i, j), graph.getCoupling(j, i));
             if (coupling > 0.01f) {
                 // Line thickness based on coupling strength
                 float thickness = 1.0f + coupling * 3.0f;
 
-                // Colour based on combined energy
-                float combinedEnergy = (energies[i] + energies[j]) * 0.5f;
-                juce::Colour lineColour = juce::Colour(0xff475569).interpolatedWith(
-                    juce::Colour(0xffa855f7),  // Purple accent
-                    std::min(combinedEnergy * 3.0f, 1.0f)
-                );
-
-                g.setColour(lineColour.withAlpha(0.3f + coupling * 0.5f));
+                g.setColour(juce::Colour(0xff475569).withAlpha(0.3f + coupling * 0.5f));
                 g.drawLine(nodePositions[i].x, nodePositions[i].y,
                           nodePositions[j].x, nodePositions[j].y,
                           thickness);
@@ -63,37 +152,89 @@ void GraphView::paint(juce::Graphics& g) {
         }
     }
 
-    // Draw nodes
-    float nodeRadius = 25.0f;
+    // Every node at rest
+    for (int i = 0; i < numNodes; i++) {
+        drawNode(g, i, 0.0f, 0.0f);
+    }
+}
 
-    for (int i = 0; i < ResonatorGraph::NUM_NODES; i++) {
-        auto pos = nodePositions[i];
-        float energy = energies[i];
+void GraphView::paint(juce::Graphics& g) {
+    int numNodes = graph.getNumNodes();
+    if (static_cast<int>(nodePositions.size()) != numNodes) {
+        calculateNodePositions();
+    }
+
+    updateStaticLayer(g.getInternalContext().getPhysicalPixelScaleFactor());
+    g.drawImage(staticLayer, getLocalBounds().toFloat());
+
+    // The frame timerCallback() read; none yet for this layout
+    if (frame.numNodes != numNodes) {
+        return;
+    }
+
+    // Overlay the edges currently carrying energy. Nodes they cross are
+    // redrawn on top, as they would be without the cache.
+    underFlow.assign(static_cast<size_t>(numNodes), 0);
+    for (const auto& flow : frame.flows) {
+        auto from = nodePositions[static_cast<size_t>(flow.from)];
+        auto to = nodePositions[static_cast<size_t>(flow.to)];
+        float amount = std::min(flow.amount * 6.0f, 1.0f);
 
-        // Node glow based on energy
-        if (energy > 0.01f) {
-            float glowRadius = nodeRadius + energy * 30.0f;
-            juce::Colour glowColour = juce::Colour(0xffa855f7).withAlpha(energy * 0.5f);
-            g.setColour(glowColour);
-            g.fillEllipse(pos.x - glowRadius, pos.y - glowRadius,
-                         glowRadius * 2, glowRadius * 2);
+        g.setColour(juce::Colour(0xffa855f7).withAlpha(0.2f + amount * 0.6f));  // Purple accent
+        g.drawLine(from.x, from.y, to.x, to.y, 1.0f + amount * 3.0f);
+        underFlow[static_cast<size_t>(flow.from)] = 1;
+        underFlow[static_cast<size_t>(flow.to)] = 1;
+    }
+
+    // Only nodes that look different from the cached ones, and only
+    // where this repaint reaches
+    for (int i = 0; i < numNodes; i++) {
+        const float energy = frame.energy[static_cast<size_t>(i)];
+        const float peak = frame.peak[static_cast<size_t>(i)];
+        const float level = std::max(energy, peak);
+        if ((level > IDLE_LEVEL || underFlow[static_cast<size_t>(i)] != 0)
+            && g.clipRegionIntersects(getNodeArea(i, level))) {
+            drawNode(g, i, energy, peak);
         }
+    }
+}
+
+void GraphView::drawNode(juce::Graphics& g, int node, float energy, float peak) {
+    auto pos = nodePositions[static_cast<size_t>(node)];
+
+    // Node glow based on energy
+    if (energy > 0.01f) {
+        float glowRadius = nodeRadius + energy * 30.0f;
+        juce::Colour glowColour = juce::Colour(0xffa855f7).withAlpha(energy * 0.5f);
+        g.setColour(glowColour);
+        g.fillEllipse(pos.x - glowRadius, pos.y - glowRadius,
+                     glowRadius * 2, glowRadius * 2);
+    }
 
-        // Node body
-        juce::Colour nodeColour = getNodeColour(energy);
-        g.setColour(nodeColour);
-        g.fillEllipse(pos.x - nodeRadius, pos.y - nodeRadius,
-                     nodeRadius * 2, nodeRadius * 2);
+    // Node body
+    juce::Colour nodeColour = getNodeColour(energy);
+    g.setColour(nodeColour);
+    g.fillEllipse(pos.x - nodeRadius, pos.y - nodeRadius,
+                 nodeRadius * 2, nodeRadius * 2);
 
-        // Node border
-        g.setColour(juce::Colours::white.withAlpha(0.3f));
-        g.drawEllipse(pos.x - nodeRadius, pos.y - nodeRadius,
-                     nodeRadius * 2, nodeRadius * 2, 2.0f);
+    // Node border
+    g.setColour(juce::Colours::white.withAlpha(0.3f));
+    g.drawEllipse(pos.x - nodeRadius, pos.y - nodeRadius,
+                 nodeRadius * 2, nodeRadius * 2, 2.0f);
 
-        // Note name
+    // Peak-hold ring
+    if (peak > 0.01f) {
+        float peakRadius = nodeRadius + peak * 30.0f;
+        g.setColour(juce::Colour(0xffa855f7).withAlpha(0.6f));
+        g.drawEllipse(pos.x - peakRadius, pos.y - peakRadius,
+                     peakRadius * 2, peakRadius * 2, 1.0f);
+    }
+
+    // Note name (skipped once nodes are too small to hold it)
+    if (nodeRadius >= 10.0f) {
         g.setColour(juce::Colours::white);
-        g.setFont(14.0f);
-        g.drawText(NOTE_NAMES[i],
+        g.setFont(std::min(14.0f, nodeRadius * 0.6f));
+        g.drawText(getNodeLabel(node),
                   static_cast<int>(pos.x - nodeRadius),
                   static_cast<int>(pos.y - 8),
                   static_cast<int>(nodeRadius * 2),
@@ -102,6 +243,17 @@ void GraphView::paint(juce::Graphics& g) {
     }
 }
 
+juce::String GraphView::getNodeLabel(int node) const {
+    int note = graph.getNodeNote(node);
+    juce::String name(NOTE_NAMES[((note % 12) + 12) % 12]);
+
+    // Folded graphs show pitch classes; keyboard graphs need the octave
+    if (!graph.getLayout().foldOctaves) {
+        name << (note / 12 - 1);
+    }
+    return name;
+}
+
 juce::Colour GraphView::getNodeColour(float energy) const {
     // Interpolate from dark (no energy) to bright purple (full energy)
     juce::Colour darkColour(0xff334155);
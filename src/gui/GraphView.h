@@ -2,7 +2,8 @@
 
 #include <juce_gui_basics/juce_gui_basics.h>
 #include "../core/ResonatorGraph.h"
-#include <array>
+#include "../core/Telemetry.h"
+#include <vector>
 
 namespace rgs {
 
@@ -10,20 +11,54 @@ namespace rgs {
  * Visual representation of the resonator graph
  *
  * Shows nodes arranged in a circle with connections between them.
- * Node brightness indicates energy level.
+ * Node brightness indicates energy level. Nodes shrink to fit when the
+ * graph spans more than one octave.
+ *
+ * Energies come from the telemetry channel, never from the live graph,
+ * so every repaint shows one complete audio block.
+ *
+ * The background, edges and idle nodes are drawn once into an image,
+ * rebuilt only on resize, a layout change or a topology change
+ * (ResonatorGraph::getTopologyVersion). The view polls telemetry on its
+ * own timer and repaints only the nodes whose energy or peak moved more
+ * than REDRAW_THRESHOLD, plus the area of the energy flows when they
+ * change. It polls at ACTIVE_HZ while anything moves and drops to
+ * IDLE_HZ after IDLE_TICKS quiet polls.
  */
-class GraphView : public juce::Component {
+class GraphView : public juce::Component, private juce::Timer {
 public:
-    explicit GraphView(ResonatorGraph& graph);
+    static constexpr int ACTIVE_HZ = 30;
+    static constexpr int IDLE_HZ = 10;
+    static constexpr int IDLE_TICKS = 30;
+    static constexpr float REDRAW_THRESHOLD = 0.01f;
+    static constexpr float IDLE_LEVEL = 0.005f;   // Drawn as the cached idle node
+
+    GraphView(const ResonatorGraph& graph, const TelemetryChannel& telemetry);
+    ~GraphView() override;
 
     void paint(juce::Graphics& g) override;
     void resized() override;
 
 private:
-    ResonatorGraph& graph;
+    const ResonatorGraph& graph;
+    const TelemetryChannel& telemetry;
+    TelemetryFrame frame;
+
+    // Node positions (calculated on resize or when the node count changes)
+    std::vector<juce::Point<float>> nodePositions;
+    float nodeRadius = 25.0f;
+
+    // Background, edges and idle nodes, at the display's pixel scale
+    juce::Image staticLayer;
+    float staticScale = 0.0f;
+    uint32_t staticVersion = 0;
 
-    // Node positions (calculated on resize)
-    std::array<juce::Point<float>, ResonatorGraph::NUM_NODES> nodePositions;
+    // What the last repaint of each node showed
+    std::vector<float> drawnEnergy;
+    std::vector<float> drawnPeak;
+    std::vector<TelemetryFrame::Flow> drawnFlows;
+    std::vector<uint8_t> underFlow;   // paint() scratch
+    int quietTicks = 0;
 
     // Note names for display
     static constexpr const char* NOTE_NAMES[12] = {
@@ -31,7 +66,13 @@ private:
         "F#", "G", "G#", "A", "A#", "B"
     };
 
+    void timerCallback() override;
     void calculateNodePositions();
+    void updateStaticLayer(float scale);
+    void drawNode(juce::Graphics& g, int node, float energy, float peak);
+    juce::Rectangle<int> getNodeArea(int node, float level) const;
+    juce::Rectangle<int> getFlowArea(const std::vector<TelemetryFrame::Flow>& flows) const;
+    juce::String getNodeLabel(int node) const;
     juce::Colour getNodeColour(float energy) const;
 };
 
@@ -0,0 +1,63 @@
+#include "ProfileOverlay.h"
+
+namespace rgs {
+
+ProfileOverlay::ProfileOverlay(profiling::Profiler& p) : profiler(p) {
+    setOpaque(false);
+}
+
+void ProfileOverlay::refresh() {
+    stats = profiler.getStats();
+    repaint();
+}
+
+void ProfileOverlay::mouseUp(const juce::MouseEvent&) {
+    profiler.reset();
+}
+
+void ProfileOverlay::paint(juce::Graphics& g) {
+    auto bounds = getLocalBounds().toFloat();
+    g.setColour(juce::Colour(0xe0020617));
+    g.fillRoundedRectangle(bounds, 6.0f);
+
+    auto area = getLocalBounds().reduced(10, 8);
+    g.setFont(juce::Font(juce::Font::getDefaultMonospacedFontName(), 12.0f, juce::Font::plain));
+
+    if (!profiling::ENABLED) {
+        g.setColour(juce::Colours::white.withAlpha(0.7f));
+        g.drawText("Built without RGS_PROFILING", area, juce::Justification::centred);
+        return;
+    }
+
+    // Load bar: last block, with the peak as a tick. Red past 70 %.
+    const auto load = static_cast<float>(stats.loadPercent);
+    const auto peak = static_cast<float>(stats.peakLoadPercent);
+    g.setColour(juce::Colours::white);
+    g.drawText(juce::String::formatted("DSP %5.1f %%  peak %5.1f %%  overruns %llu",
+                                       load, peak, static_cast<unsigned long long>(stats.overruns)),
+               area.removeFromTop(16), juce::Justification::left);
+
+    auto bar = area.removeFromTop(8).toFloat();
+    g.setColour(juce::Colour(0xff1e293b));
+    g.fillRect(bar);
+    g.setColour(load > 70.0f ? juce::Colour(0xffef4444) : juce::Colour(0xff22c55e));
+    g.fillRect(bar.withWidth(bar.getWidth() * juce::jlimit(0.0f, 1.0f, load / 100.0f)));
+    g.setColour(juce::Colours::white);
+    g.fillRect(bar.getX() + bar.getWidth() * juce::jlimit(0.0f, 1.0f, peak / 100.0f) - 1.0f,
+               bar.getY(), 2.0f, bar.getHeight());
+    area.removeFromTop(6);
+
+    // Microseconds per block
+    g.setColour(juce::Colours::white.withAlpha(0.6f));
+    g.drawText("phase        mean     p99     max  (us)", area.removeFromTop(16), juce::Justification::left);
+    g.setColour(juce::Colours::white);
+    for (int p = 0; p < profiling::NUM_PHASES; p++) {
+        const auto& phase = stats.phases[static_cast<size_t>(p)];
+        g.drawText(juce::String::formatted("%-10s %7.1f %7.1f %7.1f",
+                                           profiling::getPhaseName(static_cast<profiling::Phase>(p)),
+                                           phase.meanNs * 1e-3, phase.p99Ns * 1e-3, phase.maxNs * 1e-3),
+                   area.removeFromTop(15), juce::Justification::left);
+    }
+}
+
+} // namespace rgs
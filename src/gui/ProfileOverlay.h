@@ -0,0 +1,31 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "../core/Profiler.h"
+
+namespace rgs {
+
+/**
+ * DSP load and per-phase block times, drawn over the graph view
+ *
+ * Reads the processor's Profiler (lock-free) on every refresh(): load
+ * against the block deadline as a bar, then mean / p99 / max per phase.
+ * Clicking it clears the histograms. Without RGS_PROFILING it only says
+ * so.
+ */
+class ProfileOverlay : public juce::Component {
+public:
+    explicit ProfileOverlay(profiling::Profiler& profiler);
+
+    // Re-read the stats and repaint
+    void refresh();
+
+    void paint(juce::Graphics& g) override;
+    void mouseUp(const juce::MouseEvent& event) override;
+
+private:
+    profiling::Profiler& profiler;
+    profiling::Profiler::Stats stats;
+};
+
+} // namespace rgs
@@ -0,0 +1,234 @@
+#include "MidiFile.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace rgs {
+
+namespace {
+
+// Big-endian reads over one chunk; a read past the end sets failed and
+// returns zeros, so parsing can check once per event
+struct ByteReader {
+    const uint8_t* pos;
+    const uint8_t* end;
+    bool failed = false;
+
+    bool atEnd() const { return pos >= end; }
+
+    uint8_t byte() {
+        if (pos >= end) {
+            failed = true;
+            return 0;
+        }
+        return *pos++;
+    }
+
+    uint32_t bigEndian(int numBytes) {
+        uint32_t value = 0;
+        for (int i = 0; i < numBytes; i++) {
+            value = (value << 8) | byte();
+        }
+        return value;
+    }
+
+    // Variable-length quantity: seven bits a byte, at most four bytes
+    uint32_t variableLength() {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; i++) {
+            const uint8_t b = byte();
+            value = (value << 7) | (b & 0x7f);
+            if ((b & 0x80) == 0) {
+                return value;
+            }
+        }
+        failed = true;
+        return 0;
+    }
+
+    void skip(uint32_t count) {
+        if (count > static_cast<size_t>(end - pos)) {
+            failed = true;
+            pos = end;
+            return;
+        }
+        pos += count;
+    }
+};
+
+struct TickEvent {
+    uint64_t tick;
+    int track;
+    int order;        // Within the track
+    bool on;
+    int note;
+    int velocity;
+    int channel;
+};
+
+struct TempoChange {
+    uint64_t tick;
+    uint32_t microsPerQuarter;
+};
+
+constexpr uint32_t DEFAULT_TEMPO = 500000;   // 120 BPM
+
+bool readFile(const std::string& path, std::vector<uint8_t>& data) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    uint8_t buffer[65536];
+    size_t count;
+    while ((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + count);
+    }
+    const bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+    return ok;
+}
+
+} // namespace
+
+bool MidiFile::read(const std::string& path, std::string& error) {
+    notes.clear();
+    lengthSeconds = 0.0;
+
+    std::vector<uint8_t> data;
+    if (!readFile(path, data)) {
+        error = "cannot read " + path;
+        return false;
+    }
+
+    ByteReader file { data.data(), data.data() + data.size() };
+    if (file.bigEndian(4) != 0x4d546864) {   // "MThd"
+        error = path + " is not a Standard MIDI File";
+        return false;
+    }
+    const uint32_t headerLength = file.bigEndian(4);
+    const uint32_t format = file.bigEndian(2);
+    const uint32_t numTracks = file.bigEndian(2);
+    const uint32_t division = file.bigEndian(2);
+    file.skip(headerLength > 6 ? headerLength - 6 : 0);
+    if (file.failed || headerLength < 6 || format > 2 || division == 0) {
+        error = path + ": bad header";
+        return false;
+    }
+
+    std::vector<TickEvent> events;
+    std::vector<TempoChange> tempos;
+    uint64_t lastTick = 0;
+
+    for (uint32_t track = 0; track < numTracks && !file.atEnd();) {
+        const uint32_t chunkType = file.bigEndian(4);
+        const uint32_t chunkLength = file.bigEndian(4);
+        if (file.failed || chunkLength > static_cast<size_t>(file.end - file.pos)) {
+            error = path + ": truncated track " + std::to_string(track);
+            return false;
+        }
+        ByteReader chunk { file.pos, file.pos + chunkLength };
+        file.skip(chunkLength);
+
+        // Unknown chunks are skipped, as the format asks
+        if (chunkType != 0x4d54726b) {   // "MTrk"
+            continue;
+        }
+
+        uint64_t tick = 0;
+        uint8_t status = 0;
+        int order = 0;
+        while (!chunk.atEnd() && !chunk.failed) {
+            tick += chunk.variableLength();
+            lastTick = std::max(lastTick, tick);
+
+            uint8_t first = chunk.byte();
+            if (first == 0xff) {
+                const uint8_t type = chunk.byte();
+                const uint32_t length = chunk.variableLength();
+                if (type == 0x51 && length == 3) {
+                    tempos.push_back({ tick, chunk.bigEndian(3) });
+                } else {
+                    chunk.skip(length);
+                }
+                if (type == 0x2f) {
+                    break;   // End of track
+                }
+                continue;
+            }
+            if (first == 0xf0 || first == 0xf7) {
+                chunk.skip(chunk.variableLength());   // SysEx
+                continue;
+            }
+
+            // Running status: a data byte reuses the last channel status
+            uint8_t data1;
+            if (first & 0x80) {
+                status = first;
+                data1 = chunk.byte();
+            } else if (status != 0) {
+                data1 = first;
+            } else {
+                chunk.failed = true;
+                break;
+            }
+
+            const int kind = status >> 4;
+            const int channel = status & 0x0f;
+            if (kind == 0xc || kind == 0xd) {
+                continue;   // One data byte
+            }
+            const uint8_t data2 = chunk.byte();
+
+            if (kind == 0x9 || kind == 0x8) {
+                const bool on = kind == 0x9 && data2 > 0;
+                events.push_back({ tick, static_cast<int>(track), order++, on, data1 & 0x7f, data2 & 0x7f, channel });
+            }
+        }
+
+        if (chunk.failed) {
+            error = path + ": bad event data in track " + std::to_string(track);
+            return false;
+        }
+        track++;
+    }
+
+    std::stable_sort(events.begin(), events.end(), [](const TickEvent& a, const TickEvent& b) {
+        if (a.tick != b.tick) return a.tick < b.tick;
+        if (a.track != b.track) return a.track < b.track;
+        return a.order < b.order;
+    });
+    std::stable_sort(tempos.begin(), tempos.end(),
+                     [](const TempoChange& a, const TempoChange& b) { return a.tick < b.tick; });
+
+    // Ticks to seconds, integrating over the tempo map. Called with
+    // ticks in ascending order, so it walks the map once.
+    size_t nextTempo = 0;
+    uint64_t segmentTick = 0;
+    double segmentMicros = 0.0;
+    uint32_t tempo = DEFAULT_TEMPO;
+    auto seconds = [&](uint64_t tick) {
+        if (division & 0x8000) {
+            // SMPTE: frames per second (negative byte) x ticks per frame
+            const int fps = -static_cast<int8_t>(division >> 8);
+            const double rate = (fps == 29 ? 29.97 : fps) * (division & 0xff);
+            return static_cast<double>(tick) / rate;
+        }
+
+        for (; nextTempo < tempos.size() && tempos[nextTempo].tick < tick; nextTempo++) {
+            segmentMicros += static_cast<double>(tempos[nextTempo].tick - segmentTick) * tempo;
+            segmentTick = tempos[nextTempo].tick;
+            tempo = tempos[nextTempo].microsPerQuarter;
+        }
+        const double micros = segmentMicros + static_cast<double>(tick - segmentTick) * tempo;
+        return micros * 1e-6 / division;
+    };
+
+    notes.reserve(events.size());
+    for (const auto& event : events) {
+        notes.push_back({ seconds(event.tick), event.on, event.note,
+                          event.on ? event.velocity / 127.0f : 0.0f, event.channel });
+    }
+    lengthSeconds = seconds(lastTick);
+    return true;
+}
+
+} // namespace rgs
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rgs {
+
+/**
+ * Note events of a Standard MIDI File, timed in seconds
+ *
+ * Reads formats 0 and 1 (and 2, with its tracks laid over each other),
+ * with tempo changes from any track applied to all of them, as a
+ * conductor track is meant to be. SMPTE divisions are timed directly.
+ * Only note-ons and note-offs are kept; a note-on at velocity 0 is a
+ * note-off.
+ *
+ * Events come out sorted by time. Events at the same tick keep the order
+ * of their tracks, then of the file, so a release and a re-strike of the
+ * same note on one tick stay in the order they were written.
+ */
+class MidiFile {
+public:
+    struct Note {
+        double seconds;
+        bool on;
+        int note;
+        float velocity;   // 0-1, note-ons only
+        int channel;      // 0-15
+    };
+
+    // False with a reason in error if the file cannot be read or is not
+    // a Standard MIDI File
+    bool read(const std::string& path, std::string& error);
+
+    const std::vector<Note>& getNotes() const { return notes; }
+
+    // Time of the last event of any kind (end of track included)
+    double getLengthSeconds() const { return lengthSeconds; }
+
+private:
+    std::vector<Note> notes;
+    double lengthSeconds = 0.0;
+};
+
+} // namespace rgs
@@ -0,0 +1,387 @@
+/**
+ * rgs_render: offline MIDI file to WAV renderer
+ *
+ * Plays Standard MIDI Files through a VoiceManager, as the plugin would,
+ * and writes stereo WAV at full speed. Each file is a job; jobs render in
+ * parallel (--jobs, default one per hardware thread), each on its own
+ * engine and thread, and never share state.
+ *
+ * Notes land on their own sample: event times are rounded once to sample
+ * positions and split into --block sized blocks with offsets. After the
+ * last event the render runs on until every voice has gone to sleep, or
+ * for --tail seconds at most.
+ *
+ * Output is deterministic: the same file, settings, rate and block size
+ * give the same bytes on the same machine, whatever --jobs is. (The SIMD
+ * kernel is chosen from the CPU, so another machine may differ in the
+ * last bits; --isa pins it.)
+ *
+ * --state FILE applies synth settings to every file (see RenderSettings).
+ * --write-state FILE converts them to the plugin's binary state
+ * (SynthState), which --state and the plugin both load.
+ * --batch LIST reads jobs from a file, one "input.mid [state] [output.wav]"
+ * per line, '#' starting a comment; a job without a state uses --state.
+ * Outputs default to the input's name with .wav, in --out-dir if given.
+ *
+ * --bits picks 32-bit float (the default, which keeps anything over full
+ * scale) or 16/24-bit PCM, which clips there.
+ *
+ * Progress and throughput go to stderr: per job and overall, audio seconds
+ * rendered per wall second ("x40 realtime"), and each job's peak level.
+ *
+ * --trace FILE writes a Chrome trace of the renders (Trace.h), one
+ * process per job.
+ *
+ * Usage: rgs_render [--state FILE] [--write-state FILE] [--batch LIST] [--out-dir DIR] [--jobs N]
+ *                   [--rate SR] [--block N] [--tail S] [--bits 16|24|32]
+ *                   [--isa scalar|sse2|avx2|avx512] [--trace FILE] [file.mid ...]
+ */
+
+#include "core/Denormals.h"
+#include "core/NoteEvent.h"
+#include "core/Trace.h"
+#include "core/VoiceManager.h"
+#include "core/simd/CpuFeatures.h"
+#include "render/MidiFile.h"
+#include "render/RenderSettings.h"
+#include "render/WavWriter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string statePath;
+    std::string batchPath;
+    std::string outDir;
+    std::string tracePath;
+    std::string writeStatePath;
+    std::vector<std::string> inputs;
+    int jobs = 0;   // 0: one per hardware thread
+    int sampleRate = 48000;
+    int blockSize = 512;
+    double tailSeconds = 30.0;
+    int bits = 32;
+};
+
+struct Job {
+    std::string input;
+    std::string state;
+    std::string output;
+};
+
+struct JobResult {
+    bool ok = false;
+    std::string error;
+    double audioSeconds = 0.0;
+    double wallSeconds = 0.0;
+    float peak = 0.0f;
+};
+
+// input.mid -> DIR/input.wav (or input.wav next to it)
+std::string defaultOutput(const std::string& input, const std::string& outDir) {
+    std::string name = input;
+    const auto dot = name.find_last_of('.');
+    const auto slash = name.find_last_of("/\\");
+    if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+        name.erase(dot);
+    }
+    name += ".wav";
+    if (outDir.empty()) {
+        return name;
+    }
+    if (slash != std::string::npos) {
+        name.erase(0, slash + 1);
+    }
+    return outDir + "/" + name;
+}
+
+bool readBatch(const Options& options, std::vector<Job>& jobs) {
+    std::ifstream file(options.batchPath);
+    if (!file) {
+        std::fprintf(stderr, "rgs_render: cannot read %s\n", options.batchPath.c_str());
+        return false;
+    }
+
+    std::string line;
+    for (int number = 1; std::getline(file, line); number++) {
+        std::istringstream fields(line.substr(0, line.find('#')));
+        Job job;
+        if (!(fields >> job.input)) {
+            continue;
+        }
+        fields >> job.state >> job.output;
+        std::string extra;
+        if (fields >> extra) {
+            std::fprintf(stderr, "rgs_render: %s:%d: too many fields\n", options.batchPath.c_str(), number);
+            return false;
+        }
+        if (job.state.empty() || job.state == "-") {
+            job.state = options.statePath;
+        }
+        if (job.output.empty()) {
+            job.output = defaultOutput(job.input, options.outDir);
+        }
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+JobResult render(const Job& job, const Options& options, rgs::profiling::Tracer& tracer, int track) {
+    JobResult result;
+
+    rgs::MidiFile midi;
+    rgs::RenderSettings settings;
+    if (!midi.read(job.input, result.error)
+        || (!job.state.empty() && !settings.read(job.state, result.error))) {
+        return result;
+    }
+
+    const auto start = Clock::now();
+
+    rgs::VoiceManager voices;
+    settings.apply(voices, options.sampleRate, options.blockSize);
+    if (tracer.isRecording()) {
+        tracer.setTrack(track, job.input, options.sampleRate);
+        voices.setTracer(&tracer, track);
+    }
+
+    rgs::WavWriter wav;
+    if (!wav.open(job.output, options.sampleRate, options.bits, result.error)) {
+        return result;
+    }
+
+    // Sample positions, rounded once so block size cannot move a note
+    const auto& notes = midi.getNotes();
+    std::vector<int64_t> positions(notes.size());
+    for (size_t i = 0; i < notes.size(); i++) {
+        positions[i] = std::llround(notes[i].seconds * options.sampleRate);
+    }
+    // The file's end, and at least one sample past its last note event,
+    // which End of Track may share
+    int64_t lastEvent = std::llround(midi.getLengthSeconds() * options.sampleRate);
+    if (!positions.empty()) {
+        lastEvent = std::max(lastEvent, *std::max_element(positions.begin(), positions.end()) + 1);
+    }
+    const int64_t tailEnd = lastEvent + std::llround(options.tailSeconds * options.sampleRate);
+
+    std::vector<float> left(static_cast<size_t>(options.blockSize));
+    std::vector<float> right(static_cast<size_t>(options.blockSize));
+    std::vector<rgs::NoteEvent> events;
+
+    size_t next = 0;
+    int64_t blockStart = 0;
+    while (next < notes.size() || blockStart < lastEvent
+           || (blockStart < tailEnd && voices.getNumActiveVoices() > 0)) {
+        const int numSamples = static_cast<int>(std::min<int64_t>(options.blockSize, tailEnd - blockStart));
+
+        events.clear();
+        for (; next < notes.size() && positions[next] < blockStart + numSamples; next++) {
+            const auto& note = notes[next];
+            const int offset = static_cast<int>(positions[next] - blockStart);
+            events.push_back(note.on ? rgs::NoteEvent::noteOn(offset, note.note, note.velocity)
+                                     : rgs::NoteEvent::noteOff(offset, note.note));
+        }
+
+        voices.processBlock(left.data(), right.data(), numSamples, events.data(),
+                            static_cast<int>(events.size()));
+        for (int i = 0; i < numSamples; i++) {
+            result.peak = std::max({ result.peak, std::abs(left[i]), std::abs(right[i]) });
+        }
+        if (!wav.write(left.data(), right.data(), numSamples)) {
+            break;
+        }
+        blockStart += numSamples;
+    }
+
+    if (!wav.close(result.error)) {
+        return result;
+    }
+
+    result.wallSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    result.audioSeconds = static_cast<double>(wav.getNumFrames()) / options.sampleRate;
+    result.ok = true;
+    return result;
+}
+
+bool parseArgs(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(arg, "--state") == 0 && hasValue) {
+            options.statePath = argv[++i];
+        } else if (std::strcmp(arg, "--write-state") == 0 && hasValue) {
+            options.writeStatePath = argv[++i];
+        } else if (std::strcmp(arg, "--batch") == 0 && hasValue) {
+            options.batchPath = argv[++i];
+        } else if (std::strcmp(arg, "--out-dir") == 0 && hasValue) {
+            options.outDir = argv[++i];
+        } else if (std::strcmp(arg, "--jobs") == 0 && hasValue) {
+            options.jobs = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--rate") == 0 && hasValue) {
+            options.sampleRate = std::clamp(std::atoi(argv[++i]), 8000, 384000);
+        } else if (std::strcmp(arg, "--block") == 0 && hasValue) {
+            options.blockSize = std::clamp(std::atoi(argv[++i]), 1, 8192);
+        } else if (std::strcmp(arg, "--tail") == 0 && hasValue) {
+            options.tailSeconds = std::max(0.0, std::atof(argv[++i]));
+        } else if (std::strcmp(arg, "--bits") == 0 && hasValue) {
+            options.bits = std::atoi(argv[++i]);
+            if (options.bits != 16 && options.bits != 24 && options.bits != 32) {
+                std::fprintf(stderr, "rgs_render: unsupported bit depth %d\n", options.bits);
+                return false;
+            }
+        } else if (std::strcmp(arg, "--trace") == 0 && hasValue) {
+            options.tracePath = argv[++i];
+        } else if (std::strcmp(arg, "--isa") == 0 && hasValue) {
+            std::string isa = argv[++i];
+            bool found = false;
+            for (auto candidate : { rgs::simd::Isa::Scalar, rgs::simd::Isa::Sse2,
+                                    rgs::simd::Isa::Avx2, rgs::simd::Isa::Avx512 }) {
+                if (isa == rgs::simd::getIsaName(candidate)) {
+                    rgs::simd::setIsaLimit(candidate);
+                    found = true;
+                }
+            }
+            if (!found) {
+                std::fprintf(stderr, "rgs_render: unknown isa '%s'\n", isa.c_str());
+                return false;
+            }
+        } else if (arg[0] != '-') {
+            options.inputs.push_back(arg);
+        } else {
+            std::fprintf(stderr,
+                "usage: rgs_render [--state FILE] [--write-state FILE] [--batch LIST] [--out-dir DIR] [--jobs N]\n"
+                "                  [--rate SR] [--block N] [--tail S] [--bits 16|24|32]\n"
+                "                  [--isa scalar|sse2|avx2|avx512] [--trace FILE] [file.mid ...]\n");
+            return false;
+        }
+    }
+
+    if (options.inputs.empty() && options.batchPath.empty() && options.writeStatePath.empty()) {
+        std::fprintf(stderr, "rgs_render: nothing to render (give MIDI files or --batch)\n");
+        return false;
+    }
+    return true;
+}
+
+bool writeState(const Options& options) {
+    rgs::RenderSettings settings;
+    std::string error;
+    if (!options.statePath.empty() && !settings.read(options.statePath, error)) {
+        std::fprintf(stderr, "rgs_render: %s\n", error.c_str());
+        return false;
+    }
+
+    std::vector<uint8_t> blob;
+    settings.state.write(blob);
+    std::ofstream file(options.writeStatePath, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(blob.data()), static_cast<std::streamsize>(blob.size()));
+    if (!file) {
+        std::fprintf(stderr, "rgs_render: cannot write %s\n", options.writeStatePath.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        return 2;
+    }
+
+    if (!options.writeStatePath.empty() && !writeState(options)) {
+        return 1;
+    }
+
+    std::vector<Job> jobs;
+    for (const auto& input : options.inputs) {
+        jobs.push_back({ input, options.statePath, defaultOutput(input, options.outDir) });
+    }
+    if (!options.batchPath.empty() && !readBatch(options, jobs)) {
+        return 1;
+    }
+
+    if (jobs.empty() && !options.writeStatePath.empty()) {
+        return 0;   // Only --write-state
+    }
+
+    const int hardware = static_cast<int>(std::thread::hardware_concurrency());
+    const int numThreads = std::min(options.jobs > 0 ? options.jobs : std::max(1, hardware),
+                                    static_cast<int>(jobs.size()));
+
+    rgs::profiling::Tracer tracer;
+    if (!options.tracePath.empty()) {
+        std::string error;
+        if (!tracer.start(options.tracePath, error)) {
+            std::fprintf(stderr, "rgs_render: %s\n", error.c_str());
+            return 1;
+        }
+    }
+
+    // Threads take the next job until none are left; results keep job order
+    std::vector<JobResult> results(jobs.size());
+    std::atomic<size_t> nextJob { 0 };
+    auto worker = [&] {
+        rgs::ScopedFlushDenormals noDenormals;
+        for (size_t j; (j = nextJob.fetch_add(1)) < jobs.size();) {
+            results[j] = render(jobs[j], options, tracer, static_cast<int>(j));
+            const auto& r = results[j];
+            if (r.ok) {
+                std::fprintf(stderr, "%s -> %s  %.2f s in %.2f s  x%.1f realtime  peak %.1f dBFS%s\n",
+                             jobs[j].input.c_str(), jobs[j].output.c_str(), r.audioSeconds, r.wallSeconds,
+                             r.audioSeconds / std::max(r.wallSeconds, 1e-9),
+                             20.0 * std::log10(std::max(r.peak, 1e-9f)),
+                             r.peak > 1.0f && options.bits < 32 ? " (clipped)" : "");
+            } else {
+                std::fprintf(stderr, "rgs_render: %s\n", r.error.c_str());
+            }
+        }
+    };
+
+    const auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 1; t < numThreads; t++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const double wallSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if (tracer.isRecording()) {
+        tracer.stop();
+        if (tracer.getDropped() > 0) {
+            std::fprintf(stderr, "rgs_render: trace ring overflowed, %llu records dropped\n",
+                         static_cast<unsigned long long>(tracer.getDropped()));
+        }
+    }
+
+    int failed = 0;
+    double audioSeconds = 0.0;
+    for (const auto& r : results) {
+        failed += r.ok ? 0 : 1;
+        audioSeconds += r.audioSeconds;
+    }
+    std::fprintf(stderr, "%zu jobs on %d threads: %.2f s of audio in %.2f s, x%.1f realtime%s\n",
+                 jobs.size(), numThreads, audioSeconds, wallSeconds,
+                 audioSeconds / std::max(wallSeconds, 1e-9),
+                 failed > 0 ? (", " + std::to_string(failed) + " failed").c_str() : "");
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,160 @@
+#include "RenderSettings.h"
+#include "core/Presets.h"
+#include "core/VoiceManager.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+namespace rgs {
+
+namespace {
+
+std::string trim(const std::string& text) {
+    const auto first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos) {
+        return {};
+    }
+    const auto last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+}
+
+// The whole value must be a number
+bool parseNumber(const std::string& text, float low, float high, float& value) {
+    char* end = nullptr;
+    const double parsed = std::strtod(text.c_str(), &end);
+    if (end == text.c_str() || *end != '\0' || !std::isfinite(parsed)) {
+        return false;
+    }
+    value = std::clamp(static_cast<float>(parsed), low, high);
+    return true;
+}
+
+template <typename T, size_t N>
+bool parseChoice(const std::string& text, const char* const (&names)[N], const T (&choices)[N], T& value) {
+    for (size_t i = 0; i < N; i++) {
+        if (text == names[i]) {
+            value = choices[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parse(RenderSettings& settings, const std::string& key, const std::string& value) {
+    auto& state = settings.state;
+    if (key == "damping") {
+        return parseNumber(value, 0.9f, 0.9999f, state.damping);
+    }
+    if (key == "brightness") {
+        return parseNumber(value, 0.0f, 1.0f, state.brightness);
+    }
+    if (key == "coupling") {
+        return parseNumber(value, 0.0f, 1.0f, state.coupling);
+    }
+    if (key == "hardness") {
+        return parseNumber(value, 0.0f, 1.0f, state.exciter.hardness);
+    }
+    if (key == "position") {
+        return parseNumber(value, 0.1f, 0.9f, state.exciter.position);
+    }
+    if (key == "voices") {
+        float voices = 0.0f;
+        if (!parseNumber(value, 1.0f, static_cast<float>(VoiceManager::MAX_VOICES), voices)
+            || voices != static_cast<float>(static_cast<int>(voices))) {
+            return false;
+        }
+        state.voices = static_cast<int>(voices);
+        return true;
+    }
+    if (key == "topology") {
+        const char* const names[] = { "chromatic", "fifths", "tonnetz", "harmonic" };
+        const Topology choices[] = { Topology::Chromatic, Topology::Fifths, Topology::Tonnetz,
+                                     Topology::Harmonic };
+        return parseChoice(value, names, choices, state.topology);
+    }
+    if (key == "exciter") {
+        const char* const names[] = { "pluck", "strike" };
+        const Exciter::Type choices[] = { Exciter::Type::Pluck, Exciter::Type::Strike };
+        return parseChoice(value, names, choices, state.exciter.type);
+    }
+    if (key == "quality") {
+        const char* const names[] = { "eco", "normal", "reference" };
+        const fastmath::Quality choices[] = { fastmath::Quality::Eco, fastmath::Quality::Normal,
+                                              fastmath::Quality::Reference };
+        return parseChoice(value, names, choices, state.quality);
+    }
+    if (key == "layout") {
+        const char* const names[] = { "octave", "piano", "midi" };
+        const GraphLayout choices[] = { GraphLayout::octave(), GraphLayout::piano(), GraphLayout::fullMidi() };
+        return parseChoice(value, names, choices, state.layout);
+    }
+    if (key == "engine") {
+        const char* const names[] = { "scalar", "simd", "block", "multirate", "modal" };
+        const Engine choices[] = { Engine::Scalar, Engine::Simd, Engine::Block, Engine::MultiRate,
+                                   Engine::Modal };
+        return parseChoice(value, names, choices, settings.engine);
+    }
+    if (key == "preset") {
+        float index = 0.0f;
+        return parseNumber(value, -1.0f, static_cast<float>(presets::getNumPresets()), index)
+            && index == static_cast<float>(static_cast<int>(index))
+            && presets::makePreset(static_cast<int>(index), state.layout, state);
+    }
+    return false;
+}
+
+} // namespace
+
+bool RenderSettings::read(const std::string& path, std::string& error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "cannot read " + path;
+        return false;
+    }
+    const std::vector<char> contents { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+
+    if (SynthState::isState(contents.data(), contents.size())) {
+        if (!state.read(contents.data(), contents.size())) {
+            error = path + ": bad or newer state";
+            return false;
+        }
+        return true;
+    }
+
+    std::istringstream text(std::string(contents.begin(), contents.end()));
+    std::string line;
+    for (int number = 1; std::getline(text, line); number++) {
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+
+        const auto equals = line.find('=');
+        const std::string key = trim(line.substr(0, equals));
+        const std::string value = equals != std::string::npos ? trim(line.substr(equals + 1)) : "";
+        if (!parse(*this, key, value)) {
+            error = path + ":" + std::to_string(number) + ": bad setting '" + line + "'";
+            return false;
+        }
+    }
+    return true;
+}
+
+void RenderSettings::apply(VoiceManager& voiceManager, double sampleRate, int maxBlockSize) const {
+    // Set before prepare(), which starts the ramps at their targets
+    voiceManager.setEngine(engine);
+    voiceManager.setQuality(state.quality);
+    voiceManager.setPatch(state.topology, state.patch);
+    voiceManager.setDamping(state.damping);
+    voiceManager.setBrightness(state.brightness);
+    voiceManager.setGlobalCoupling(state.coupling);
+    voiceManager.setExciter(state.exciter);
+    voiceManager.prepare(sampleRate, state.layout, maxBlockSize);
+    voiceManager.setMaxActiveVoices(state.voices);
+}
+
+} // namespace rgs
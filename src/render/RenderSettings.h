@@ -0,0 +1,51 @@
+#pragma once
+
+#include "core/ResonatorGraph.h"
+#include "core/SynthState.h"
+#include <string>
+
+namespace rgs {
+
+class VoiceManager;
+
+/**
+ * Synth settings for an offline render, read from a state file
+ *
+ * A file starting like a SynthState blob (the plugin's saved state) is
+ * read as one. Otherwise it is text: one "key = value" per line, '#'
+ * starting a comment, applied in order. Keys
+ * are the plugin's parameter IDs, with choices spelt out in lower case;
+ * anything left out keeps the plugin's default:
+ *
+ *     damping = 0.997          # 0.9-0.9999
+ *     brightness = 0.7         # 0-1
+ *     coupling = 0.3           # 0-1
+ *     topology = fifths        # chromatic|fifths|tonnetz|harmonic
+ *     exciter = pluck          # pluck|strike
+ *     hardness = 0.5           # 0-1
+ *     position = 0.5           # 0.1-0.9
+ *     voices = 8               # 1-16
+ *     quality = normal         # eco|normal|reference
+ *     layout = octave          # octave|piano|midi
+ *     engine = simd            # scalar|simd|block|multirate|modal
+ *     preset = 2               # 0-4, the plugin's programs
+ *
+ * preset replaces every setting but the engine and the layout read so
+ * far with that program for the layout, so it goes after layout and
+ * before anything it should not override. engine is not a plugin
+ * parameter; the plugin always runs simd. Values
+ * out of range are clamped as the plugin's parameters would be. Unknown
+ * keys and values are errors, so a typo never renders with a default.
+ */
+struct RenderSettings {
+    SynthState state;
+    Engine engine = Engine::Simd;
+
+    // Settings over the defaults; false with the file and line in error
+    bool read(const std::string& path, std::string& error);
+
+    // Prepare voices with these settings. Allocates.
+    void apply(VoiceManager& voiceManager, double sampleRate, int maxBlockSize) const;
+};
+
+} // namespace rgs
@@ -0,0 +1,142 @@
+#include "WavWriter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace rgs {
+
+namespace {
+
+constexpr int NUM_CHANNELS = 2;
+
+// RIFF and data sizes are 32 bits
+constexpr uint64_t MAX_DATA_BYTES = 0xffffffffu - 64;
+
+void appendLittleEndian(std::string& out, uint32_t value, int numBytes) {
+    for (int i = 0; i < numBytes; i++) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+// Round to nearest and clip, so full scale never wraps
+int32_t toInteger(float sample, int bits) {
+    const double scale = static_cast<double>(1 << (bits - 1));
+    const double value = std::nearbyint(static_cast<double>(sample) * scale);
+    return static_cast<int32_t>(std::clamp(value, -scale, scale - 1.0));
+}
+
+bool isFloat(int bits) { return bits == 32; }
+
+// fmt chunk: float data needs the extended form and a fact chunk. Stereo
+// frames are an even number of bytes, so data never needs a pad byte.
+std::string header(int sampleRate, int bits, uint64_t numFrames) {
+    const uint32_t bytesPerFrame = static_cast<uint32_t>(NUM_CHANNELS * bits / 8);
+    const auto dataBytes = static_cast<uint32_t>(numFrames * bytesPerFrame);
+    const uint32_t fmtBytes = isFloat(bits) ? 18 : 16;
+    const uint32_t factBytes = isFloat(bits) ? 12 : 0;
+
+    std::string out;
+    out += "RIFF";
+    appendLittleEndian(out, 4 + (8 + fmtBytes) + factBytes + (8 + dataBytes), 4);
+    out += "WAVE";
+
+    out += "fmt ";
+    appendLittleEndian(out, fmtBytes, 4);
+    appendLittleEndian(out, isFloat(bits) ? 3 : 1, 2);   // IEEE float or PCM
+    appendLittleEndian(out, NUM_CHANNELS, 2);
+    appendLittleEndian(out, static_cast<uint32_t>(sampleRate), 4);
+    appendLittleEndian(out, static_cast<uint32_t>(sampleRate) * bytesPerFrame, 4);
+    appendLittleEndian(out, bytesPerFrame, 2);
+    appendLittleEndian(out, static_cast<uint32_t>(bits), 2);
+    if (isFloat(bits)) {
+        appendLittleEndian(out, 0, 2);   // No extension
+        out += "fact";
+        appendLittleEndian(out, 4, 4);
+        appendLittleEndian(out, static_cast<uint32_t>(numFrames), 4);
+    }
+
+    out += "data";
+    appendLittleEndian(out, dataBytes, 4);
+    return out;
+}
+
+} // namespace
+
+WavWriter::~WavWriter() {
+    if (file != nullptr) {
+        std::fclose(file);
+    }
+}
+
+bool WavWriter::open(const std::string& filePath, int rate, int bitsPerSample, std::string& error) {
+    if (bitsPerSample != 16 && bitsPerSample != 24 && bitsPerSample != 32) {
+        error = "unsupported bit depth " + std::to_string(bitsPerSample);
+        return false;
+    }
+
+    path = filePath;
+    bits = bitsPerSample;
+    numFrames = 0;
+    failed = false;
+    sampleRate = rate;
+
+    file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        error = "cannot write " + path;
+        return false;
+    }
+
+    const std::string placeholder = header(sampleRate, bits, 0);
+    failed = std::fwrite(placeholder.data(), 1, placeholder.size(), file) != placeholder.size();
+    return true;
+}
+
+bool WavWriter::write(const float* left, const float* right, int numSamples) {
+    if (file == nullptr || failed) {
+        return false;
+    }
+
+    const uint64_t bytesPerFrame = static_cast<uint64_t>(NUM_CHANNELS * bits / 8);
+    if ((numFrames + static_cast<uint64_t>(numSamples)) * bytesPerFrame > MAX_DATA_BYTES) {
+        failed = true;
+        return false;
+    }
+
+    scratch.clear();
+    for (int i = 0; i < numSamples; i++) {
+        for (float sample : { left[i], right[i] }) {
+            if (isFloat(bits)) {
+                uint32_t word;
+                std::memcpy(&word, &sample, sizeof(word));
+                appendLittleEndian(scratch, word, 4);
+            } else {
+                appendLittleEndian(scratch, static_cast<uint32_t>(toInteger(sample, bits)), bits / 8);
+            }
+        }
+    }
+
+    failed = std::fwrite(scratch.data(), 1, scratch.size(), file) != scratch.size();
+    numFrames += static_cast<uint64_t>(numSamples);
+    return !failed;
+}
+
+bool WavWriter::close(std::string& error) {
+    if (file == nullptr) {
+        return !failed;
+    }
+
+    if (!failed) {
+        const std::string patched = header(sampleRate, bits, numFrames);
+        failed = std::fseek(file, 0, SEEK_SET) != 0
+              || std::fwrite(patched.data(), 1, patched.size(), file) != patched.size();
+    }
+
+    failed = std::fclose(file) != 0 || failed;
+    file = nullptr;
+    if (failed) {
+        error = "write failed: " + path;
+    }
+    return !failed;
+}
+
+} // namespace rgs
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace rgs {
+
+/**
+ * Streams a stereo WAV file to disk a block at a time
+ *
+ * open() writes the header with the sizes left at zero and close()
+ * patches them once the length is known, so a render never holds more
+ * than one block in memory.
+ *
+ * 16- and 24-bit PCM round to nearest and clip at full scale, without
+ * dither: the same samples always give the same bytes, so renders can be
+ * compared with cmp. 32 bits writes IEEE floats unchanged.
+ */
+class WavWriter {
+public:
+    WavWriter() = default;
+    ~WavWriter();
+
+    WavWriter(const WavWriter&) = delete;
+    WavWriter& operator=(const WavWriter&) = delete;
+
+    // bitsPerSample: 16, 24 or 32 (float). False with a reason in error.
+    bool open(const std::string& path, int sampleRate, int bitsPerSample, std::string& error);
+
+    bool write(const float* left, const float* right, int numSamples);
+
+    // Patches the header and closes the file; false if any write failed
+    bool close(std::string& error);
+
+    uint64_t getNumFrames() const { return numFrames; }
+
+private:
+    FILE* file = nullptr;
+    std::string path;
+    int sampleRate = 0;
+    int bits = 16;
+    uint64_t numFrames = 0;
+    bool failed = false;
+
+    // Interleaved bytes of one call to write()
+    std::string scratch;
+};
+
+} // namespace rgs